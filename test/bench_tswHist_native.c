@@ -0,0 +1,137 @@
+/*
+ * bench_tswHist_native.c - Native replay benchmark of recorded workloads
+ *
+ *   Replays the call mix of a workload log written by the recorder (see
+ *   tswHist_record.h): for every distinct call shape (mode, n_bins, win_len,
+ *   stride, input_len, n_channels), an input with the recorded value
+ *   statistics is synthesized and the matching pure C engine is timed. The
+ *   report lists, per shape, the number of recorded calls, their mean
+ *   recorded wall time and the replayed one, and the totals weighted by the
+ *   number of calls, so that an optimization can be compared against the
+ *   production mix. Modes without a pure C engine taking the same arguments
+ *   are replayed as 'hist'. Run with:
+ *     make bench-native RECORD_LOG=/path/to/log
+ *
+ *   See also: tswHist_record.h, test_tswHist_native.c
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "tswHist.h"
+#include "tswHist_robust.h"
+#include "tswHist_threshold.h"
+#include "tswHist_pooled.h"
+#include "tswHist_exact.h"
+#include "tswHist_record.h"
+
+#define BENCH_REPEATS 3 // replays per shape, the fastest is kept
+
+// Whether two records have the same call shape
+static int sameShape(const tswHistRecord *a, const tswHistRecord *b) {
+    return strncmp(a->mode, b->mode, sizeof(a->mode)) == 0 && a->n_bins == b->n_bins
+        && a->win_len == b->win_len && a->stride == b->stride
+        && a->input_len == b->input_len && a->n_channels == b->n_channels;
+}
+
+// Runs the engine of the recorded mode, returns the name of the replayed mode
+static const char *replay(const tswHistRecord *rec, const double *x, double *out, double *loci, double *edges) {
+    size_t len = rec->input_len, n_bins = rec->n_bins, win_len = rec->win_len, stride = rec->stride;
+    double median = 0.5;
+    if (strcmp(rec->mode, "robust") == 0) {
+        tswHistRobust(x, len, n_bins, win_len, stride, 0.1, out, loci, edges);
+        return "robust";
+    } else if (strcmp(rec->mode, "otsu") == 0 || strcmp(rec->mode, "minerror") == 0) {
+        tswHistThreshold(x, len, n_bins, win_len, stride,
+                         (strcmp(rec->mode, "otsu") == 0) ? TSWHIST_THRESHOLD_OTSU : TSWHIST_THRESHOLD_MINERROR,
+                         out, NULL, loci, edges);
+        return rec->mode;
+    } else if (strcmp(rec->mode, "pooled") == 0) {
+        tswHistPooled(x, len, rec->n_channels, n_bins, win_len, stride, out, loci, edges);
+        return "pooled";
+    } else if (strcmp(rec->mode, "exact") == 0) {
+        tswHistExact(x, len, win_len, stride, &median, 1, out, loci);
+        return "exact";
+    }
+    tswHist(x, len, n_bins, win_len, stride, out, loci, edges);
+    return "hist";
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        printf("Usage: %s workload_log\n", argv[0]);
+        return 1;
+    }
+    tswHistRecord *recs;
+    size_t n_recs = tswHistRecordRead(argv[1], &recs);
+    if (n_recs == 0) {
+        printf("No record in %s.\n", argv[1]);
+        return 1;
+    }
+
+    printf("%-10s %8s %8s %6s %10s %4s %7s %12s %12s %7s\n", "mode", "n_bins", "win_len", "stride",
+           "input_len", "ch", "calls", "recorded(s)", "replayed(s)", "ratio");
+    double total_recorded = 0, total_replayed = 0;
+    unsigned char *done = (unsigned char *)calloc(n_recs, 1);
+    for (size_t r = 0; r < n_recs; ++r) {
+        if (done[r])
+            continue;
+        const tswHistRecord *rec = &recs[r];
+        size_t calls = 0;
+        double recorded = 0;
+        for (size_t s = r; s < n_recs; ++s) {
+            if (!done[s] && sameShape(rec, &recs[s])) {
+                done[s] = 1;
+                calls++;
+                recorded += recs[s].wall_time;
+            }
+        }
+        if (rec->win_len == 0 || rec->stride == 0 || rec->win_len > rec->input_len || rec->n_bins == 0)
+            continue; // shape without windows
+
+        // Synthetic input and outputs large enough for every engine
+        size_t total = rec->input_len * rec->n_channels;
+        size_t num_windows = tswHistNumWindows(rec->input_len, rec->win_len, rec->stride);
+        size_t rows = (rec->n_bins > TSWHIST_ROBUST_NSTATS) ? rec->n_bins : TSWHIST_ROBUST_NSTATS;
+        double *x     = (double *)malloc(total * sizeof(double));
+        double *out   = (double *)malloc(rows * num_windows * sizeof(double));
+        double *loci  = (double *)malloc(num_windows * sizeof(double));
+        double *edges = (double *)malloc((rec->n_bins + 1) * sizeof(double));
+        if (!x || !out || !loci || !edges) {
+            printf("%-10s: not enough memory, skipped\n", rec->mode);
+        } else {
+            tswHistRecordSynthesize(rec, x, total, r + 1);
+            const char *mode = rec->mode;
+            double replayed = INFINITY;
+            for (int k = 0; k < BENCH_REPEATS; ++k) {
+                double t_start = tswHistRecordNow();
+                mode = replay(rec, x, out, loci, edges);
+                double t = tswHistRecordNow() - t_start;
+                if (t < replayed)
+                    replayed = t;
+            }
+            printf("%-10s %8llu %8llu %6llu %10llu %4llu %7zu %12.6f %12.6f %7.2f\n", mode,
+                   (unsigned long long)rec->n_bins, (unsigned long long)rec->win_len,
+                   (unsigned long long)rec->stride, (unsigned long long)rec->input_len,
+                   (unsigned long long)rec->n_channels, calls, recorded / calls, replayed,
+                   replayed * calls / recorded);
+            total_recorded += recorded;
+            total_replayed += replayed * calls;
+        }
+        free(x); free(out); free(loci); free(edges);
+    }
+    printf("Total: %zu calls, recorded %.4f s, replayed %.4f s (ratio %.2f)\n",
+           n_recs, total_recorded, total_replayed, total_replayed / total_recorded);
+    free(done);
+    free(recs);
+    return 0;
+}
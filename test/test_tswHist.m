@@ -8,7 +8,7 @@
 % Example:
 %   run test_tswHist
 %
-% Other m-files required: tswHist.m, tswHist_mx (MEX), hist_int_mx (MEX), tswHist_mx_c (MEX)
+% Other m-files required: tswHist.m, tswHist_mx (MEX), hist_int_mx (MEX), tswHist_mx_c (MEX), tswHist_bins_mx (MEX)
 % Subfunctions: none
 % MAT-files required: none
 %
@@ -101,6 +101,208 @@ assert(isequal(edges_custmx, histcounts_edges), 'Edges do not match between cust
 assert(isequal(edges_fullmx, histcounts_edges), 'Edges do not match between full MX and exhaustive computation.');
 assert(isequal(edges_mx_c, histcounts_edges), 'Edges do not match between MEX C and exhaustive computation.');
 
+% Few bins and long strides: bit-plane engine of the MEX functions
+histMat_few = tswHist_mx(x, 8, win_len, 100);
+assert(isequal(histMat_few, tswHist(x, 8, win_len, 100)), 'Bit-plane histograms do not match tswHist.');
+assert(isequal(tswHist_mx_c(x, 8, win_len, 100), histMat_few), 'Bit-plane histograms of MEX C do not match.');
+
+% Batched bin updates across strides and bin distributions (build with
+% SIMDFLAGS="-march=native -DTSWHIST_BATCH_KERNEL=2" or =1 to time the
+% AVX-512 or AVX2 kernels against the scalar one)
+dists = {x, 0.5 + 0.02 * (x - 0.5), 0.5 * ones(size(x))}; % spread, narrow, constant
+dist_names = {'spread', 'narrow', 'constant'};
+for d = 1:length(dists)
+    for batch_stride = [1 4 16 64 256]
+        histMat_batch = tswHist_mx(dists{d}, n_bins, win_len, batch_stride);
+        assert(isequal(histMat_batch, tswHist(dists{d}, n_bins, win_len, batch_stride)), 'Batched bin updates do not match tswHist.');
+        fprintf('Batch, %-8s stride %3d: tswHist_mx %.4f s\n', dist_names{d}, batch_stride, ...
+            timeit(@() tswHist_mx(dists{d}, n_bins, win_len, batch_stride)));
+    end
+end
+
+% Segments: windows restarted at every segment, gaps skipped
+segments = [1 30000; 30001 30500; 31001 100000];
+[histMat_seg, windows_loci_seg, ~, segment_ids_seg] = tswHist(x, n_bins, win_len, stride, [], segments);
+[histMat_seg_mx, windows_loci_seg_mx, ~, segment_ids_seg_mx] = tswHist_mx(x, n_bins, win_len, stride, 'segments', segments);
+[histMat_seg_mx_c, windows_loci_seg_mx_c, ~, segment_ids_seg_mx_c] = tswHist_mx_c(x, n_bins, win_len, stride, segments);
+for i = 1:length(windows_loci_seg)
+    idx = windows_loci_seg(i):(windows_loci_seg(i)+win_len-1);
+    assert(all(idx >= segments(segment_ids_seg(i), 1) & idx <= segments(segment_ids_seg(i), 2)), 'Window crosses a segment bound.');
+    assert(isequal(histMat_seg(:, i), histcounts(x(idx), histcounts_edges)'), 'Segment histograms do not match exhaustive computation.');
+end
+assert(isequal(histMat_seg_mx, histMat_seg) && isequal(histMat_seg_mx_c, histMat_seg), 'MEX segment histograms do not match.');
+assert(isequal(windows_loci_seg_mx, windows_loci_seg) && isequal(windows_loci_seg_mx_c, windows_loci_seg), 'MEX segment loci do not match.');
+assert(isequal(segment_ids_seg_mx, segment_ids_seg) && isequal(segment_ids_seg_mx_c, segment_ids_seg), 'MEX segment ids do not match.');
+starts = [1; 30001; 31001]; % start indices as a column vector
+[histMat_starts, windows_loci_starts] = tswHist(x, n_bins, win_len, stride, [], starts);
+assert(isequal(histMat_starts, tswHist_mx(x, n_bins, win_len, stride, 'segments', starts')) && ...
+       isequal(windows_loci_starts, tswHist(x, n_bins, win_len, stride, [], starts')), 'Column vector segment starts do not match.');
+
+% Adaptive stride: coarse windows plus backfilled ones around a level shift
+x_shift = [0.5 * x(1:50000), 0.5 + 0.5 * x(50001:end)];
+[histMat_ad, windows_loci_ad, ~, stat_ad] = tswHist_mx(x_shift, n_bins, win_len, 100, 'adaptive', 'tail', [0.02 5 0.75]);
+assert(all(diff(windows_loci_ad) > 0) && all(ismember(1:100:length(x)-win_len+1, windows_loci_ad)), 'Adaptive windows miss coarse windows.');
+assert(any(mod(windows_loci_ad - 1, 100) ~= 0), 'Adaptive windows are not refined around the level shift.');
+for i = 1:length(windows_loci_ad)
+    idx = windows_loci_ad(i):(windows_loci_ad(i)+win_len-1);
+    assert(isequal(histMat_ad(:, i), histcounts(x_shift(idx), histcounts_edges)'), 'Adaptive histograms do not match exhaustive computation.');
+    assert(abs(stat_ad(i) - sum(histMat_ad(floor(0.75 * n_bins)+1:end, i)) / win_len) <= 1e-12, 'Adaptive tail mass does not match.');
+end
+
+% Phase-folded histograms over revolutions of variable lengths
+phase = 0.3 + cumsum(1 ./ (110 + 20 * sin((1:length(x)) / 3000)));
+n_phase = 12;
+[histMat_ph, windows_loci_ph] = tswHist_mx(x, n_bins, 20, 5, 'phase', phase, n_phase);
+rev_starts = find([true, diff(floor(phase)) > 0]);
+rev_starts(end+1) = length(x) + 1;
+phase_bin = min(floor(mod(phase, 1) * n_phase), n_phase - 1) + 1;
+for i = 1:size(histMat_ph, 3)
+    assert(windows_loci_ph(i) == rev_starts(1 + (i-1) * 5), 'Phase-folded loci do not match the revolutions.');
+    idx = windows_loci_ph(i):(rev_starts(1 + (i-1) * 5 + 20) - 1);
+    for p = 1:n_phase
+        assert(isequal(histMat_ph(p, :, i), histcounts(x(idx(phase_bin(idx) == p)), histcounts_edges)), 'Phase-folded histograms do not match exhaustive computation.');
+    end
+end
+quantMat_ph = tswHist_mx(x, n_bins, 20, 5, 'phase', phase, [n_phase 0.5]);
+assert(isequal(size(quantMat_ph), [n_phase 1 size(histMat_ph, 3)]), 'Phase-folded quantiles have a wrong size.');
+for i = 1:size(histMat_ph, 3)
+    idx = windows_loci_ph(i):(rev_starts(1 + (i-1) * 5 + 20) - 1);
+    for p = 1:n_phase
+        assert(abs(quantMat_ph(p, 1, i) - median(x(idx(phase_bin(idx) == p)))) <= 1 / n_bins, 'Phase-folded medians do not match.');
+    end
+end
+
+% Codebook: nearest prototype of every window
+prototypes = histMat_ref(:, round(linspace(1, size(histMat_ref, 2), 8)));
+codeMat = tswHist_mx(x, n_bins, win_len, stride, 'codebook', prototypes);
+[dist_ref, idx_ref] = min(pdist2(histMat_ref', prototypes').^2, [], 2);
+assert(all(abs(codeMat(2, :) - dist_ref') <= 1e-9 * max(1, dist_ref')), 'Codebook distances do not match exhaustive computation.');
+assert(all(codeMat(1, :) == idx_ref' | abs(dist_ref' - sum((histMat_ref - prototypes(:, codeMat(1, :))).^2, 1)) <= 1e-9 * max(1, dist_ref')), 'Codebook assignments do not match exhaustive computation.');
+
+% Exact quantiles of the raw values, against movmedian and prctile
+y = randn(1, 100000);
+probs = [0.1 0.5 0.9];
+[quantMat, windows_loci_exact] = tswHist_mx(y, n_bins, win_len, stride, 'exact', probs);
+median_ref = movmedian(y, [0 win_len-1], 'Endpoints', 'discard');
+assert(isequal(windows_loci_exact, windows_loci_bt), 'Exact quantile window loci do not match.');
+assert(isequal(quantMat(2, :), median_ref(1:stride:end)), 'Exact medians do not match movmedian.');
+for i = 1:97:length(windows_loci_exact)
+    idx = windows_loci_exact(i):(windows_loci_exact(i)+win_len-1);
+    assert(max(abs(quantMat(:, i)' - prctile(y(idx), 100 * probs))) <= 1e-12, 'Exact quantiles do not match prctile.');
+end
+fprintf('Exact medians   : tswHist_mx %.4f s, movmedian %.4f s\n', ...
+    timeit(@() tswHist_mx(y, n_bins, win_len, stride, 'exact')), ...
+    timeit(@() movmedian(y, [0 win_len-1], 'Endpoints', 'discard')));
+
+% Tiny windows (sorted-window engine) against movmedian, and crossover with
+% the histogram median of the robust mode (stride 1)
+y_norm = (y - min(y)) / (max(y) - min(y));
+for tiny_len = [3 8 16 32 64 128 256]
+    quant_tiny = tswHist_mx(y, n_bins, tiny_len, 1, 'exact');
+    assert(isequal(quant_tiny, movmedian(y, [0 tiny_len-1], 'Endpoints', 'discard')), 'Tiny-window medians do not match movmedian.');
+    fprintf('Median, win %3d : exact %.4f s, histogram %.4f s\n', tiny_len, ...
+        timeit(@() tswHist_mx(y, n_bins, tiny_len, 1, 'exact')), ...
+        timeit(@() tswHist_mx(y_norm, n_bins, tiny_len, 1, 'robust')));
+end
+
+% GLCM texture features of sliding patches, against graycomatrix/graycoprops
+n_levels = 8;
+img_int = randi(n_levels, 200, 300) - 1;                   % gray levels 0..n_levels-1
+img = (img_int + 0.5) / n_levels;                          % normalized, binned back to img_int
+offsets = [0 1; -1 1; -1 0; -1 -1];
+patch = [31 41]; patch_stride = [7 5];
+[featMat, row_loci, col_loci] = tswHist_glcm_mx(img, n_levels, patch, patch_stride, offsets, true);
+names = {'Contrast', 'Correlation', 'Energy', 'Homogeneity'};
+for i = 1:5:length(row_loci)
+    for j = 1:7:length(col_loci)
+        P = img_int(row_loci(i):row_loci(i)+patch(1)-1, col_loci(j):col_loci(j)+patch(2)-1) + 1;
+        props = graycoprops(graycomatrix(P, 'NumLevels', n_levels, 'GrayLimits', [1 n_levels], ...
+                                         'Offset', offsets, 'Symmetric', true));
+        for k = 1:4
+            assert(max(abs(featMat(k, :, i, j) - props.(names{k}))) <= 1e-9, ['GLCM ' names{k} ' does not match graycoprops.']);
+        end
+    end
+end
+fprintf('GLCM features   : tswHist_glcm_mx %.4f s\n', ...
+    timeit(@() tswHist_glcm_mx(img, n_levels, patch, patch_stride, offsets, true)));
+
+% Integral histogram: histograms of arbitrary rectangles, untiled and tiled
+img = rand(480, 640);
+rects = [randi(600, 1000, 1), randi(440, 1000, 1), randi(40, 1000, 2)]; % [x y width height]
+histMat_int = tswHist_integral_mx(img, n_bins, rects);
+for k = 1:37:size(rects, 1)
+    patch = img(rects(k, 2):rects(k, 2)+rects(k, 4)-1, rects(k, 1):rects(k, 1)+rects(k, 3)-1);
+    assert(isequal(histMat_int(:, k), histcounts(patch(:), histcounts_edges)'), 'Integral histograms do not match exhaustive computation.');
+end
+assert(isequal(tswHist_integral_mx(img, n_bins, rects, 15), histMat_int), 'Tiled (uint8) integral histograms do not match.');
+assert(isequal(tswHist_integral_mx(img, n_bins, rects, 64), histMat_int), 'Tiled (uint16) integral histograms do not match.');
+fprintf('Integral hist.  : %d rectangles, tswHist_integral_mx %.4f s\n', size(rects, 1), ...
+    timeit(@() tswHist_integral_mx(img, n_bins, rects)));
+
+% Stream manager: 50k low-rate streams updated by batches of (id, sample)
+n_streams = 50000; stream_win = 64; batch = 200000; n_batches = 20;
+tswHist_streams_mx('init', n_streams, n_bins, stream_win);
+ids_all = randi(n_streams, batch, n_batches);
+vals_all = rand(batch, n_batches);
+tic;
+for t = 1:n_batches
+    tswHist_streams_mx('update', ids_all(:, t), vals_all(:, t));
+end
+elapsed = toc;
+check_ids = [1 777 n_streams];
+[histMat_streams, n_samples] = tswHist_streams_mx('hist', check_ids);
+for k = 1:length(check_ids)
+    vals = vals_all(ids_all == check_ids(k)); % column-major: arrival order
+    vals = vals(max(1, end-stream_win+1):end);
+    assert(n_samples(k) == length(vals), 'Stream window lengths do not match.');
+    assert(isequal(histMat_streams(:, k), histcounts(vals, histcounts_edges)'), 'Stream histograms do not match exhaustive computation.');
+end
+tswHist_streams_mx('clear');
+fprintf('Stream manager  : %d streams, %.2e updates/s\n', n_streams, batch * n_batches / elapsed);
+
+% JIT kernels: compile cost against the steady-state gain of the kernels
+% specialized for each parameter set (needs a system C compiler, the
+% generic kernel is used otherwise)
+jit_dir = tempname();
+jit_bins = 64;
+for jit_stride = [1 16 128]
+    setenv('TSWHIST_JIT_DIR', '');
+    histMat_gen = tswHist_mx(x, jit_bins, win_len, jit_stride);
+    t_gen = timeit(@() tswHist_mx(x, jit_bins, win_len, jit_stride));
+    setenv('TSWHIST_JIT_DIR', jit_dir);
+    tic;
+    histMat_jit = tswHist_mx(x, jit_bins, win_len, jit_stride); % plan: compile and load
+    t_plan = toc;
+    t_jit = timeit(@() tswHist_mx(x, jit_bins, win_len, jit_stride));
+    assert(isequal(histMat_jit, histMat_gen), 'JIT histograms do not match the generic kernel.');
+    fprintf('JIT stride %4d : compile+run %.4f s, generic %.4f s, jit %.4f s (x%.2f)\n', ...
+        jit_stride, t_plan, t_gen, t_jit, t_gen / t_jit);
+end
+setenv('TSWHIST_JIT_DIR', '');
+if exist(jit_dir, 'dir'), rmdir(jit_dir, 's'); end
+
+% Workload recorder: one record per call, replayed by make bench-native
+record_log = [tempname() '.log'];
+setenv('TSWHIST_RECORD_LOG', record_log);
+histMat_rec = tswHist_mx(x, n_bins, win_len, stride);
+tswHist_mx(x, n_bins, win_len, stride, 'robust');
+tswHist_mx_c(x, n_bins, win_len, stride);
+setenv('TSWHIST_RECORD_LOG', '');
+log_info = dir(record_log);
+delete(record_log);
+assert(isequal(histMat_rec, histMat_ref), 'Recorded histograms do not match exhaustive computation.');
+assert(log_info.bytes == 3 * 400, 'The workload log must hold one record per call.');
+
+% Binned-index file: same histograms without the binning stage
+bin_file = [tempname() '.tswb'];
+tswHist_bins_mx(bin_file, x, n_bins, [min(x) max(x)]);
+[histMat_file_mx, windows_loci_file_mx, edges_file_mx] = tswHist_mx(bin_file, [], win_len, stride);
+[histMat_file, windows_loci_file] = tswHist(bin_file, n_bins, win_len, stride);
+delete(bin_file);
+assert(isequal(histMat_file_mx, histMat_ref) && isequal(histMat_file, histMat_ref), 'Binned-index file histograms do not match exhaustive computation.');
+assert(isequal(windows_loci_file_mx, windows_loci_bt) && isequal(windows_loci_file, windows_loci_bt), 'Binned-index file window loci do not match.');
+assert(isequal(edges_file_mx, histcounts_edges), 'Binned-index file edges do not match.');
+
 disp(['All tests in '  mfilename() ' passed successfully!']);
 %------------- END OF CODE --------------
 
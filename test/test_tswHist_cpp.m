@@ -0,0 +1,142 @@
+% TEST_TSWHIST_CPP - Test script for the C++ MEX gateway tswHist_mx_cpp
+%   Validates tswHist_mx_cpp against tswHist_mx for every mode and output
+%   type, and benchmarks the call overhead (small input) and the cost of the
+%   zero-filled double output of the C gateways (large histMat).
+%
+% Example:
+%   run test_tswHist_cpp
+%
+% Other m-files required: tswHist_mx (MEX), tswHist_mx_c (MEX), tswHist_mx_cpp (MEX), tswHist_bins_mx (MEX)
+% Subfunctions: none
+% MAT-files required: none
+%
+% See also: tswHist_mx_cpp.cpp, tswHist_mx.c, tswHist_mx_c.c, test_tswHist.m
+%
+% Project: tswHist (https://github.com/cyber-g/tswHist)
+%
+% License: GNU General Public License v3.0
+%
+% Author: Germain PHAM
+% C2S, Télécom ParisTech, IP Paris
+% August 2025; Last revision:
+
+%------------- BEGIN CODE --------------
+
+addpath('..')
+
+if ~exist('tswHist_mx_cpp', 'file')
+    system('cd .. && make');
+end
+
+n_bins  = 100;
+win_len = 5000;
+stride  = 10;
+
+x = randn(1, 100000);
+x = (x - min(x)) / (max(x) - min(x)); % Normalize to [0, 1]
+
+opts = {'Bins', n_bins, 'Window', win_len, 'Stride', stride};
+
+% Histograms, all output types and thread counts
+[histMat_mx, loci_mx, edges_mx] = tswHist_mx(x, n_bins, win_len, stride);
+[histMat_cpp, loci_cpp, edges_cpp] = tswHist_mx_cpp(x, opts{:});
+assert(isequal(histMat_cpp, histMat_mx), 'C++ histograms do not match tswHist_mx.');
+assert(isequal(loci_cpp, loci_mx), 'C++ window loci do not match tswHist_mx.');
+assert(isequal(edges_cpp, edges_mx), 'C++ edges do not match tswHist_mx.');
+
+assert(isequal(tswHist_mx_cpp(single(x), opts{:}), histMat_mx), 'C++ histograms of single input do not match.');
+assert(isequal(tswHist_mx_cpp(x, opts{:}, 'Threads', 0), histMat_mx), 'C++ multithreaded histograms do not match.');
+types = {'single', 'uint16', 'uint32', 'int32'};
+for k = 1:numel(types)
+    h = tswHist_mx_cpp(x, opts{:}, 'OutputType', types{k}, 'Threads', 4);
+    assert(isa(h, types{k}), ['C++ output is not of class ' types{k} '.']);
+    assert(isequal(double(h), histMat_mx), ['C++ ' types{k} ' histograms do not match.']);
+end
+try
+    tswHist_mx_cpp(x, 'Bins', n_bins, 'Window', 300, 'Stride', stride, 'OutputType', 'uint8');
+    error('uint8 output of a 300-sample window was not rejected.');
+catch err
+    assert(strcmp(err.identifier, 'tswHist_mx:badOutputType'), 'Too small OutputType not rejected.');
+end
+
+% Binned-index file input (tswHist_binfile.h)
+bin_file = [tempname() '.tswb'];
+tswHist_bins_mx(bin_file, x, n_bins, [0 1]);
+[histMat_bf, loci_bf, edges_bf] = tswHist_mx_cpp(bin_file, 'Window', win_len, 'Stride', stride);
+delete(bin_file);
+assert(isequal(histMat_bf, histMat_mx) && isequal(loci_bf, loci_mx) && isequal(edges_bf, edges_mx), ...
+       'C++ histograms of a binned-index file do not match.');
+
+% Workload recorder: one record per call, with the input class
+record_log = [tempname() '.log'];
+setenv('TSWHIST_RECORD_LOG', record_log);
+tswHist_mx_cpp(x, opts{:});
+tswHist_mx_cpp(single(x), opts{:});
+setenv('TSWHIST_RECORD_LOG', '');
+fid = fopen(record_log, 'r');
+fseek(fid, 80, 'bof');
+type_double = fread(fid, 1, 'uint32');
+fseek(fid, 400 + 80, 'bof');
+type_single = fread(fid, 1, 'uint32');
+fclose(fid);
+delete(record_log);
+assert(type_double == 1 && type_single == 2, 'C++ records do not hold the input class.');
+
+% Long windows, short strides: scan over chunk deltas (tswHist_scan.h)
+histMat_long = tswHist_mx(x, n_bins, 60000, 2);
+assert(isequal(tswHist_mx_cpp(x, 'Bins', n_bins, 'Window', 60000, 'Stride', 2, 'Threads', 0), histMat_long), ...
+       'C++ multithreaded histograms of long windows do not match.');
+fprintf('Long windows    : tswHist_mx %.4f s, tswHist_mx_cpp 4 threads %.4f s\n', ...
+    timeit(@() tswHist_mx(x, n_bins, 60000, 2)), ...
+    timeit(@() tswHist_mx_cpp(x, 'Bins', n_bins, 'Window', 60000, 'Stride', 2, 'Threads', 4)));
+
+% Statistics modes
+assert(isequal(tswHist_mx_cpp(x, opts{:}, 'Mode', 'robust', 'Trim', 0.2), ...
+               tswHist_mx(x, n_bins, win_len, stride, 'robust', 0.2)), 'C++ robust mode does not match.');
+for mode = {'otsu', 'minerror'}
+    [t_mx, ~, ~, l_mx] = tswHist_mx(x, n_bins, win_len, stride, mode{1});
+    [t_cpp, ~, ~, l_cpp] = tswHist_mx_cpp(x, opts{:}, 'Mode', mode{1});
+    assert(isequal(t_cpp, t_mx) && isequal(l_cpp, l_mx), ['C++ ' mode{1} ' mode does not match.']);
+end
+probs = [0.1 0.5 0.9];
+[q_mx, l_mx] = tswHist_mx(x, n_bins, win_len, stride, 'exact', probs);
+[q_cpp, l_cpp] = tswHist_mx_cpp(x, opts{:}, 'Mode', 'exact', 'Probs', probs);
+assert(isequal(q_cpp, q_mx) && isequal(l_cpp, l_mx), 'C++ exact mode does not match.');
+assert(isequal(tswHist_mx_cpp(x, opts{:}, 'Mode', 'exact'), tswHist_mx(x, n_bins, win_len, stride, 'exact')), ...
+       'C++ exact median does not match.');
+x_shift = [0.5 * x(1:50000), 0.5 + 0.5 * x(50001:end)];
+[h_mx, l_mx, ~, s_mx] = tswHist_mx(x_shift, n_bins, win_len, 100, 'adaptive', 'tail', [0.02 5 0.75]);
+[h_cpp, l_cpp, ~, s_cpp] = tswHist_mx_cpp(x_shift, 'Bins', n_bins, 'Window', win_len, 'Stride', 100, 'Mode', 'adaptive', ...
+                                          'Criterion', 'tail', 'Threshold', 0.02, 'FineStride', 5, 'TailLevel', 0.75);
+assert(isequal(h_cpp, h_mx) && isequal(l_cpp, l_mx) && isequal(s_cpp, s_mx), 'C++ adaptive mode does not match.');
+phase = 0.3 + cumsum(1 ./ (110 + 20 * sin((1:length(x)) / 3000)));
+[h_mx, l_mx] = tswHist_mx(x, n_bins, 20, 5, 'phase', phase, 12);
+[h_cpp, l_cpp] = tswHist_mx_cpp(x, 'Bins', n_bins, 'Window', 20, 'Stride', 5, 'Mode', 'phase', 'Phase', phase, 'NPhase', 12);
+assert(isequal(h_cpp, h_mx) && isequal(l_cpp, l_mx), 'C++ phase mode does not match.');
+assert(isequal(tswHist_mx_cpp(x, 'Bins', n_bins, 'Window', 20, 'Stride', 5, 'Mode', 'phase', 'Phase', phase, 'NPhase', 12, 'Probs', [0.25 0.5]), ...
+               tswHist_mx(x, n_bins, 20, 5, 'phase', phase, [12 0.25 0.5])), 'C++ phase quantiles do not match.');
+X = reshape(x(1:99999), [], 3);
+assert(isequal(tswHist_mx_cpp(X, opts{:}, 'Mode', 'pooled'), ...
+               tswHist_mx(X, n_bins, win_len, stride, 'pooled')), 'C++ pooled mode does not match.');
+M = tswHist_mx_cpp(X, opts{:}, 'Mode', 'connectivity');
+assert(isequal(M, tswHist_mx(X, n_bins, win_len, stride, 'connectivity')), 'C++ connectivity mode does not match.');
+M1 = M(:, :, 1);
+assert(isequal(tswHist_mx_cpp(X, opts{:}, 'Mode', 'connectivity', 'Layout', 'triu'), ...
+               reshape(M(repmat(triu(true(3), 1), 1, 1, size(M, 3))), 3, [])), 'C++ connectivity upper triangle does not match.');
+assert(isequal(M1, M1.'), 'Connectivity matrices are not symmetric.');
+
+% Call overhead (tiny input)
+xs = x(1:200);
+fprintf('Call overhead   : tswHist_mx %.2f us, tswHist_mx_c %.2f us, tswHist_mx_cpp %.2f us\n', ...
+    1e6 * timeit(@() tswHist_mx(xs, n_bins, 100, 10)), ...
+    1e6 * timeit(@() tswHist_mx_c(xs, n_bins, 100, 10)), ...
+    1e6 * timeit(@() tswHist_mx_cpp(xs, 'Bins', n_bins, 'Window', 100, 'Stride', 10)));
+
+% Zero-fill (large histMat, stride 1)
+fprintf('Large histMat   : tswHist_mx_c %.4f s, tswHist_mx_cpp %.4f s, tswHist_mx_cpp uint16 %.4f s\n', ...
+    timeit(@() tswHist_mx_c(x, n_bins, win_len, 1)), ...
+    timeit(@() tswHist_mx_cpp(x, 'Bins', n_bins, 'Window', win_len, 'Stride', 1)), ...
+    timeit(@() tswHist_mx_cpp(x, 'Bins', n_bins, 'Window', win_len, 'Stride', 1, 'OutputType', 'uint16')));
+
+disp(['All tests in '  mfilename() ' passed successfully!']);
+%------------- END OF CODE --------------
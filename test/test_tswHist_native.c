@@ -0,0 +1,1148 @@
+/*
+ * test_tswHist_native.c - Native (MATLAB-free) tests for the pure C engines
+ *
+ *   Validates the engines of tswHist.h and tswHist_*.h against exhaustive
+ *   per-window computations, so that the pure C core can be checked without
+ *   MATLAB. Run with:
+ *     make test-native
+ *
+ *   See also: test_tswHist.m, tswHist.h
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "tswHist.h"
+#include "tswHist_robust.h"
+#include "tswHist_threshold.h"
+#include "tswHist_pooled.h"
+#include "tswHist_connectivity.h"
+#include "tswHist_codebook.h"
+#include "tswHist_exact.h"
+#include "tswHist_glcm.h"
+#include "tswHist_integral.h"
+#include "tswHist_bitplane.h"
+#include "tswHist_scan.h"
+#include "tswHist_adaptive.h"
+#include "tswHist_streams.h"
+#include "tswHist_phase.h"
+#include "tswHist_cache.h"
+#include "tswHist_jit.h"
+#include "tswHist_record.h"
+#include "tswHist_binfile.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("FAILED: %s (%s:%d)\n", msg, __FILE__, __LINE__); failures++; } \
+} while (0)
+
+// Gaussian random vector normalized to [0, 1] (same as test_tswHist.m)
+static double *gaussianSignal(size_t len, unsigned seed) {
+    double *x = (double *)malloc(len * sizeof(double));
+    double mn = INFINITY, mx = -INFINITY;
+    srand(seed);
+    for (size_t i = 0; i < len; ++i) {
+        double u1 = (rand() + 1.0) / (RAND_MAX + 2.0), u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+        x[i] = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+        if (x[i] < mn) mn = x[i];
+        if (x[i] > mx) mx = x[i];
+    }
+    for (size_t i = 0; i < len; ++i)
+        x[i] = (x[i] - mn) / (mx - mn);
+    return x;
+}
+
+// Exhaustive histogram of input_norm[start .. start+win_len)
+static void refHist(const double *x, size_t start, size_t win_len, size_t n_bins, double *hist) {
+    for (size_t b = 0; b < n_bins; ++b)
+        hist[b] = 0;
+    for (size_t i = start; i < start + win_len; ++i) {
+        int bin = (int)floor(x[i] * n_bins);
+        if (bin == (int)n_bins) bin = n_bins - 1;
+        if (bin >= 0 && bin < (int)n_bins)
+            hist[bin] += 1;
+    }
+}
+
+// Position (bin units) of a rank with samples spread uniformly inside bins
+static double refRankPos(const double *hist, size_t n_bins, double rank) {
+    double below = 0;
+    for (size_t b = 0; b < n_bins; ++b) {
+        if (hist[b] > 0 && rank <= below + hist[b])
+            return b + (rank - below) / hist[b];
+        below += hist[b];
+    }
+    return (double)n_bins;
+}
+
+// Mass of the window inside [lo, hi] (bin units)
+static double refMass(const double *hist, size_t n_bins, double lo, double hi) {
+    double m = 0;
+    for (size_t b = 0; b < n_bins; ++b) {
+        double a = fmax(lo, (double)b), c = fmin(hi, (double)b + 1);
+        if (c > a) m += hist[b] * (c - a);
+    }
+    return m;
+}
+
+static void testTswHist(void) {
+    size_t len = 20000, n_bins = 100, win_len = 1500, stride = 7;
+    double *x = gaussianSignal(len, 1);
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    double *ref = (double *)calloc(n_bins, sizeof(double));
+    int ok = 1;
+
+    tswHist(x, len, n_bins, win_len, stride, histMat, loci, edges);
+    for (size_t w = 0; w < num_windows && ok; ++w) {
+        ok &= (loci[w] == (double)(w * stride + 1));
+        refHist(x, w * stride, win_len, n_bins, ref);
+        for (size_t b = 0; b < n_bins; ++b)
+            ok &= (histMat[b + w * n_bins] == ref[b]);
+    }
+    CHECK(ok, "tswHist does not match exhaustive computation");
+    CHECK(edges[0] == 0.0 && edges[n_bins] == 1.0, "tswHist edges");
+
+    free(x); free(histMat); free(loci); free(edges); free(ref);
+}
+
+static void testBatch(void) {
+    // Batched kernels against the scalar one: bins spread, narrow, constant,
+    // with out of range ones, over all lengths of the vector tails
+    size_t n_bins = 50, len = 4000;
+    double *bins = (double *)malloc(len * sizeof(double));
+    double ref[50], hist[50];
+    int ok = 1;
+    srand(37);
+    for (int dist = 0; dist < 3; ++dist) {
+        for (size_t i = 0; i < len; ++i) {
+            double u = rand() / (double)RAND_MAX;
+            bins[i] = (dist == 0) ? floor(u * (n_bins + 4)) - 2 : (dist == 1) ? floor(20 + 3 * u) : 7;
+            if (i % 53 == 0) bins[i] = NAN;
+            if (i % 71 == 0) bins[i] = 1e12;
+        }
+        for (size_t n = 0; n <= 40; ++n) {
+            for (size_t b = 0; b < n_bins; ++b)
+                ref[b] = hist[b] = 3;
+            tswHistBatchUpdateScalar(ref, &bins[n * 61], n, n_bins, +1);
+            tswHistBatchUpdateScalar(ref, &bins[n * 97], n, n_bins, -1);
+            tswHistBatchUpdate(hist, &bins[n * 61], n, n_bins, +1);
+            tswHistBatchUpdate(hist, &bins[n * 97], n, n_bins, -1);
+            ok &= memcmp(ref, hist, sizeof(ref)) == 0;
+#if TSWHIST_BATCH_AVX512
+            for (size_t b = 0; b < n_bins; ++b)
+                hist[b] = 3;
+            tswHistBatchUpdateConflict(hist, &bins[n * 61], n, n_bins, +1);
+            tswHistBatchUpdateConflict(hist, &bins[n * 97], n, n_bins, -1);
+            ok &= memcmp(ref, hist, sizeof(ref)) == 0;
+#endif
+#if TSWHIST_BATCH_AVX2
+            for (size_t b = 0; b < n_bins; ++b)
+                hist[b] = 3;
+            tswHistBatchUpdateSorted(hist, &bins[n * 61], n, n_bins, +1);
+            tswHistBatchUpdateSorted(hist, &bins[n * 97], n, n_bins, -1);
+            ok &= memcmp(ref, hist, sizeof(ref)) == 0;
+#endif
+        }
+    }
+    CHECK(ok, "Batched bin updates do not match the scalar kernel");
+    free(bins);
+}
+
+static void testParallel(void) {
+    size_t len = 20000, n_bins = 100, win_len = 1500, stride = 7;
+    double *x = gaussianSignal(len, 6);
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *parMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    int ok = 1;
+
+    tswHist(x, len, n_bins, win_len, stride, histMat, loci, edges);
+    // 1 thread is the serial path, 0 the OpenMP default
+    size_t n_threads[4] = {1, 3, 0, 16};
+    for (size_t k = 0; k < 4; ++k) {
+        memset(parMat, 0, n_bins * num_windows * sizeof(double));
+        tswHistParallel(x, len, n_bins, win_len, stride, n_threads[k], parMat, loci, edges);
+        ok &= (memcmp(parMat, histMat, n_bins * num_windows * sizeof(double)) == 0);
+    }
+    CHECK(ok, "tswHistParallel does not match tswHist");
+
+    free(x); free(histMat); free(parMat); free(loci); free(edges);
+}
+
+static void testScan(void) {
+    size_t len = 50000, n_bins = 64, win_len = 30011, stride = 3;
+    double *x = gaussianSignal(len, 18);
+    x[40000] = NAN;
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *scanMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *scanLoci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    int ok = 1;
+
+    tswHist(x, len, n_bins, win_len, stride, histMat, loci, edges);
+    size_t n_threads[4] = {1, 3, 0, 16};
+    for (size_t k = 0; k < 4; ++k) {
+        memset(scanMat, 0, n_bins * num_windows * sizeof(double));
+        tswHistScan(x, len, n_bins, win_len, stride, n_threads[k], scanMat, scanLoci, edges);
+        ok &= memcmp(scanMat, histMat, n_bins * num_windows * sizeof(double)) == 0
+           && memcmp(scanLoci, loci, num_windows * sizeof(double)) == 0;
+    }
+    CHECK(ok, "tswHistScan does not match tswHist");
+
+    free(x); free(histMat); free(scanMat); free(loci); free(scanLoci); free(edges);
+}
+
+static void testSegments(void) {
+    size_t len = 20000, n_bins = 64, win_len = 900, stride = 7;
+    double *x = gaussianSignal(len, 8);
+    // Starts/ends (1-based, inclusive): a gap, a segment shorter than a window
+    double segments[8] = {1, 5001, 5600, 12001, 4000, 5500, 11000, 20000};
+    size_t seg_begin[4], seg_end[4];
+    int ok = tswHistSegmentBounds(segments, 4, 2, len, seg_begin, seg_end);
+    CHECK(ok && seg_begin[1] == 5000 && seg_end[1] == 5500, "tswHistSegmentBounds");
+    double starts[2] = {1, 20001};
+    CHECK(!tswHistSegmentBounds(starts, 1, 2, len, seg_begin, seg_end), "tswHistSegmentBounds out of range");
+
+    size_t num_windows = tswHistSegmentsNumWindows(seg_begin, seg_end, 4, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *segment_ids = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    double *ref = (double *)calloc(n_bins, sizeof(double));
+
+    tswHistSegments(x, len, seg_begin, seg_end, 4, n_bins, win_len, stride, histMat, loci, segment_ids, edges);
+    size_t w = 0;
+    for (size_t k = 0; k < 4; ++k) {
+        for (size_t l = seg_begin[k]; l + win_len <= seg_end[k]; l += stride, ++w) {
+            ok &= (w < num_windows) && loci[w] == (double)(l + 1) && segment_ids[w] == (double)(k + 1);
+            refHist(x, l, win_len, n_bins, ref);
+            for (size_t b = 0; b < n_bins && w < num_windows; ++b)
+                ok &= (histMat[b + w * n_bins] == ref[b]);
+        }
+    }
+    CHECK(ok && w == num_windows, "tswHistSegments does not match exhaustive computation");
+
+    free(x); free(histMat); free(loci); free(segment_ids); free(edges); free(ref);
+}
+
+static void testBinFile(void) {
+    size_t len = 30000, win_len = 2000, stride = 13;
+    size_t n_bins_list[2] = {100, 1000}; // uint8 and uint16 indices
+    double *x = gaussianSignal(len, 9);
+    x[10] = 1.5; // out of range samples are ignored by both paths
+    x[20] = -0.5;
+    const char *path = "test_tswHist_native.tswb";
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    int ok = 1;
+
+    for (size_t k = 0; k < 2; ++k) {
+        size_t n_bins = n_bins_list[k];
+        double range[2] = {-4.0, 4.0};
+        double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+        double *binned = (double *)calloc(n_bins * num_windows, sizeof(double));
+        double *loci = (double *)calloc(num_windows, sizeof(double));
+        double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+        tswHistBinFile bf;
+
+        tswHist(x, len, n_bins, win_len, stride, histMat, loci, edges);
+        ok &= tswHistBinFileWrite(path, x, len, n_bins, range);
+        ok &= tswHistBinFileOpen(&bf, path);
+        if (ok) {
+            ok &= bf.hdr.n_bins == n_bins && bf.hdr.input_len == len && bf.hdr.range[1] == 4.0;
+            ok &= bf.hdr.elem_bytes == (k == 0 ? 1u : 2u);
+            tswHistBinned(&bf, win_len, stride, binned, loci, edges);
+            ok &= memcmp(binned, histMat, n_bins * num_windows * sizeof(double)) == 0;
+            tswHistBinFileClose(&bf);
+        }
+        free(histMat); free(binned); free(loci); free(edges);
+    }
+    CHECK(ok, "tswHistBinned does not match tswHist");
+
+    // Truncated files are rejected
+    FILE *f = fopen(path, "r+b");
+    tswHistBinFile bf;
+    CHECK(f && ftruncate(fileno(f), 100) == 0 && fclose(f) == 0 && !tswHistBinFileOpen(&bf, path),
+          "truncated binned-index file accepted");
+
+    // Header whose input_len * elem_bytes wraps to the (empty) payload size
+    CHECK(tswHistBinFileWrite(path, x, 0, 1000, NULL), "cannot write an empty binned-index file");
+    tswHistBinFileHeader hdr;
+    f = fopen(path, "r+b");
+    int crafted = f && fread(&hdr, sizeof(hdr), 1, f) == 1;
+    hdr.input_len = (uint64_t)1 << 63;
+    crafted = crafted && fseek(f, 0, SEEK_SET) == 0 && fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    CHECK(f && fclose(f) == 0 && crafted && !tswHistBinFileOpen(&bf, path),
+          "binned-index file with a wrapping input length accepted");
+    remove(path);
+
+    // The temporary file is not a fixed name shared by concurrent writers
+    CHECK(mkdir("test_tswHist_native.tswb.tmp", 0700) == 0 && tswHistBinFileWrite(path, x, len, 100, NULL),
+          "binned-index file not written next to a foreign .tmp entry");
+    rmdir("test_tswHist_native.tswb.tmp");
+    remove(path);
+    free(x);
+}
+
+static void testRobust(void) {
+    size_t len = 20000, n_bins = 64, win_len = 1001, stride = 13;
+    double trim = 0.1, tol = 1e-9;
+    double *x = gaussianSignal(len, 2);
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *robustMat = (double *)calloc(TSWHIST_ROBUST_NSTATS * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    double *h = (double *)calloc(n_bins, sizeof(double));
+    int ok = 1;
+
+    tswHistRobust(x, len, n_bins, win_len, stride, trim, robustMat, loci, edges);
+    for (size_t w = 0; w < num_windows; ++w) {
+        const double *st = &robustMat[w * TSWHIST_ROBUST_NSTATS];
+        double N = (double)win_len;
+        refHist(x, w * stride, win_len, n_bins, h);
+
+        double med = refRankPos(h, n_bins, 0.5 * N);
+        double q1  = refRankPos(h, n_bins, 0.25 * N);
+        double q3  = refRankPos(h, n_bins, 0.75 * N);
+        double lo  = refRankPos(h, n_bins, trim * N);
+        double hi  = refRankPos(h, n_bins, (1 - trim) * N);
+
+        // MAD by bisection on the mass around the median
+        double a = 0, c = (double)n_bins;
+        for (int it = 0; it < 200; ++it) {
+            double m = 0.5 * (a + c);
+            if (refMass(h, n_bins, med - m, med + m) >= 0.5 * N) c = m; else a = m;
+        }
+
+        // Trimmed sum by integrating positions over each bin portion
+        double inner = 0;
+        for (size_t b = 0; b < n_bins; ++b) {
+            double s = fmax(lo, (double)b), e = fmin(hi, (double)b + 1);
+            if (e > s) inner += h[b] * (e * e - s * s) / 2;
+        }
+        double trimmean   = inner / ((1 - 2 * trim) * N);
+        double winsormean = (inner + trim * N * (lo + hi)) / N;
+
+        ok &= fabs(st[TSWHIST_ROBUST_MEDIAN] - med / n_bins) < tol;
+        ok &= fabs(st[TSWHIST_ROBUST_Q1] - q1 / n_bins) < tol;
+        ok &= fabs(st[TSWHIST_ROBUST_Q3] - q3 / n_bins) < tol;
+        ok &= fabs(st[TSWHIST_ROBUST_IQR] - (q3 - q1) / n_bins) < tol;
+        ok &= fabs(st[TSWHIST_ROBUST_MAD] - a / n_bins) < 1e-7;
+        ok &= fabs(st[TSWHIST_ROBUST_TRIMMEAN] - trimmean / n_bins) < 1e-7;
+        ok &= fabs(st[TSWHIST_ROBUST_WINSORMEAN] - winsormean / n_bins) < 1e-7;
+    }
+    CHECK(ok, "tswHistRobust does not match exhaustive computation");
+
+    free(x); free(robustMat); free(loci); free(edges); free(h);
+}
+
+static void testThreshold(void) {
+    size_t len = 20000, n_bins = 50, win_len = 2000, stride = 11;
+    double *x = gaussianSignal(len, 3);
+    // Make the signal bimodal
+    for (size_t i = 0; i < len; ++i)
+        x[i] = (i % 3 == 0) ? 0.5 * x[i] : 0.5 + 0.5 * x[i];
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *threshMat = (double *)calloc(TSWHIST_THRESHOLD_NROWS * num_windows, sizeof(double));
+    unsigned char *labels = (unsigned char *)calloc(len, 1);
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    double *h = (double *)calloc(n_bins, sizeof(double));
+    int ok = 1;
+
+    tswHistThreshold(x, len, n_bins, win_len, stride, TSWHIST_THRESHOLD_OTSU, threshMat, labels, loci, edges);
+    for (size_t w = 0; w < num_windows; ++w) {
+        refHist(x, w * stride, win_len, n_bins, h);
+        // Textbook Otsu: maximize w0 * w1 * (mu0 - mu1)^2
+        size_t best_t = 0;
+        double best = -1, N = (double)win_len;
+        for (size_t t = 0; t + 1 < n_bins; ++t) {
+            double w0 = 0, s0 = 0, s1 = 0;
+            for (size_t b = 0; b <= t; ++b) { w0 += h[b]; s0 += b * h[b]; }
+            for (size_t b = t + 1; b < n_bins; ++b) s1 += b * h[b];
+            if (w0 == 0 || w0 == N) continue;
+            double v = (w0 / N) * (1 - w0 / N) * pow(s0 / w0 - s1 / (N - w0), 2);
+            if (v > best * (1 + 1e-12)) { best = v; best_t = t; }
+        }
+        double w0 = 0;
+        for (size_t b = 0; b <= best_t; ++b) w0 += h[b];
+        ok &= (threshMat[w * 3] == edges[best_t + 1]);
+        ok &= fabs(threshMat[w * 3 + 1] - w0 / N) < 1e-12;
+        ok &= fabs(threshMat[w * 3 + 1] + threshMat[w * 3 + 2] - 1) < 1e-12;
+        // Samples entering this window are labelled against its threshold
+        size_t first = (w == 0) ? 0 : (w - 1) * stride + win_len;
+        size_t last  = (w == 0) ? win_len : first + stride;
+        for (size_t i = first; i < last; ++i)
+            ok &= (labels[i] == (x[i] >= edges[best_t + 1]));
+    }
+    CHECK(ok, "tswHistThreshold (Otsu) does not match exhaustive computation");
+
+    // The minimum-error threshold must separate the two modes as well
+    tswHistThreshold(x, len, n_bins, win_len, stride, TSWHIST_THRESHOLD_MINERROR, threshMat, labels, loci, edges);
+    ok = 1;
+    for (size_t w = 0; w < num_windows; ++w)
+        ok &= (threshMat[w * 3] > 0.3 && threshMat[w * 3] < 0.7);
+    CHECK(ok, "tswHistThreshold (minimum error) does not separate the modes");
+
+    free(x); free(threshMat); free(labels); free(loci); free(edges); free(h);
+}
+
+static void testPooled(void) {
+    size_t len = 5000, n_channels = 7, n_bins = 40, win_len = 700, stride = 9;
+    double *x = gaussianSignal(len * n_channels, 4);
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *chanMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *sumMat  = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    int ok = 1;
+
+    // Reference: sum of the per-channel sliding histograms
+    for (size_t c = 0; c < n_channels; ++c) {
+        tswHist(&x[c * len], len, n_bins, win_len, stride, chanMat, loci, edges);
+        for (size_t k = 0; k < n_bins * num_windows; ++k)
+            sumMat[k] += chanMat[k];
+    }
+    tswHistPooled(x, len, n_channels, n_bins, win_len, stride, histMat, loci, edges);
+    for (size_t k = 0; k < n_bins * num_windows; ++k)
+        ok &= (histMat[k] == sumMat[k]);
+    CHECK(ok, "tswHistPooled does not match the sum of per-channel histograms");
+
+    free(x); free(histMat); free(chanMat); free(sumMat); free(loci); free(edges);
+}
+
+// Exhaustive mutual information (nats) of channels a and b over [start, start+win_len)
+static double refMI(const double *x, size_t len, size_t a, size_t b, size_t start, size_t win_len, size_t n_bins) {
+    double *joint = (double *)calloc(n_bins * n_bins, sizeof(double));
+    double *ha = (double *)calloc(n_bins, sizeof(double));
+    double *hb = (double *)calloc(n_bins, sizeof(double));
+    for (size_t i = start; i < start + win_len; ++i) {
+        int ba = (int)floor(x[a * len + i] * n_bins), bb = (int)floor(x[b * len + i] * n_bins);
+        if (ba == (int)n_bins) ba = n_bins - 1;
+        if (bb == (int)n_bins) bb = n_bins - 1;
+        joint[ba * n_bins + bb] += 1;
+        ha[ba] += 1;
+        hb[bb] += 1;
+    }
+    double mi = 0, N = (double)win_len;
+    for (size_t u = 0; u < n_bins; ++u)
+        for (size_t v = 0; v < n_bins; ++v)
+            if (joint[u * n_bins + v] > 0)
+                mi += joint[u * n_bins + v] / N * log(joint[u * n_bins + v] * N / (ha[u] * hb[v]));
+    free(joint); free(ha); free(hb);
+    return mi;
+}
+
+static void testConnectivity(void) {
+    size_t len = 3000, n_channels = 11, win_len = 400, stride = 9;
+    size_t n_bins_list[3] = {6, 40, 256}; // dense, sparse, sparse with power-of-two cells
+    double *x = gaussianSignal(len * n_channels, 7);
+    // Correlate a few channels so that the MI is not only bias
+    for (size_t i = 0; i < len; ++i) {
+        x[3 * len + i] = 0.5 * (x[i] + x[3 * len + i]);
+        x[9 * len + i] = 0.7 * x[i] + 0.3 * x[9 * len + i];
+    }
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    size_t n_pairs = tswHistConnNumPairs(n_channels);
+    double *full = (double *)calloc(n_channels * n_channels * num_windows, sizeof(double));
+    double *triu = (double *)calloc(n_pairs * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    int ok_full = 1, ok_triu = 1, ok_diag = 1;
+
+    for (size_t k = 0; k < 3; ++k) {
+        size_t n_bins = n_bins_list[k];
+        double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+        tswHistConnectivity(x, len, n_channels, n_bins, win_len, stride, TSWHIST_CONN_FULL, full, loci, edges);
+        tswHistConnectivity(x, len, n_channels, n_bins, win_len, stride, TSWHIST_CONN_TRIU, triu, loci, edges);
+        for (size_t w = 0; w < num_windows; w += 7) {
+            double *M = &full[w * n_channels * n_channels];
+            for (size_t j = 0; j < n_channels; ++j) {
+                ok_diag &= fabs(M[j + j * n_channels] - refMI(x, len, j, j, w * stride, win_len, n_bins)) < 1e-9;
+                for (size_t i = 0; i < j; ++i) {
+                    double ref = refMI(x, len, i, j, w * stride, win_len, n_bins);
+                    ok_full &= fabs(M[i + j * n_channels] - ref) < 1e-9 && M[j + i * n_channels] == M[i + j * n_channels];
+                    ok_triu &= triu[j * (j - 1) / 2 + i + w * n_pairs] == M[i + j * n_channels];
+                }
+            }
+        }
+        free(edges);
+    }
+    CHECK(ok_full, "tswHistConnectivity does not match exhaustive mutual information");
+    CHECK(ok_triu, "tswHistConnectivity upper triangle layout");
+    CHECK(ok_diag, "tswHistConnectivity diagonal entropy");
+
+    free(x); free(full); free(triu); free(loci);
+}
+
+static void testCodebook(void) {
+    size_t len = 20000, n_bins = 50, win_len = 1200, stride = 11, K = 9;
+    double *x = gaussianSignal(len, 10);
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *codeMat = (double *)calloc(TSWHIST_CODEBOOK_NROWS * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    double *protos = (double *)calloc(n_bins * K, sizeof(double));
+    int ok_l2 = 1, ok_dot = 1;
+
+    // Prototypes: histograms of a few windows, plus noise
+    tswHist(x, len, n_bins, win_len, stride, histMat, loci, edges);
+    srand(11);
+    for (size_t k = 0; k < K; ++k)
+        for (size_t b = 0; b < n_bins; ++b)
+            protos[b + k * n_bins] = histMat[b + (k * num_windows / K) * n_bins] + (rand() % 7) - 3;
+
+    for (int m = 0; m < 2; ++m) {
+        tswHistCodebookMetric metric = m ? TSWHIST_CODEBOOK_DOT : TSWHIST_CODEBOOK_L2;
+        tswHistCodebook(x, len, n_bins, win_len, stride, protos, K, metric, codeMat, loci, edges);
+        for (size_t w = 0; w < num_windows; ++w) {
+            double best = m ? -INFINITY : INFINITY;
+            for (size_t k = 0; k < K; ++k) {
+                double d = 0;
+                for (size_t b = 0; b < n_bins; ++b) {
+                    double h = histMat[b + w * n_bins], p = protos[b + k * n_bins];
+                    d += m ? h * p : (h - p) * (h - p);
+                }
+                best = m ? fmax(best, d) : fmin(best, d);
+            }
+            size_t idx = (size_t)codeMat[w * 2] - 1;
+            double d = 0;
+            for (size_t b = 0; b < n_bins; ++b) {
+                double h = histMat[b + w * n_bins], p = protos[b + idx * n_bins];
+                d += m ? h * p : (h - p) * (h - p);
+            }
+            int ok = idx < K && d == best && fabs(codeMat[w * 2 + 1] - best) <= 1e-9 * fabs(best);
+            if (m) ok_dot &= ok; else ok_l2 &= ok;
+        }
+    }
+    CHECK(ok_l2, "tswHistCodebook (squared L2) does not match exhaustive assignment");
+    CHECK(ok_dot, "tswHistCodebook (dot product) does not match exhaustive assignment");
+
+    free(x); free(histMat); free(codeMat); free(loci); free(edges); free(protos);
+}
+
+static int cmpDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void testExact(void) {
+    size_t len = 12000, win_len = 501, stride = 5;
+    double probs[4] = {0.5, 0.0, 0.1, 0.975};
+    double *x = gaussianSignal(len, 12);
+    for (size_t i = 0; i < len; i += 97)
+        x[i] = x[i / 2]; // ties
+    x[7000] = NAN;
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *quantMat = (double *)calloc(4 * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *win = (double *)calloc(win_len, sizeof(double));
+    int ok = 1, ok_nan = 1;
+
+    tswHistExact(x, len, win_len, stride, probs, 4, quantMat, loci);
+    for (size_t w = 0; w < num_windows; ++w) {
+        ok &= (loci[w] == (double)(w * stride + 1));
+        size_t start = w * stride;
+        if (start <= 7000 && 7000 < start + win_len) {
+            for (size_t q = 0; q < 4; ++q)
+                ok_nan &= isnan(quantMat[q + w * 4]);
+            continue;
+        }
+        memcpy(win, &x[start], win_len * sizeof(double));
+        qsort(win, win_len, sizeof(double), cmpDouble);
+        for (size_t q = 0; q < 4; ++q) {
+            // MATLAB prctile: sorted values at (i-0.5)/n, linear interpolation
+            double pos = win_len * probs[q] + 0.5, ref;
+            if (pos <= 1) ref = win[0];
+            else if (pos >= win_len) ref = win[win_len - 1];
+            else {
+                size_t lo = (size_t)floor(pos);
+                ref = win[lo - 1] + (pos - lo) * (win[lo] - win[lo - 1]);
+            }
+            ok &= (quantMat[q + w * 4] == ref);
+        }
+    }
+    CHECK(ok, "tswHistExact does not match exhaustive sorting");
+    CHECK(ok_nan, "tswHistExact NaN windows");
+
+    free(x); free(quantMat); free(loci); free(win);
+}
+
+static void testTiny(void) {
+    // Sorted-window engine (tiny windows) against the Fenwick tree engine
+    size_t len = 3000, win_lens[5] = {1, 2, 5, 31, 64}, strides[5] = {1, 3, 8, 21, 70};
+    double probs[4] = {0.5, 0.0, 0.1, 0.975};
+    double *x = gaussianSignal(len, 31);
+    for (size_t i = 0; i < len; i += 7)
+        x[i] = x[i / 3]; // ties
+    x[1500] = NAN;
+    x[2000] = INFINITY;
+    int ok = 1;
+    for (size_t a = 0; a < 5; ++a) {
+        for (size_t b = 0; b < 5; ++b) {
+            size_t win_len = win_lens[a], stride = strides[b];
+            size_t num_windows = tswHistNumWindows(len, win_len, stride);
+            double *quantMat = (double *)calloc(4 * num_windows, sizeof(double));
+            double *ref = (double *)calloc(4 * num_windows, sizeof(double));
+            double *loci = (double *)calloc(num_windows, sizeof(double));
+            tswHistExact(x, len, win_len, stride, probs, 4, quantMat, loci);
+            tswHistExactSlidingWindow(ref, x, len, num_windows, win_len, stride, probs, 4);
+            for (size_t k = 0; k < 4 * num_windows; ++k)
+                ok &= (quantMat[k] == ref[k]) || (isnan(quantMat[k]) && isnan(ref[k]));
+            ok &= loci[num_windows - 1] == (double)((num_windows - 1) * stride + 1);
+            free(quantMat); free(ref); free(loci);
+        }
+    }
+    CHECK(tswHistTinySelected(64) && !tswHistTinySelected(65), "tswHistTinySelected bound");
+    CHECK(!tswHistTinyResort(64, 21) && tswHistTinyResort(64, 22) && tswHistTinyResort(1, 1), "tswHistTinyResort crossover");
+    CHECK(ok, "tswHistTiny does not match the Fenwick tree engine");
+    free(x);
+}
+
+// graycomatrix/graycoprops of one patch, from the full GLCM
+static void refGlcm(const double *img, size_t rows, size_t r0, size_t c0, size_t ph, size_t pw,
+                    long dr, long dc, size_t L, int symmetric, double *feat) {
+    double *P = (double *)calloc(L * L, sizeof(double));
+    double n = 0;
+    for (size_t r = r0; r < r0 + ph; ++r)
+        for (size_t c = c0; c < c0 + pw; ++c) {
+            long r2 = (long)r + dr, c2 = (long)c + dc;
+            if (r2 < (long)r0 || r2 >= (long)(r0 + ph) || c2 < (long)c0 || c2 >= (long)(c0 + pw))
+                continue;
+            double x = img[r + c * rows], y = img[r2 + c2 * rows];
+            if (!(x >= 0 && x <= 1 && y >= 0 && y <= 1))
+                continue;
+            size_t a = (size_t)fmin(floor(x * L), L - 1), b = (size_t)fmin(floor(y * L), L - 1);
+            P[a * L + b] += 1;
+            if (symmetric) P[b * L + a] += 1;
+            n += 1 + symmetric;
+        }
+    double mi = 0, mj = 0, vi = 0, vj = 0, cov = 0;
+    feat[0] = feat[2] = feat[3] = 0;
+    for (size_t i = 0; i < L; ++i)
+        for (size_t j = 0; j < L; ++j) {
+            double p = P[i * L + j] / n, d = (double)i - (double)j;
+            feat[0] += d * d * p;
+            feat[2] += p * p;
+            feat[3] += p / (1 + fabs(d));
+            mi += (i + 1) * p;
+            mj += (j + 1) * p;
+        }
+    for (size_t i = 0; i < L; ++i)
+        for (size_t j = 0; j < L; ++j) {
+            double p = P[i * L + j] / n;
+            vi  += (i + 1 - mi) * (i + 1 - mi) * p;
+            vj  += (j + 1 - mj) * (j + 1 - mj) * p;
+            cov += (i + 1 - mi) * (j + 1 - mj) * p;
+        }
+    feat[1] = cov / sqrt(vi * vj);
+    free(P);
+}
+
+static void testGlcm(void) {
+    size_t rows = 61, cols = 97, L = 8, ph = 15, pw = 21, sr = 4, sc = 3;
+    double offsets[10] = {0, -1, -1, -1, 2,   1, 1, 0, -1, -3}; // [5 x 2]
+    size_t n_off = 5;
+    double *img = gaussianSignal(rows * cols, 13);
+    img[30 + 40 * rows] = NAN;
+    img[10 + 12 * rows] = 1.5; // left out
+    size_t npr = tswHistNumWindows(rows, ph, sr), npc = tswHistNumWindows(cols, pw, sc);
+    double *featMat = (double *)calloc(TSWHIST_GLCM_NFEATURES * n_off * npr * npc, sizeof(double));
+    double *row_loci = (double *)calloc(npr, sizeof(double));
+    double *col_loci = (double *)calloc(npc, sizeof(double));
+    CHECK(tswHistGlcmValidOffsets(offsets, n_off, ph, pw), "tswHistGlcmValidOffsets rejects valid offsets");
+    double bad[2] = {0, 21};
+    CHECK(!tswHistGlcmValidOffsets(bad, 1, ph, pw), "tswHistGlcmValidOffsets accepts an offset out of the patch");
+
+    for (int sym = 0; sym < 2; ++sym) {
+        int ok = 1;
+        // Wide column stride (larger than some anchor widths) on the second pass
+        size_t stc = sym ? 19 : sc;
+        npc = tswHistNumWindows(cols, pw, stc);
+        tswHistGlcm(img, rows, cols, L, ph, pw, sr, stc, offsets, n_off, sym, 3, featMat, row_loci, col_loci);
+        for (size_t pr = 0; pr < npr; ++pr)
+            for (size_t pc = 0; pc < npc; ++pc)
+                for (size_t o = 0; o < n_off; ++o) {
+                    double ref[4];
+                    refGlcm(img, rows, pr * sr, pc * stc, ph, pw, (long)offsets[o], (long)offsets[o + n_off], L, sym, ref);
+                    const double *f = &featMat[TSWHIST_GLCM_NFEATURES * (o + n_off * (pr + npr * pc))];
+                    for (int k = 0; k < 4; ++k)
+                        ok &= fabs(f[k] - ref[k]) <= 1e-9 * fmax(1, fabs(ref[k]));
+                }
+        ok &= row_loci[npr - 1] == (double)((npr - 1) * sr + 1) && col_loci[npc - 1] == (double)((npc - 1) * stc + 1);
+        CHECK(ok, sym ? "tswHistGlcm (symmetric) does not match exhaustive GLCM features"
+                      : "tswHistGlcm does not match exhaustive GLCM features");
+    }
+
+    free(img); free(featMat); free(row_loci); free(col_loci);
+}
+
+static void testIntegral(void) {
+    size_t rows = 83, cols = 117, n_bins = 20, n_rects = 500;
+    // untiled, uint8, uint8, uint16 in-tile counts, and a tile whose square
+    // wraps, clamped to one tile of the image (uint16)
+    size_t tiles[5] = {0, 4, 12, 20, (size_t)1 << 32};
+    double *img = gaussianSignal(rows * cols, 14);
+    img[5 + 9 * rows] = NAN;
+    img[50 + 70 * rows] = -0.5; // not counted
+    double *rects = (double *)calloc(n_rects * 4, sizeof(double));
+    srand(15);
+    for (size_t k = 0; k < n_rects; ++k) {
+        size_t x = 1 + rand() % cols, y = 1 + rand() % rows;
+        rects[k]               = (double)x;
+        rects[k + n_rects]     = (double)y;
+        rects[k + 2 * n_rects] = (double)(rand() % (cols - x + 2));
+        rects[k + 3 * n_rects] = (double)(rand() % (rows - y + 2));
+    }
+    rects[0] = 1; rects[n_rects] = 1; rects[2 * n_rects] = (double)cols; rects[3 * n_rects] = (double)rows;
+    CHECK(tswHistIntegralValidRects(rects, n_rects, rows, cols), "tswHistIntegralValidRects rejects valid rectangles");
+    double bad[4] = {2, 1, (double)cols, 1};
+    CHECK(!tswHistIntegralValidRects(bad, 1, rows, cols), "tswHistIntegralValidRects accepts a rectangle out of the image");
+
+    double *histMat = (double *)calloc(n_bins * n_rects, sizeof(double));
+    double *ref = (double *)calloc(n_bins, sizeof(double));
+    for (int t = 0; t < 5; ++t) {
+        tswHistIntegral ih;
+        int ok = tswHistIntegralBuild(&ih, img, rows, cols, n_bins, tiles[t], 3);
+        tswHistIntegralQueries(&ih, rects, n_rects, 2, histMat);
+        for (size_t k = 0; ok && k < n_rects; ++k) {
+            size_t c0 = (size_t)rects[k] - 1, r0 = (size_t)rects[k + n_rects] - 1;
+            memset(ref, 0, n_bins * sizeof(double));
+            for (size_t c = c0; c < c0 + (size_t)rects[k + 2 * n_rects]; ++c)
+                for (size_t r = r0; r < r0 + (size_t)rects[k + 3 * n_rects]; ++r) {
+                    double v = img[r + c * rows];
+                    if (v >= 0 && v <= 1)
+                        ref[(size_t)fmin(floor(v * n_bins), n_bins - 1)] += 1;
+                }
+            ok &= memcmp(ref, &histMat[k * n_bins], n_bins * sizeof(double)) == 0;
+        }
+        CHECK(ok && ih.elem_bytes == (t == 0 ? 4u : t >= 3 ? 2u : 1u),
+              "tswHistIntegralQueries does not match exhaustive rectangle histograms");
+        tswHistIntegralFree(&ih);
+    }
+
+    free(img); free(rects); free(histMat); free(ref);
+}
+
+static void testBitplane(void) {
+    size_t len = 30001; // not a multiple of 64
+    size_t bins[3] = {3, 7, 16}, wins[3] = {100, 777, 4096}, strides[3] = {1, 64, 333};
+    double *x = gaussianSignal(len, 16);
+    x[123] = NAN;
+    x[4567] = 1.25; // out of range
+    x[8901] = 1.0;  // last bin
+
+    // Masked popcounts of arbitrary ranges
+    size_t n_words = (len + 63) / 64;
+    uint64_t *planes = (uint64_t *)malloc(3 * n_words * sizeof(uint64_t));
+    tswHistBitplanes(x, len, 3, planes, n_words);
+    int ok_count = 1;
+    srand(17);
+    for (int k = 0; k < 2000; ++k) {
+        size_t first = rand() % len, n = rand() % (len - first + 1), ref = 0;
+        for (size_t i = first; i < first + n; ++i)
+            ref += (x[i] >= 0 && x[i] <= 1 && (size_t)fmin(floor(x[i] * 3), 2) == 1);
+        ok_count &= tswHistBitplaneCount(&planes[n_words], first, n) == ref;
+    }
+    CHECK(ok_count, "tswHistBitplaneCount does not match exhaustive counts");
+    free(planes);
+
+    int ok = 1;
+    for (int b = 0; b < 3; ++b)
+        for (int k = 0; k < 3; ++k) {
+            size_t n_bins = bins[b], win_len = wins[k], stride = strides[k];
+            size_t num_windows = tswHistNumWindows(len, win_len, stride);
+            double *ref = (double *)calloc(n_bins * num_windows, sizeof(double));
+            double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+            double *loci = (double *)calloc(num_windows, sizeof(double));
+            double *loci_ref = (double *)calloc(num_windows, sizeof(double));
+            double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+            tswHist(x, len, n_bins, win_len, stride, ref, loci_ref, edges);
+            tswHistBitplane(x, len, n_bins, win_len, stride, histMat, loci, edges);
+            ok &= memcmp(ref, histMat, n_bins * num_windows * sizeof(double)) == 0
+               && memcmp(loci, loci_ref, num_windows * sizeof(double)) == 0;
+            free(ref); free(histMat); free(loci); free(loci_ref); free(edges);
+        }
+    CHECK(ok, "tswHistBitplane does not match tswHist");
+    CHECK(tswHistBitplaneSelected(16, 64) && !tswHistBitplaneSelected(17, 64) && !tswHistBitplaneSelected(8, 10),
+          "tswHistBitplaneSelected does not select small n_bins with long strides");
+
+    free(x);
+}
+
+static void testAdaptive(void) {
+    size_t len = 20000, n_bins = 32, win_len = 1000, stride = 50, fine = 7;
+    double *x = gaussianSignal(len, 19);
+    for (size_t i = 12000; i < len; ++i)
+        x[i] = 0.5 + 0.5 * x[i]; // level shift: entropy and tail mass jump
+    size_t num_coarse = tswHistNumWindows(len, win_len, stride);
+    double *coarse = (double *)calloc(n_bins * num_coarse, sizeof(double));
+    double *loci = (double *)calloc(num_coarse, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    double *ref = (double *)calloc(n_bins, sizeof(double));
+    tswHist(x, len, n_bins, win_len, stride, coarse, loci, edges);
+
+    for (int crit = 0; crit < 2; ++crit) {
+        tswHistAdaptiveCriterion criterion = crit ? TSWHIST_ADAPTIVE_TAIL : TSWHIST_ADAPTIVE_ENTROPY;
+        tswHistAdaptiveResult res;
+
+        // No trigger: the coarse windows of tswHist
+        int ok = tswHistAdaptive(x, len, n_bins, win_len, stride, fine, criterion, 0.75, INFINITY, &res, edges);
+        ok &= res.num_windows == num_coarse
+           && memcmp(res.histMat, coarse, n_bins * num_coarse * sizeof(double)) == 0
+           && memcmp(res.loci, loci, num_coarse * sizeof(double)) == 0;
+        tswHistAdaptiveFree(&res);
+        CHECK(ok, "tswHistAdaptive without triggers does not match tswHist");
+
+        // Backfilled windows around the level shift, all windows exact
+        double threshold = crit ? 0.02 : 0.01;
+        ok = tswHistAdaptive(x, len, n_bins, win_len, stride, fine, criterion, 0.75, threshold, &res, edges);
+        size_t n_coarse_found = 0, n_fine_found = 0;
+        for (size_t w = 0; ok && w < res.num_windows; ++w) {
+            size_t start = (size_t)res.loci[w] - 1;
+            refHist(x, start, win_len, n_bins, ref);
+            ok &= memcmp(ref, &res.histMat[w * n_bins], n_bins * sizeof(double)) == 0;
+            ok &= fabs(res.stat[w] - tswHistAdaptiveStat(ref, n_bins, criterion, (size_t)(0.75 * n_bins))) <= 1e-12;
+            if (w > 0) {
+                size_t step = start - ((size_t)res.loci[w - 1] - 1);
+                ok &= (step == stride) || (step == fine) || (start % stride == 0 && step <= fine);
+            }
+            if (start % stride == 0) n_coarse_found++; else n_fine_found++;
+        }
+        ok &= n_coarse_found == num_coarse && n_fine_found > 0 && n_fine_found < num_coarse * (stride / fine);
+        tswHistAdaptiveFree(&res);
+        CHECK(ok, crit ? "tswHistAdaptive (tail mass) does not match exhaustive computation"
+                       : "tswHistAdaptive (entropy) does not match exhaustive computation");
+    }
+
+    free(x); free(coarse); free(loci); free(edges); free(ref);
+}
+
+static void testStreams(void) {
+    // Two parameter sets interleaved over the streams, uneven stream rates
+    size_t n_streams = 1000, n_batches = 20, batch = 3000, hist_cap = 200;
+    size_t *n_bins = (size_t *)malloc(n_streams * sizeof(size_t));
+    size_t *win_len = (size_t *)malloc(n_streams * sizeof(size_t));
+    for (size_t s = 0; s < n_streams; ++s) {
+        n_bins[s]  = (s % 3 == 0) ? 16 : 40;
+        win_len[s] = (s % 3 == 0) ? 50 : 25;
+    }
+    tswHistStreams sm;
+    int ok = tswHistStreamsInit(&sm, n_streams, n_bins, win_len);
+    CHECK(ok && sm.n_groups == 2, "tswHistStreamsInit does not group the parameter sets");
+
+    // Per-stream history of the samples (last hist_cap), for the reference
+    double *history = (double *)malloc(n_streams * hist_cap * sizeof(double));
+    size_t *seen = (size_t *)calloc(n_streams, sizeof(size_t));
+    uint32_t *ids = (uint32_t *)malloc(batch * sizeof(uint32_t));
+    double *x = gaussianSignal(n_batches * batch, 23);
+    double hist[40], ref[40];
+    srand(29);
+    for (size_t t = 0; ok && t < n_batches; ++t) {
+        size_t n = batch - t * 97; // varying batch sizes
+        double *values = &x[t * batch];
+        for (size_t i = 0; i < n; ++i) {
+            ids[i] = (uint32_t)((rand() % 4) ? rand() % 100 : rand() % n_streams); // hot streams
+            if (i % 101 == 0)
+                values[i] = 1.5; // out of range: not counted
+        }
+        ok &= tswHistStreamsUpdate(&sm, ids, values, n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            if (seen[ids[i]] == hist_cap) {
+                memmove(&history[ids[i] * hist_cap], &history[ids[i] * hist_cap + hist_cap / 2], hist_cap / 2 * sizeof(double));
+                seen[ids[i]] = hist_cap / 2;
+            }
+            history[ids[i] * hist_cap + seen[ids[i]]++] = values[i];
+        }
+        for (size_t s = 0; s < n_streams; ++s) {
+            size_t len = (seen[s] < win_len[s]) ? seen[s] : win_len[s];
+            refHist(&history[s * hist_cap], seen[s] - len, len, n_bins[s], ref);
+            size_t n_samples = tswHistStreamsHist(&sm, s, hist);
+            ok &= n_samples == len && memcmp(hist, ref, n_bins[s] * sizeof(double)) == 0;
+        }
+    }
+    CHECK(ok, "tswHistStreams windows do not match exhaustive computation");
+    ids[0] = (uint32_t)n_streams;
+    CHECK(!tswHistStreamsUpdate(&sm, ids, x, 1, 0), "tswHistStreamsUpdate accepts an out of range stream id");
+
+    tswHistStreamsFree(&sm);
+    free(n_bins); free(win_len); free(history); free(seen); free(ids); free(x);
+}
+
+static void testPhase(void) {
+    // Shaft speed drifting: revolutions of 90 to 130 samples
+    size_t len = 20000, n_bins = 20, n_phase = 12, win_revs = 8, stride_revs = 3;
+    double probs[3] = {0.5, 0.1, 0.9};
+    double *x = gaussianSignal(len, 41);
+    double *phase = (double *)malloc(len * sizeof(double));
+    phase[0] = 0.3;
+    for (size_t i = 1; i < len; ++i)
+        phase[i] = phase[i - 1] + 1 / (110.0 + 20.0 * sin(i / 3000.0));
+    x[5000] = 1.5; // out of range: not counted
+    CHECK(tswHistPhaseValid(phase, len), "tswHistPhaseValid rejects a nondecreasing phase");
+
+    size_t *rev_starts = (size_t *)malloc((len + 1) * sizeof(size_t));
+    size_t n_revs = tswHistPhaseRevolutions(phase, len, rev_starts);
+    size_t num_windows = tswHistPhaseNumWindows(n_revs, win_revs, stride_revs);
+    double *histMat = (double *)calloc(n_phase * n_bins * num_windows, sizeof(double));
+    double *quantMat = (double *)calloc(n_phase * 3 * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *ref = (double *)calloc(n_phase * n_bins, sizeof(double));
+    double edges[21];
+    tswHistPhase(x, phase, len, rev_starts, n_revs, n_bins, n_phase, win_revs, stride_revs,
+                 probs, 3, histMat, NULL, loci, edges);
+    tswHistPhase(x, phase, len, rev_starts, n_revs, n_bins, n_phase, win_revs, stride_revs,
+                 probs, 3, NULL, quantMat, loci, edges);
+
+    int ok = n_revs > 150 && num_windows == (n_revs - win_revs) / stride_revs + 1, ok_q = 1;
+    for (size_t w = 0; w < num_windows; ++w) {
+        size_t first = rev_starts[w * stride_revs], last = rev_starts[w * stride_revs + win_revs];
+        ok &= loci[w] == (double)(first + 1);
+        memset(ref, 0, n_phase * n_bins * sizeof(double));
+        for (size_t i = first; i < last; ++i) {
+            int b = (int)floor(x[i] * n_bins);
+            if (b == (int)n_bins) b = n_bins - 1;
+            size_t p = (size_t)floor((phase[i] - floor(phase[i])) * n_phase);
+            if (b >= 0 && b < (int)n_bins)
+                ref[p + b * n_phase] += 1;
+        }
+        ok &= memcmp(ref, &histMat[w * n_phase * n_bins], n_phase * n_bins * sizeof(double)) == 0;
+        for (size_t p = 0; p < n_phase; ++p) {
+            double h[20], N = 0;
+            for (size_t b = 0; b < n_bins; ++b)
+                N += (h[b] = ref[p + b * n_phase]);
+            for (size_t q = 0; q < 3; ++q)
+                ok_q &= fabs(quantMat[p + q * n_phase + w * n_phase * 3] - refRankPos(h, n_bins, probs[q] * N) / n_bins) <= 1e-9;
+        }
+    }
+    CHECK(ok, "tswHistPhase does not match exhaustive computation");
+    CHECK(ok_q, "tswHistPhase quantiles do not match exhaustive computation");
+    phase[100] = phase[99] - 0.01;
+    CHECK(!tswHistPhaseValid(phase, len), "tswHistPhaseValid accepts a decreasing phase");
+
+    free(x); free(phase); free(rev_starts); free(histMat); free(quantMat); free(loci); free(ref);
+}
+
+static void testCache(void) {
+    // XXH64 reference digests
+    CHECK(tswHistHash64("", 0, 0) == 0xEF46DB3751D8E999ULL, "XXH64 of the empty string");
+    CHECK(tswHistHash64("abc", 3, 0) == 0x44BC2CF5AD770999ULL, "XXH64 of abc");
+
+    size_t len = 300000, n_bins = 30, win_len = 4000, stride = 50;
+    double *x = gaussianSignal(len, 5);
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *cached  = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    char dir[] = "/tmp/tswHist_cache_XXXXXX";
+    int ok = 1;
+
+    CHECK(mkdtemp(dir) != NULL, "cannot create the cache directory");
+    CHECK(tswHistHashInput(x, len * sizeof(double)) != tswHistHashInput(x, (len - 1) * sizeof(double)),
+          "input hash ignores the tail");
+
+    tswHist(x, len, n_bins, win_len, stride, histMat, loci, edges);
+    CHECK(tswHistCached(dir, 1 << 30, x, len, n_bins, win_len, stride, cached, loci, edges) == 0,
+          "first cached call must miss");
+    CHECK(tswHistCached(dir, 1 << 30, x, len, n_bins, win_len, stride, cached, loci, edges) == 1,
+          "second cached call must hit");
+    for (size_t k = 0; k < n_bins * num_windows; ++k)
+        ok &= (cached[k] == histMat[k]);
+    CHECK(ok, "cached histMat does not match tswHist");
+    CHECK(tswHistCached(dir, 1 << 30, x, len, n_bins, win_len, stride + 1, cached, loci, edges) == 0,
+          "a different stride must miss");
+
+    // Doubles round trip, and eviction of the oldest entries under the cap
+    tswHistCacheKey key;
+    double frac[3] = {0.5, 1.25, -3};
+    tswHistCacheKeyInit(&key, 1, 3, 1, 3, 1, 1, "robust", 0);
+    CHECK(tswHistCacheStore(dir, 1 << 30, &key, frac, 3, 1) == 1, "cache store");
+    CHECK(tswHistCacheLookup(dir, &key, cached, 3, 1) == 1 && cached[1] == 1.25 && cached[2] == -3,
+          "doubles round trip");
+    tswHistCacheKeyInit(&key, 2, 3, 1, 3, 1, 1, "robust", 0);
+    tswHistCacheStore(dir, sizeof(tswHistCacheHeader) + 3 * 8, &key, frac, 3, 1);
+    CHECK(tswHistCacheLookup(dir, &key, cached, 3, 1) == 1, "the newest entry must survive eviction");
+    tswHistCacheKeyInit(&key, 1, 3, 1, 3, 1, 1, "robust", 0);
+    CHECK(tswHistCacheLookup(dir, &key, cached, 3, 1) == 0, "older entries must be evicted");
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    CHECK(system(cmd) == 0, "cannot remove the cache directory");
+    free(x); free(histMat); free(cached); free(loci); free(edges);
+}
+
+static void testJit(void) {
+    size_t len = 100000;
+    double *x = gaussianSignal(len, 15);
+    x[10] = 1.0; x[20] = -0.5; x[30] = 1.5; x[40] = NAN; // edge, out of range and NaN samples
+    size_t params[4][3] = {{30, 500, 1}, {64, 1000, 37}, {17, 3000, 700}, {70000, 2000, 150}};
+    char dir[] = "/tmp/tswHist_jit_XXXXXX";
+    CHECK(mkdtemp(dir) != NULL, "cannot create the JIT directory");
+
+    for (int k = 0; k < 4; ++k) {
+        size_t n_bins = params[k][0], win_len = params[k][1], stride = params[k][2];
+        size_t num_windows = tswHistNumWindows(len, win_len, stride);
+        double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+        double *jitMat  = (double *)calloc(n_bins * num_windows, sizeof(double));
+        double *loci = (double *)calloc(num_windows, sizeof(double));
+        double *jit_loci = (double *)calloc(num_windows, sizeof(double));
+        double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+        tswHist(x, len, n_bins, win_len, stride, histMat, loci, edges);
+
+        tswHistJitPlan plan;
+        CHECK(tswHistJitPlanCreate(&plan, dir, NULL, "-O1", n_bins, win_len, stride) == 1 && plan.compiled,
+              "tswHistJitPlanCreate must compile the kernel");
+        CHECK(strcmp(plan.dir, dir) == 0 && plan.cc[0] == '\0' && strcmp(plan.cflags, "-O1") == 0,
+              "the JIT plan must record its directory and compile command");
+        tswHistJit(&plan, x, len, jitMat, jit_loci, edges);
+        CHECK(memcmp(jitMat, histMat, n_bins * num_windows * sizeof(double)) == 0, "tswHistJit does not match tswHist");
+        CHECK(memcmp(jit_loci, loci, num_windows * sizeof(double)) == 0, "tswHistJit loci do not match tswHist");
+        tswHistJitPlanFree(&plan);
+
+        // Second plan loaded from the directory
+        CHECK(tswHistJitPlanCreate(&plan, dir, NULL, "-O1", n_bins, win_len, stride) == 1 && !plan.compiled,
+              "tswHistJitPlanCreate must reuse the cached kernel");
+        tswHistJitPlanFree(&plan);
+
+        // Fallback when the compiler fails
+        memset(jitMat, 0, n_bins * num_windows * sizeof(double));
+        CHECK(tswHistJitPlanCreate(&plan, dir, "false", "", n_bins, win_len, stride) == 0 && plan.kernel == NULL,
+              "a failing compiler must give no kernel");
+        tswHistJit(&plan, x, len, jitMat, jit_loci, edges);
+        CHECK(memcmp(jitMat, histMat, n_bins * num_windows * sizeof(double)) == 0, "tswHistJit fallback does not match tswHist");
+        free(histMat); free(jitMat); free(loci); free(jit_loci); free(edges);
+    }
+
+    // Untrusted shared objects are recompiled, untrusted directories give no kernel
+    tswHistJitPlan plan;
+    char cmd[128];
+    tswHistJitPlanCreate(&plan, dir, NULL, "-O1", 30, 500, 1);
+    tswHistJitPlanFree(&plan);
+    snprintf(cmd, sizeof(cmd), "chmod g+w %s/tswhist_jit_*.so", dir);
+    CHECK(system(cmd) == 0, "cannot make the JIT shared objects group-writable");
+    CHECK(tswHistJitPlanCreate(&plan, dir, NULL, "-O1", 30, 500, 1) == 1 && plan.compiled,
+          "a group-writable shared object must be recompiled");
+    tswHistJitPlanFree(&plan);
+    CHECK(chmod(dir, 0777) == 0, "cannot make the JIT directory world-writable");
+    CHECK(tswHistJitPlanCreate(&plan, dir, NULL, "-O1", 30, 500, 1) == 0 && plan.kernel == NULL,
+          "a world-writable JIT directory must give no kernel");
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    CHECK(system(cmd) == 0, "cannot remove the JIT directory");
+    free(x);
+}
+
+static void testRecord(void) {
+    // Smoothed signal (repeated bins), with NaN and out of range samples
+    size_t len = 200000, n_bins = 50, win_len = 1000, stride = 10;
+    double *g = gaussianSignal(len + 8, 16);
+    double *x = (double *)malloc(len * sizeof(double));
+    for (size_t i = 0; i < len; ++i) {
+        x[i] = 0;
+        for (int k = 0; k < 8; ++k)
+            x[i] += g[i + k] / 8;
+    }
+    for (size_t i = 0; i < len; i += 97) x[i] = NAN;
+    for (size_t i = 5; i < len; i += 211) x[i] = -0.2;
+    size_t num_windows = tswHistNumWindows(len, win_len, stride);
+    double *histMat = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *ref = (double *)calloc(n_bins * num_windows, sizeof(double));
+    double *loci = (double *)calloc(num_windows, sizeof(double));
+    double *edges = (double *)calloc(n_bins + 1, sizeof(double));
+    char log[] = "/tmp/tswHist_record_XXXXXX";
+    int fd = mkstemp(log);
+    CHECK(fd >= 0, "cannot create the log");
+    close(fd);
+
+    tswHist(x, len, n_bins, win_len, stride, ref, loci, edges);
+    tswHistRecorded(log, x, len, n_bins, win_len, stride, histMat, loci, edges);
+    CHECK(memcmp(histMat, ref, n_bins * num_windows * sizeof(double)) == 0, "tswHistRecorded does not match tswHist");
+    tswHistRecorded(log, x, len / 2, n_bins, win_len, 2 * stride, histMat, loci, edges);
+    tswHistRecorded(NULL, x, len, n_bins, win_len, stride, histMat, loci, edges);
+
+    tswHistRecord *recs;
+    CHECK(tswHistRecordRead(log, &recs) == 2, "the log must hold one record per recorded call");
+    CHECK(recs[0].n_bins == n_bins && recs[0].win_len == win_len && recs[0].stride == stride
+          && recs[0].input_len == len && recs[0].n_channels == 1 && strcmp(recs[0].mode, "hist") == 0
+          && recs[0].n_sampled == TSWHIST_RECORD_SAMPLES && recs[0].wall_time > 0, "record shape");
+    CHECK(recs[1].input_len == len / 2 && recs[1].stride == 2 * stride, "second record shape");
+    CHECK(fabs(recs[0].nan_frac - 1.0 / 97) < 0.003 && fabs(recs[0].below_frac - 1.0 / 211) < 0.002
+          && recs[0].above_frac == 0, "record out of range fractions");
+
+    // Synthetic input: same sketch, repeat rate and out of range fractions
+    double *y = (double *)malloc(len * sizeof(double));
+    tswHistRecordSynthesize(&recs[0], y, len, 1);
+    tswHistRecord syn;
+    tswHistRecordInit(&syn, "C", "hist", y, len, 1, n_bins, win_len, stride);
+    double dist = 0;
+    for (int c = 0; c < TSWHIST_RECORD_SKETCH; ++c)
+        dist += fabs(syn.sketch[c] - recs[0].sketch[c]);
+    CHECK(dist < 0.05, "synthetic sketch does not match the record");
+    CHECK(fabs(syn.repeat_frac - recs[0].repeat_frac) < 0.02, "synthetic repeat rate does not match the record");
+    CHECK(fabs(syn.nan_frac - recs[0].nan_frac) < 0.003 && fabs(syn.below_frac - recs[0].below_frac) < 0.003,
+          "synthetic out of range fractions do not match the record");
+
+    // Single inputs: recorded class, same sketch as their double values
+    float *xs = (float *)malloc(len * sizeof(float));
+    for (size_t i = 0; i < len; ++i)
+        xs[i] = (float)x[i];
+    tswHistRecord rec_s;
+    tswHistRecordInitTyped(&rec_s, "C", "hist", xs, TSWHIST_RECORD_SINGLE, len, 1, n_bins, win_len, stride);
+    CHECK(rec_s.input_type == TSWHIST_RECORD_SINGLE && recs[0].input_type == TSWHIST_RECORD_DOUBLE
+          && fabs(rec_s.nan_frac - recs[0].nan_frac) < 1e-12 && fabs(rec_s.repeat_frac - recs[0].repeat_frac) < 0.001,
+          "single input record");
+    free(xs);
+
+    unlink(log);
+    free(recs); free(g); free(x); free(y); free(histMat); free(ref); free(loci); free(edges);
+}
+
+int main(void) {
+    testTswHist();
+    testBatch();
+    testParallel();
+    testScan();
+    testSegments();
+    testBinFile();
+    testRobust();
+    testThreshold();
+    testPooled();
+    testConnectivity();
+    testCodebook();
+    testExact();
+    testTiny();
+    testGlcm();
+    testIntegral();
+    testBitplane();
+    testAdaptive();
+    testStreams();
+    testPhase();
+    testCache();
+    testJit();
+    testRecord();
+
+    if (failures) {
+        printf("%d test(s) failed.\n", failures);
+        return 1;
+    }
+    printf("All native tests passed successfully!\n");
+    return 0;
+}
@@ -6,7 +6,19 @@
  *   does not depend on MATLAB or MEX headers.
  *
  *   The pushHist and popHist functions incrementally update histogram vectors.
- *   The tswHistSlidingWindow function implements the main sliding window logic.
+ *   The tswHistSlidingWindow function implements the main sliding window logic,
+ *   applying the popped and pushed runs of each step with the batched kernels
+ *   of tswHist_batch.h.
+ *   The tswHistNumWindows, tswHistLoci, tswHistEdges and tswHistBinning helpers
+ *   hold the setup stage shared by tswHist and the other engines (tswHist_*.h).
+ *   tswHistParallel splits the windows into chunks computed by OpenMP threads
+ *   (when enabled), each chunk seeding its first window with a full count.
+ *   tswHistSegments restarts the sliding window at the beginning of each
+ *   segment of a concatenated recording, so that no window straddles a gap.
+ *
+ *   When the MEX twin tswHist_mx.h has already been included, its pushHist,
+ *   popHist and tswHistSlidingWindow are used and only the helpers are defined
+ *   here.
  *
  *   The core logic is adapted from the essential version of hist_int in:
  *   https://github.com/cyber-g/FastHist
@@ -25,6 +37,13 @@
 #include <stddef.h> // for size_t
 #include <stdlib.h> // for malloc, free
 #include <math.h> // for floor
+#include <string.h> // for memset
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "tswHist_batch.h"
+
+#ifndef TSWHIST_MX_H // core routines already provided by the MEX twin
 
 void pushHist(double *hist_vec, const double *input_int, size_t len, size_t n_bins) {
     for (size_t i = 0; i < len; ++i) {
@@ -56,20 +75,34 @@ void tswHistSlidingWindow(
     const double *offsets,
     size_t input_len
 ) {
+    // Consecutive offsets (tswHistOffsets): the popped and pushed samples of
+    // a step are two runs, updated by batches (tswHist_batch.h)
+    int runs = (stride > 0);
+    for (size_t j = 1; j < stride; ++j)
+        runs &= (offsets[j] == offsets[j - 1] + 1);
     for (size_t w = 1; w < num_windows; ++w) {
-        // pop indices
-        size_t base_pop = (size_t)strided_windows_loci[w] - 2; // -1 for 0-based, -1 for previous window
-        for (size_t j = 0; j < stride; ++j) {
-            size_t idx = base_pop + (size_t)offsets[j];
-            if (idx < input_len)
-                popHist(bufferHist, &input_int[idx], 1, n_bins);
-        }
-        // push indices
+        size_t base_pop  = (size_t)strided_windows_loci[w] - 2; // -1 for 0-based, -1 for previous window
         size_t base_push = (size_t)strided_windows_loci[w] + win_len - 2;
-        for (size_t j = 0; j < stride; ++j) {
-            size_t idx = base_push + (size_t)offsets[j];
-            if (idx < input_len)
-                pushHist(bufferHist, &input_int[idx], 1, n_bins);
+        // offsets are <= 0: converted through a signed type (a negative
+        // double to unsigned conversion is undefined)
+        long long first_pop  = (long long)base_pop + (runs ? (long long)offsets[0] : 0);
+        long long first_push = (long long)base_push + (runs ? (long long)offsets[0] : 0);
+        if (runs && first_pop >= 0 && first_push + (long long)stride <= (long long)input_len) {
+            tswHistBatchUpdate(bufferHist, &input_int[first_pop], stride, n_bins, -1);
+            tswHistBatchUpdate(bufferHist, &input_int[first_push], stride, n_bins, +1);
+        } else {
+            // pop indices
+            for (size_t j = 0; j < stride; ++j) {
+                size_t idx = base_pop + (size_t)(long long)offsets[j];
+                if (idx < input_len)
+                    popHist(bufferHist, &input_int[idx], 1, n_bins);
+            }
+            // push indices
+            for (size_t j = 0; j < stride; ++j) {
+                size_t idx = base_push + (size_t)(long long)offsets[j];
+                if (idx < input_len)
+                    pushHist(bufferHist, &input_int[idx], 1, n_bins);
+            }
         }
         // Store
         for (size_t b = 0; b < n_bins; ++b)
@@ -77,27 +110,26 @@ void tswHistSlidingWindow(
     }
 }
 
-void tswHist(
-    const double *input_norm, size_t input_len,
-    size_t n_bins, size_t win_len, size_t stride,
-    double *histMat,         // [n_bins x num_windows] output
-    double *strided_windows_loci, // [num_windows] output
-    double *edges            // [n_bins+1] output
-) {
-    // Compute number of windows
-    size_t num_windows = (input_len - win_len) / stride + 1;
+#endif // TSWHIST_MX_H
+
+size_t tswHistNumWindows(size_t input_len, size_t win_len, size_t stride) {
+    return (input_len - win_len) / stride + 1;
+}
 
-    // Compute strided windows loci (maintain 1-based for MATLAB compatibility)
+void tswHistLoci(double *strided_windows_loci, size_t num_windows, size_t stride) {
+    // Maintain 1-based for MATLAB compatibility
     for (size_t i = 0; i < num_windows; ++i)
-        strided_windows_loci[i] = (double)(i * stride + 1); // 1-based
+        strided_windows_loci[i] = (double)(i * stride + 1);
+}
 
-    // Compute the edges for the histogram bins. Bin edges are set to be between
-    // 0 and 1 exactly here, 0 and 1 are included in the edges
+void tswHistEdges(double *edges, size_t n_bins) {
+    // Bin edges are set to be between 0 and 1 exactly here, 0 and 1 are
+    // included in the edges
     for (size_t i = 0; i <= n_bins; ++i)
         edges[i] = 1.0 * ((double)i / n_bins);
+}
 
-    // Normalize input to integer bins
-    double *input_int = (double *)calloc(input_len, sizeof(double));
+void tswHistBinning(const double *input_norm, size_t input_len, size_t n_bins, double *input_int) {
     for (size_t i = 0; i < input_len; ++i) {
         //  The normalization is left outside this function for more flexibility
         //  The input vector is expected to be included in [0,1] (not
@@ -106,6 +138,64 @@ void tswHist(
         if (bin == (int)n_bins) bin = n_bins - 1; // Patch for max value
         input_int[i] = (double)bin;
     }
+}
+
+void tswHistOffsets(double *offsets, size_t stride) {
+    // Offsets for the popping and pushing elements indices
+    for (size_t i = 0; i < stride; ++i)
+        offsets[i] = -(double)(stride - 1 - i);
+}
+
+// Histograms of the windows [w_begin, w_end) into histMat (column 0 holds
+// window w_begin), seeding bufferHist with a full count of window w_begin
+void tswHistWindowRange(
+    double *histMat,
+    double *bufferHist,
+    const double *input_int,
+    const double *strided_windows_loci,
+    size_t w_begin,
+    size_t w_end,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride,
+    const double *offsets,
+    size_t input_len
+) {
+    memset(bufferHist, 0, n_bins * sizeof(double));
+    pushHist(bufferHist, &input_int[(size_t)strided_windows_loci[w_begin] - 1], win_len, n_bins);
+    for (size_t b = 0; b < n_bins; ++b)
+        histMat[b] = bufferHist[b];
+    tswHistSlidingWindow(
+        histMat,
+        bufferHist,
+        input_int,
+        &strided_windows_loci[w_begin],
+        w_end - w_begin,
+        win_len,
+        n_bins,
+        stride,
+        offsets,
+        input_len
+    );
+}
+
+void tswHist(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    double *histMat,         // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges            // [n_bins+1] output
+) {
+    // Compute number of windows
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+
+    // Compute strided windows loci and the edges for the histogram bins
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    // Normalize input to integer bins
+    double *input_int = (double *)calloc(input_len, sizeof(double));
+    tswHistBinning(input_norm, input_len, n_bins, input_int);
 
     // Compute histogram for the first window
     double *bufferHist = (double *)calloc(n_bins, sizeof(double));
@@ -115,8 +205,7 @@ void tswHist(
 
     // Prepare offsets for pop/push
     double *offsets = (double *)calloc(stride, sizeof(double));
-    for (size_t i = 0; i < stride; ++i)
-        offsets[i] = -(double)(stride - 1 - i);
+    tswHistOffsets(offsets, stride);
 
     // Sliding window
     tswHistSlidingWindow(
@@ -137,4 +226,134 @@ void tswHist(
     free(offsets);
 }
 
+// Number of threads actually used for n_threads requested (0: OpenMP default)
+size_t tswHistNumThreads(size_t n_threads) {
+#ifdef _OPENMP
+    return (n_threads > 0) ? n_threads : (size_t)omp_get_max_threads();
+#else
+    (void)n_threads;
+    return 1;
+#endif
+}
+
+// Multithreaded tswHist: the windows are split into one chunk per thread
+void tswHistParallel(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    size_t n_threads,             // 0: OpenMP default
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    size_t n_chunks = tswHistNumThreads(n_threads);
+    if (n_chunks > num_windows)
+        n_chunks = num_windows;
+
+    double *input_int = (double *)malloc(input_len * sizeof(double));
+    double *offsets   = (double *)malloc(stride * sizeof(double));
+    tswHistOffsets(offsets, stride);
+
+    #pragma omp parallel num_threads((int)n_chunks)
+    {
+        #pragma omp for schedule(static)
+        for (long long i = 0; i < (long long)input_len; i += 65536) {
+            size_t n = ((size_t)i + 65536 < input_len) ? 65536 : input_len - (size_t)i;
+            tswHistBinning(&input_norm[i], n, n_bins, &input_int[i]);
+        }
+
+        double *bufferHist = (double *)malloc(n_bins * sizeof(double));
+        #pragma omp for schedule(static)
+        for (long long c = 0; c < (long long)n_chunks; ++c) {
+            size_t w_begin = (size_t)c * num_windows / n_chunks;
+            size_t w_end   = ((size_t)c + 1) * num_windows / n_chunks;
+            tswHistWindowRange(&histMat[w_begin * n_bins], bufferHist, input_int,
+                               strided_windows_loci, w_begin, w_end,
+                               win_len, n_bins, stride, offsets, input_len);
+        }
+        free(bufferHist);
+    }
+
+    free(input_int);
+    free(offsets);
+}
+
+// Segment bounds [seg_begin, seg_end) (0-based) from MATLAB segments: either a
+// vector of 1-based start indices (each segment ends before the next start,
+// the last one at the end of the input) or a [n_segments x 2] column-major
+// matrix of 1-based [start, end] indices (inclusive). Returns 0 if a segment
+// is empty or out of [1, input_len].
+int tswHistSegmentBounds(
+    const double *segments, size_t rows, size_t cols, size_t input_len,
+    size_t *seg_begin, size_t *seg_end
+) {
+    int pairs = (cols == 2 && rows != 1);
+    size_t n_segments = pairs ? rows : rows * cols;
+    for (size_t k = 0; k < n_segments; ++k) {
+        double first = segments[k];
+        double last  = pairs ? segments[k + rows] : ((k + 1 < n_segments) ? segments[k + 1] - 1 : (double)input_len);
+        if (!(first >= 1 && last >= first && last <= (double)input_len))
+            return 0;
+        seg_begin[k] = (size_t)first - 1;
+        seg_end[k]   = (size_t)last;
+    }
+    return 1;
+}
+
+size_t tswHistSegmentsNumWindows(
+    const size_t *seg_begin, const size_t *seg_end, size_t n_segments,
+    size_t win_len, size_t stride
+) {
+    size_t num_windows = 0;
+    for (size_t k = 0; k < n_segments; ++k)
+        if (seg_end[k] - seg_begin[k] >= win_len)
+            num_windows += tswHistNumWindows(seg_end[k] - seg_begin[k], win_len, stride);
+    return num_windows;
+}
+
+// tswHist over the segments [seg_begin[k], seg_end[k]) of the input: windows
+// never cross a segment bound, segments shorter than win_len hold no window.
+// The windows of all segments are concatenated, with global loci.
+void tswHistSegments(
+    const double *input_norm, size_t input_len,
+    const size_t *seg_begin, const size_t *seg_end, size_t n_segments,
+    size_t n_bins, size_t win_len, size_t stride,
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *segment_ids,          // [num_windows] output (1-based), may be NULL
+    double *edges                 // [n_bins+1] output
+) {
+    tswHistEdges(edges, n_bins);
+
+    double *input_int  = (double *)malloc(input_len * sizeof(double));
+    double *bufferHist = (double *)malloc(n_bins * sizeof(double));
+    double *offsets    = (double *)malloc(stride * sizeof(double));
+    tswHistBinning(input_norm, input_len, n_bins, input_int);
+    tswHistOffsets(offsets, stride);
+
+    size_t w = 0;
+    for (size_t k = 0; k < n_segments; ++k) {
+        size_t seg_len = seg_end[k] - seg_begin[k];
+        if (seg_len < win_len)
+            continue;
+        size_t seg_windows = tswHistNumWindows(seg_len, win_len, stride);
+        for (size_t i = 0; i < seg_windows; ++i) {
+            strided_windows_loci[w + i] = (double)(seg_begin[k] + 1 + i * stride); // MATLAB 1-based
+            if (segment_ids)
+                segment_ids[w + i] = (double)(k + 1);
+        }
+        // Reset and re-seed bufferHist at the segment start
+        tswHistWindowRange(&histMat[w * n_bins], bufferHist, input_int, strided_windows_loci,
+                           w, w + seg_windows, win_len, n_bins, stride, offsets, input_len);
+        w += seg_windows;
+    }
+
+    free(input_int);
+    free(bufferHist);
+    free(offsets);
+}
+
 #endif // TSWHIST_H
\ No newline at end of file
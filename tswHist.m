@@ -1,6 +1,8 @@
-function [histMat,strided_windows_loci,edges] = tswHist(input_norm, n_bins, win_len, stride, variant)
+function [histMat,strided_windows_loci,edges,segment_ids] = tswHist(input_norm, n_bins, win_len, stride, variant, segments)
 % TSWHIST - Fast sliding window histogram computation for 1D signals.
 %   [histMat, strided_windows_loci, edges] = tswHist(input_norm, n_bins, win_len, stride, variant)
+%   [histMat, strided_windows_loci, edges, segment_ids] = tswHist(input_norm, n_bins, win_len, stride, variant, segments)
+%   [histMat, strided_windows_loci, edges] = tswHist(bin_file, n_bins, win_len, stride, variant)
 %
 %   Computes histograms over sliding windows using efficient differential
 %   updates. The local hist_int matlab function is adapted from the core of the
@@ -12,17 +14,25 @@ function [histMat,strided_windows_loci,edges] = tswHist(input_norm, n_bins, win_
 %
 %   Inputs:
 %     input_norm - Normalized input vector (1D signal) (in [0,1])
+%     bin_file   - Binned-index file written by tswHist_bins_mx, used instead
+%                  of input_norm: the binning stage is skipped and n_bins may
+%                  be [] (n_bins of the file)
 %     n_bins     - Number of histogram bins (integer > 2)
 %     win_len    - Sliding window length
 %     stride     - Stride for sliding window (default: 1)
 %     variant    - 'builtin', 'custom-ml', or 'custom-mx' (default: 'builtin')
+%     segments   - (optional) segment start indices (each segment ends before
+%                  the next start), or [n_segments x 2] matrix of [start, end]
+%                  indices. Windows are restarted at every segment and never
+%                  cross a segment bound; samples outside the segments are gaps.
 %
 %   Outputs:
 %     histMat              - n_bins x num_windows matrix of histograms
 %     strided_windows_loci - Start indices of each window
 %     edges                - Bin edges used for histogramming
+%     segment_ids          - Segment index of each window (only with segments)
 %
-%   See also: histcounts, hist_int_mx
+%   See also: histcounts, hist_int_mx, tswHist_bins_mx
 %
 %   Project: tswHist (https://github.com/cyber-g/tswHist)
 %
@@ -52,9 +62,45 @@ function [histMat,strided_windows_loci,edges] = tswHist(input_norm, n_bins, win_
     if nargin < 4
         stride = 1;
     end
-    if nargin < 5
+    if nargin < 5 || isempty(variant)
         variant = 'builtin';
     end
+    % Binned-index file: bin indices read from the file, binning is skipped
+    input_int = [];
+    if ischar(input_norm) || isstring(input_norm)
+        [input_int, file_bins] = read_bin_file(input_norm);
+        if isempty(n_bins)
+            n_bins = file_bins;
+        elseif n_bins ~= file_bins
+            error('Number of bins does not match the binned-index file.');
+        end
+        if nargin >= 6
+            error('Segments are not available with a binned-index file.');
+        end
+        input_norm = input_int; % only its length is used below
+    end
+    if nargin >= 6
+        % Concatenate the windows of every segment, with global loci
+        if size(segments, 2) == 2 && size(segments, 1) ~= 1
+            seg_bounds = segments;
+        else
+            seg_bounds = [segments(:), [reshape(segments(2:end), [], 1) - 1; length(input_norm)]];
+        end
+        histMat = zeros(n_bins, 0);
+        strided_windows_loci = zeros(1, 0);
+        segment_ids = zeros(1, 0);
+        for k = 1:size(seg_bounds, 1)
+            if seg_bounds(k, 2) - seg_bounds(k, 1) + 1 < win_len
+                continue; % segment shorter than a window
+            end
+            [seg_hist, seg_loci, edges] = tswHist(input_norm(seg_bounds(k, 1):seg_bounds(k, 2)), n_bins, win_len, stride, variant);
+            histMat = [histMat, seg_hist]; %#ok<AGROW>
+            strided_windows_loci = [strided_windows_loci, seg_loci + seg_bounds(k, 1) - 1]; %#ok<AGROW>
+            segment_ids = [segment_ids, k * ones(1, numel(seg_loci))]; %#ok<AGROW>
+        end
+        edges = (0:n_bins)/n_bins;
+        return;
+    end
     if ~isvector(input_norm)
         error('Input must be a vector.');
     end
@@ -84,7 +130,9 @@ function [histMat,strided_windows_loci,edges] = tswHist(input_norm, n_bins, win_
     % The normalization is left outside this function for more flexibility The
     % input vector is expected to be included in [0,1] (not necessarily exactly
     % occupying this range)
-    input_int  = floor(input_norm * n_bins); 
+    if isempty(input_int)
+        input_int  = floor(input_norm * n_bins); 
+    end
 
     % Compute the histogram for the first window
     switch variant
@@ -140,6 +188,30 @@ function [histMat,strided_windows_loci,edges] = tswHist(input_norm, n_bins, win_
 
 end
 
+function [input_int, n_bins] = read_bin_file(bin_file)
+    % Read the bin indices of a binned-index file (see tswHist_binfile.h)
+    fid = fopen(bin_file, 'r', 'ieee-le');
+    if fid < 0
+        error('Cannot open the binned-index file.');
+    end
+    magic      = fread(fid, [1 4], '*char');
+    version    = fread(fid, 1, 'uint32');
+    input_len  = fread(fid, 1, 'uint64');
+    n_bins     = fread(fid, 1, 'uint64');
+    elem_bytes = fread(fid, 1, 'uint32');
+    fclose(fid);
+    if ~strcmp(magic, 'TSWB') || version ~= 1
+        error('Not a binned-index file.');
+    end
+    types = {'uint8', 'uint16'};
+    m = memmapfile(bin_file, 'Offset', 48, 'Format', {types{elem_bytes}, [1 input_len], 'idx'});
+    input_int = double(m.Data.idx);
+    % Out of range samples (largest index) are not handled by the MATLAB variants
+    if any(input_int >= n_bins)
+        error('The binned-index file holds samples outside [0,1].');
+    end
+end
+
 function bufferHist = pushHist(bufferHist, input_int)
     % Increment the histogram counts for the new elements
     for j = 1:length(input_int)
@@ -0,0 +1,161 @@
+/*
+ * tswHist_adaptive.h - Sliding histograms with adaptive stride refinement
+ *
+ *   Slides at a coarse stride and evaluates a cheap statistic of bufferHist
+ *   on every coarse window: the Shannon entropy (nats) or the tail mass (the
+ *   fraction of the window in the bins at or above a level). When the
+ *   statistic jumps by more than a threshold between two coarse windows, the
+ *   windows in between are backfilled at a fine stride, by differential
+ *   moves backwards from the current state (the samples of the earlier
+ *   window are pushed back, the latest ones popped). The result is a
+ *   variable-stride sequence of windows with explicit loci, so the cost is
+ *   concentrated where the data changes.
+ *
+ *   The number of windows is only known at the end: the results are grown
+ *   in a tswHistAdaptiveResult, freed by tswHistAdaptiveFree.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_ADAPTIVE_H
+#define TSWHIST_ADAPTIVE_H
+
+#include "tswHist.h"
+
+typedef enum {
+    TSWHIST_ADAPTIVE_ENTROPY = 0,
+    TSWHIST_ADAPTIVE_TAIL
+} tswHistAdaptiveCriterion;
+
+typedef struct {
+    double *histMat;     // [n_bins x num_windows]
+    double *loci;        // [num_windows] start indices (1-based)
+    double *stat;        // [num_windows] statistic of each window
+    size_t  num_windows;
+    size_t  capacity;
+} tswHistAdaptiveResult;
+
+void tswHistAdaptiveFree(tswHistAdaptiveResult *res) {
+    free(res->histMat);
+    free(res->loci);
+    free(res->stat);
+    memset(res, 0, sizeof(*res));
+}
+
+// Room for n more windows, returns 0 on allocation failure
+int tswHistAdaptiveReserve(tswHistAdaptiveResult *res, size_t n_bins, size_t n) {
+    if (res->num_windows + n <= res->capacity)
+        return 1;
+    size_t capacity = 2 * res->capacity + n;
+    double *histMat = (double *)realloc(res->histMat, capacity * n_bins * sizeof(double));
+    if (histMat) res->histMat = histMat;
+    double *loci = (double *)realloc(res->loci, capacity * sizeof(double));
+    if (loci) res->loci = loci;
+    double *stat = (double *)realloc(res->stat, capacity * sizeof(double));
+    if (stat) res->stat = stat;
+    if (!histMat || !loci || !stat)
+        return 0;
+    res->capacity = capacity;
+    return 1;
+}
+
+// Statistic of a window histogram: entropy (nats) or mass at or above tail_bin
+double tswHistAdaptiveStat(const double *hist, size_t n_bins,
+                           tswHistAdaptiveCriterion criterion, size_t tail_bin) {
+    double total = 0, acc = 0;
+    for (size_t b = 0; b < n_bins; ++b)
+        total += hist[b];
+    if (total <= 0)
+        return 0;
+    if (criterion == TSWHIST_ADAPTIVE_TAIL) {
+        for (size_t b = tail_bin; b < n_bins; ++b)
+            acc += hist[b];
+        return acc / total;
+    }
+    for (size_t b = 0; b < n_bins; ++b)
+        if (hist[b] > 0)
+            acc -= hist[b] / total * log(hist[b] / total);
+    return acc;
+}
+
+// Appends the window starting at start (0-based)
+void tswHistAdaptiveStore(tswHistAdaptiveResult *res, size_t slot, const double *hist, size_t n_bins,
+                          size_t start, double stat) {
+    memcpy(&res->histMat[slot * n_bins], hist, n_bins * sizeof(double));
+    res->loci[slot] = (double)(start + 1); // MATLAB 1-based
+    res->stat[slot] = stat;
+}
+
+// Returns 0 on allocation failure (res then holds the windows computed so far)
+int tswHistAdaptive(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len,
+    size_t stride,                // coarse stride
+    size_t fine_stride,           // stride of the backfilled windows (< stride)
+    tswHistAdaptiveCriterion criterion,
+    double tail,                  // level of the tail mass, in [0,1]
+    double threshold,             // jump of the statistic triggering a backfill
+    tswHistAdaptiveResult *res,   // output
+    double *edges                 // [n_bins+1] output
+) {
+    memset(res, 0, sizeof(*res));
+    tswHistEdges(edges, n_bins);
+    size_t num_coarse = tswHistNumWindows(input_len, win_len, stride);
+    size_t tail_bin = (size_t)floor(tail * n_bins);
+
+    double *input_int = (double *)calloc(input_len, sizeof(double));
+    tswHistBinning(input_norm, input_len, n_bins, input_int);
+    double *bufferHist = (double *)calloc(n_bins, sizeof(double));
+    double *backHist   = (double *)malloc(n_bins * sizeof(double));
+    int ok = 1;
+
+    // First window
+    pushHist(bufferHist, input_int, win_len, n_bins);
+    double stat = tswHistAdaptiveStat(bufferHist, n_bins, criterion, tail_bin);
+    if ((ok = tswHistAdaptiveReserve(res, n_bins, 1)))
+        tswHistAdaptiveStore(res, res->num_windows++, bufferHist, n_bins, 0, stat);
+
+    for (size_t w = 1; ok && w < num_coarse; ++w) {
+        // pop then push (same schedule as tswHistSlidingWindow)
+        size_t base_pop = (w - 1) * stride;
+        popHist(bufferHist, &input_int[base_pop], stride, n_bins);
+        pushHist(bufferHist, &input_int[base_pop + win_len], stride, n_bins);
+        double prev_stat = stat;
+        stat = tswHistAdaptiveStat(bufferHist, n_bins, criterion, tail_bin);
+
+        // Backfill of the windows base_pop + k * fine_stride, 0 < k < n_fine
+        size_t start  = w * stride;
+        size_t n_fine = (fabs(stat - prev_stat) > threshold) ? (stride - 1) / fine_stride : 0;
+        if (!(ok = tswHistAdaptiveReserve(res, n_bins, n_fine + 1)))
+            break;
+        size_t first = res->num_windows;
+        tswHistAdaptiveStore(res, first + n_fine, bufferHist, n_bins, start, stat);
+        if (n_fine > 0) {
+            // Backwards from the current window to base_pop + n_fine * fine_stride,
+            // then by fine strides
+            memcpy(backHist, bufferHist, n_bins * sizeof(double));
+            size_t pos = start;
+            for (size_t k = n_fine; k > 0; --k) {
+                size_t target = base_pop + k * fine_stride;
+                pushHist(backHist, &input_int[target], pos - target, n_bins);
+                popHist(backHist, &input_int[target + win_len], pos - target, n_bins);
+                pos = target;
+                tswHistAdaptiveStore(res, first + k - 1, backHist, n_bins, pos,
+                                     tswHistAdaptiveStat(backHist, n_bins, criterion, tail_bin));
+            }
+        }
+        res->num_windows += n_fine + 1;
+    }
+
+    free(input_int);
+    free(bufferHist);
+    free(backHist);
+    return ok;
+}
+
+#endif // TSWHIST_ADAPTIVE_H
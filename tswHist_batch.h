@@ -0,0 +1,159 @@
+/*
+ * tswHist_batch.h - Batched bin updates of a histogram (SIMD kernels)
+ *
+ *   Applies the same delta (+1 for pushed samples, -1 for popped ones) to
+ *   the bins of a whole run of binned samples in one call, instead of one
+ *   pushHist/popHist call per sample. The run of a sliding window step
+ *   (stride samples popped, then stride samples pushed) can then be
+ *   vectorized:
+ *     - AVX-512 (F + CD): 8 bins at once are gathered, incremented by their
+ *       number of occurrences in the batch (vpconflictq gives, for every
+ *       lane, the earlier lanes holding the same bin) and scattered back;
+ *       the scatter writes the lanes in order, so the last occurrence of a
+ *       bin, which holds the full count, is the one kept;
+ *     - AVX2 (no scatter nor conflict detection): batches of 8 bins are
+ *       sorted in a register by a bitonic network, then every run of equal
+ *       bins is applied as one update, which removes the chains of dependent
+ *       read-modify-writes on the same bin;
+ *     - the scalar loop of pushHist (default).
+ *   Bins out of [0, n_bins) (or NaN) are ignored like in pushHist, and the
+ *   counts are integers in doubles, so all kernels give identical histograms.
+ *
+ *   The vector kernels only pay off when the bins repeat a lot within a
+ *   batch (e.g. a nearly constant signal): the scalar loop of a histogram
+ *   resident in L1 is otherwise faster than the gathers and scatters (resp.
+ *   the runs of the sorted batches): compare the timings of test_tswHist.m
+ *   across strides and bin distributions with each kernel. The scalar kernel
+ *   is thus the default, the others are selected at compile time with
+ *   -DTSWHIST_BATCH_KERNEL=2 (AVX-512) or 1 (AVX2) in SIMDFLAGS, along with
+ *   the matching instruction set (e.g. -march=native). A kernel whose
+ *   instruction set is not targeted falls back to the scalar one.
+ *
+ *   This header is pure C and is included by tswHist.h and tswHist_mx.h.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_BATCH_H
+#define TSWHIST_BATCH_H
+
+#include <stddef.h> // for size_t
+
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+#define TSWHIST_BATCH_AVX512 1
+#else
+#define TSWHIST_BATCH_AVX512 0
+#endif
+#if defined(__AVX2__)
+#define TSWHIST_BATCH_AVX2 1
+#else
+#define TSWHIST_BATCH_AVX2 0
+#endif
+#if TSWHIST_BATCH_AVX512 || TSWHIST_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+#ifndef TSWHIST_BATCH_KERNEL
+#define TSWHIST_BATCH_KERNEL 0 // 0: scalar, 1: AVX2 sorted batches, 2: AVX-512 conflict detection
+#endif
+
+// Reference scalar kernel
+void tswHistBatchUpdateScalar(double *hist_vec, const double *input_int, size_t len, size_t n_bins, double delta) {
+    for (size_t i = 0; i < len; ++i) {
+        int bin = (int)input_int[i];
+        if (bin >= 0 && bin < (int)n_bins)
+            hist_vec[bin] += delta;
+    }
+}
+
+#if TSWHIST_BATCH_AVX2
+// Stage of the bitonic network of 8 lanes: partner lanes given by perm,
+// lanes of imm (bit set) keep the max
+#define TSWHIST_BATCH_STAGE(v, perm, imm) do { \
+    __m256i p_ = _mm256_permutevar8x32_epi32(v, perm); \
+    (v) = _mm256_blend_epi32(_mm256_min_epi32(v, p_), _mm256_max_epi32(v, p_), imm); \
+} while (0)
+
+// Sorted bins of 8 samples, out of range ones (and NaN) set to -1
+static inline __m256i tswHistBatchSorted8(const double *input_int, __m256i n_bins_v) {
+    __m256i lo = _mm256_castsi128_si256(_mm256_cvttpd_epi32(_mm256_loadu_pd(input_int)));
+    __m256i v = _mm256_inserti128_si256(lo, _mm256_cvttpd_epi32(_mm256_loadu_pd(input_int + 4)), 1);
+    __m256i valid = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), v),
+                                        _mm256_cmpgt_epi32(n_bins_v, v));
+    v = _mm256_or_si256(v, _mm256_andnot_si256(valid, _mm256_set1_epi32(-1)));
+    const __m256i d1 = _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6);
+    const __m256i d2 = _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5);
+    const __m256i d4 = _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3);
+    TSWHIST_BATCH_STAGE(v, d1, 0x66);
+    TSWHIST_BATCH_STAGE(v, d2, 0x3C);
+    TSWHIST_BATCH_STAGE(v, d1, 0x5A);
+    TSWHIST_BATCH_STAGE(v, d4, 0xF0);
+    TSWHIST_BATCH_STAGE(v, d2, 0xCC);
+    TSWHIST_BATCH_STAGE(v, d1, 0xAA);
+    return v;
+}
+
+// AVX2 kernel: sorted batches of 8 bins, one update per run of equal bins
+void tswHistBatchUpdateSorted(double *hist_vec, const double *input_int, size_t len, size_t n_bins, double delta) {
+    const __m256i n_bins_v = _mm256_set1_epi32((int)n_bins);
+    int sorted[8];
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        _mm256_storeu_si256((__m256i *)sorted, tswHistBatchSorted8(&input_int[i], n_bins_v));
+        for (int k = 0; k < 8; ) {
+            int bin = sorted[k], run = 1;
+            while (k + run < 8 && sorted[k + run] == bin)
+                ++run;
+            if (bin >= 0)
+                hist_vec[bin] += delta * run;
+            k += run;
+        }
+    }
+    tswHistBatchUpdateScalar(hist_vec, &input_int[i], len - i, n_bins, delta);
+}
+#endif
+
+#if TSWHIST_BATCH_AVX512
+// AVX-512 kernel: gather, conflict-merged increments, scatter of 8 bins
+void tswHistBatchUpdateConflict(double *hist_vec, const double *input_int, size_t len, size_t n_bins, double delta) {
+    const __m512i n_bins_v = _mm512_set1_epi64((long long)n_bins);
+    const __m512i m1 = _mm512_set1_epi64(0x55), m2 = _mm512_set1_epi64(0x33), m4 = _mm512_set1_epi64(0x0f);
+    const __m512d delta_v = _mm512_set1_pd(delta);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        // NaN and out of int range give INT_MIN: invalid like the others
+        __m512i bins = _mm512_cvtepi32_epi64(_mm512_cvttpd_epi32(_mm512_loadu_pd(&input_int[i])));
+        __mmask8 valid = _mm512_cmpge_epi64_mask(bins, _mm512_setzero_si512())
+                       & _mm512_cmplt_epi64_mask(bins, n_bins_v);
+        // Occurrences of each bin up to its lane: 1 + popcount of the
+        // (at most 7) earlier lanes with the same bin
+        __m512i c = _mm512_conflict_epi64(bins);
+        c = _mm512_sub_epi64(c, _mm512_and_si512(_mm512_srli_epi64(c, 1), m1));
+        c = _mm512_add_epi64(_mm512_and_si512(c, m2), _mm512_and_si512(_mm512_srli_epi64(c, 2), m2));
+        c = _mm512_and_si512(_mm512_add_epi64(c, _mm512_srli_epi64(c, 4)), m4);
+        __m512d count = _mm512_cvtepi32_pd(_mm512_cvtepi64_epi32(c));
+        __m512d vals = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), valid, bins, hist_vec, 8);
+        vals = _mm512_add_pd(vals, _mm512_mul_pd(_mm512_add_pd(count, _mm512_set1_pd(1.0)), delta_v));
+        _mm512_mask_i64scatter_pd(hist_vec, valid, bins, vals, 8);
+    }
+    tswHistBatchUpdateScalar(hist_vec, &input_int[i], len - i, n_bins, delta);
+}
+#endif
+
+// Adds delta to the bins of input_int[0 .. len), with the selected kernel
+void tswHistBatchUpdate(double *hist_vec, const double *input_int, size_t len, size_t n_bins, double delta) {
+#if TSWHIST_BATCH_KERNEL == 2 && TSWHIST_BATCH_AVX512
+    tswHistBatchUpdateConflict(hist_vec, input_int, len, n_bins, delta);
+#elif TSWHIST_BATCH_KERNEL == 1 && TSWHIST_BATCH_AVX2
+    tswHistBatchUpdateSorted(hist_vec, input_int, len, n_bins, delta);
+#else
+    tswHistBatchUpdateScalar(hist_vec, input_int, len, n_bins, delta);
+#endif
+}
+
+#endif // TSWHIST_BATCH_H
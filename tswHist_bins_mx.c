@@ -0,0 +1,62 @@
+/*
+ * tswHist_bins_mx.c - Save a binned-index file for tswHist (MEX gateway)
+ *
+ *   Bins a normalized input once and saves the compact bin indices to a
+ *   binned-index file (see tswHist_binfile.h). The file can then be given
+ *   instead of the input to tswHist.m and tswHist_mx, which skip the binning
+ *   stage, for any win_len and stride at this n_bins.
+ *
+ *   Usage:
+ *     tswHist_bins_mx(path, input_norm, n_bins)
+ *     tswHist_bins_mx(path, input_norm, n_bins, range)
+ *
+ *   Inputs:
+ *     path       - Binned-index file to write
+ *     input_norm - Normalized input vector (real double, 1D) (in [0,1])
+ *     n_bins     - Number of histogram bins (integer > 2 and < 65535)
+ *     range      - (optional) original [min, max] of the samples before
+ *                  normalization, kept in the file header (default: [0 1])
+ *
+ *   See also: tswHist_binfile.h, tswHist.m, tswHist_mx.c
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#include "mex.h"
+#include "tswHist.h"
+#include "tswHist_binfile.h"
+
+/* Gateway function */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+    if (nrhs < 3 || nrhs > 4)
+        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: tswHist_bins_mx(path, input_norm, n_bins, range)");
+    if (!mxIsChar(prhs[0]))
+        mexErrMsgIdAndTxt("tswHist_mx:badPath", "Path must be a character vector.");
+    if (!mxIsDouble(prhs[1]) || mxIsComplex(prhs[1]))
+        mexErrMsgIdAndTxt("tswHist_mx:inputNotReal", "Input must be a real double vector.");
+
+    mwSize n_bins = (mwSize)mxGetScalar(prhs[2]);
+    if (n_bins <= 2 || tswHistBinFileElemBytes(n_bins) == 0)
+        mexErrMsgIdAndTxt("tswHist_mx:badBins", "Number of bins must be > 2 and < 65535.");
+    if (nrhs >= 4 && (!mxIsDouble(prhs[3]) || mxGetNumberOfElements(prhs[3]) != 2))
+        mexErrMsgIdAndTxt("tswHist_mx:badRange", "Range must be a [min, max] double vector.");
+
+    #if MX_HAS_INTERLEAVED_COMPLEX
+        const double *input_norm = mxGetDoubles(prhs[1]);
+        const double *range      = (nrhs >= 4) ? mxGetDoubles(prhs[3]) : NULL;
+    #else
+        const double *input_norm = mxGetPr(prhs[1]);
+        const double *range      = (nrhs >= 4) ? mxGetPr(prhs[3]) : NULL;
+    #endif
+
+    char *path = mxArrayToString(prhs[0]);
+    int ok = tswHistBinFileWrite(path, input_norm, mxGetNumberOfElements(prhs[1]), n_bins, range);
+    mxFree(path);
+    if (!ok)
+        mexErrMsgIdAndTxt("tswHist_mx:writeFailed", "Cannot write the binned-index file.");
+}
@@ -0,0 +1,155 @@
+/*
+ * tswHist_bitplane.h - Sliding histograms of few bins from packed bit-planes
+ *
+ *   Specialization of tswHist for small n_bins (up to TSWHIST_BITPLANE_MAX_BINS,
+ *   e.g. quantized status channels). The bin stream is converted into one
+ *   one-hot bit-plane per bin (bit i of plane b is set when sample i falls in
+ *   bin b), so that the count of a bin over any range of samples is the
+ *   popcount of the words of the range, with masks on the partial words at
+ *   both ends. The pop/push schedule of tswHistSlidingWindow then costs
+ *   O(stride/64) per bin instead of O(stride) scattered updates, and the
+ *   planes take n_bins/8 bytes per sample instead of the 8 bytes of the
+ *   binned doubles.
+ *
+ *   The word ranges are counted with AVX-512 VPOPCNTDQ when the compiler
+ *   targets it (e.g. -mavx512vpopcntdq or -march=native on a supporting
+ *   CPU), otherwise with the scalar popcount of the compiler.
+ *
+ *   tswHistBitplaneSelected tells when this engine is used by the MEX
+ *   gateways instead of tswHist: small n_bins and strides long enough for the
+ *   popcounts to beat the scattered updates.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_BITPLANE_H
+#define TSWHIST_BITPLANE_H
+
+#include <stdint.h>
+#include "tswHist.h"
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#include <immintrin.h>
+#define TSWHIST_BITPLANE_AVX512 1
+#else
+#define TSWHIST_BITPLANE_AVX512 0
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define tswHistPopcount64(x) ((size_t)__popcnt64(x))
+#else
+#define tswHistPopcount64(x) ((size_t)__builtin_popcountll(x))
+#endif
+
+#define TSWHIST_BITPLANE_MAX_BINS   16
+#define TSWHIST_BITPLANE_MIN_STRIDE 64   // samples popped/pushed per bin per window
+#define TSWHIST_BITPLANE_BLOCK      4096 // samples binned per block
+
+// Whether the bit-plane engine is used instead of tswHist
+int tswHistBitplaneSelected(size_t n_bins, size_t stride) {
+    return n_bins <= TSWHIST_BITPLANE_MAX_BINS && stride >= TSWHIST_BITPLANE_MIN_STRIDE;
+}
+
+// Popcount of n_words full words
+size_t tswHistBitplaneWords(const uint64_t *words, size_t n_words) {
+    size_t count = 0, w = 0;
+#if TSWHIST_BITPLANE_AVX512
+    __m512i acc = _mm512_setzero_si512();
+    for (; w + 8 <= n_words; w += 8)
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512((const void *)&words[w])));
+    if (w < n_words) {
+        __mmask8 tail = (__mmask8)((1u << (n_words - w)) - 1);
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail, &words[w])));
+        w = n_words;
+    }
+    count = (size_t)_mm512_reduce_add_epi64(acc);
+#endif
+    for (; w < n_words; ++w)
+        count += tswHistPopcount64(words[w]);
+    return count;
+}
+
+// Number of set bits of the plane over the samples [first, first+len)
+size_t tswHistBitplaneCount(const uint64_t *plane, size_t first, size_t len) {
+    if (len == 0)
+        return 0;
+    size_t last = first + len - 1;
+    size_t w0 = first >> 6, w1 = last >> 6;
+    uint64_t m0 = ~(uint64_t)0 << (first & 63);
+    uint64_t m1 = ~(uint64_t)0 >> (63 - (last & 63));
+    if (w0 == w1)
+        return tswHistPopcount64(plane[w0] & m0 & m1);
+    return tswHistPopcount64(plane[w0] & m0) + tswHistPopcount64(plane[w1] & m1)
+         + tswHistBitplaneWords(&plane[w0 + 1], w1 - w0 - 1);
+}
+
+// One-hot bit-planes ([n_bins x n_words], plane-major) of the bins of input_norm
+void tswHistBitplanes(const double *input_norm, size_t input_len, size_t n_bins,
+                      uint64_t *planes, size_t n_words) {
+    memset(planes, 0, n_bins * n_words * sizeof(uint64_t));
+    double block[TSWHIST_BITPLANE_BLOCK];
+    for (size_t i0 = 0; i0 < input_len; i0 += TSWHIST_BITPLANE_BLOCK) {
+        size_t m = (input_len - i0 < TSWHIST_BITPLANE_BLOCK) ? input_len - i0 : TSWHIST_BITPLANE_BLOCK;
+        tswHistBinning(&input_norm[i0], m, n_bins, block);
+        for (size_t j = 0; j < m; ++j) {
+            if (!(block[j] >= 0 && block[j] < (double)n_bins))
+                continue; // out of range samples are in no plane
+            size_t i = i0 + j;
+            planes[(size_t)block[j] * n_words + (i >> 6)] |= (uint64_t)1 << (i & 63);
+        }
+    }
+}
+
+void tswHistBitplaneSlidingWindow(
+    double *histMat,
+    const uint64_t *planes,
+    size_t n_words,
+    size_t num_windows,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride
+) {
+    size_t *counts = (size_t *)malloc(n_bins * sizeof(size_t));
+    // First window
+    for (size_t b = 0; b < n_bins; ++b) {
+        counts[b]  = tswHistBitplaneCount(&planes[b * n_words], 0, win_len);
+        histMat[b] = (double)counts[b];
+    }
+    for (size_t w = 1; w < num_windows; ++w) {
+        // pop then push (same schedule as tswHistSlidingWindow)
+        size_t base_pop = (w - 1) * stride;
+        for (size_t b = 0; b < n_bins; ++b) {
+            const uint64_t *plane = &planes[b * n_words];
+            counts[b] -= tswHistBitplaneCount(plane, base_pop, stride);
+            counts[b] += tswHistBitplaneCount(plane, base_pop + win_len, stride);
+            histMat[b + w * n_bins] = (double)counts[b];
+        }
+    }
+    free(counts);
+}
+
+void tswHistBitplane(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    size_t n_words = (input_len + 63) / 64;
+    uint64_t *planes = (uint64_t *)malloc(n_bins * n_words * sizeof(uint64_t));
+    tswHistBitplanes(input_norm, input_len, n_bins, planes, n_words);
+    tswHistBitplaneSlidingWindow(histMat, planes, n_words, num_windows, win_len, n_bins, stride);
+    free(planes);
+}
+
+#endif // TSWHIST_BITPLANE_H
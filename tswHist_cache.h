@@ -0,0 +1,403 @@
+/*
+ * tswHist_cache.h - Content-addressed on-disk cache of tswHist results
+ *
+ *   Opt-in cache layer for repeated runs of the engines on the same data.
+ *   A result is keyed by a fast 64-bit hash of the input bytes together with
+ *   n_bins, win_len, stride, the binning stage version, the output mode and a
+ *   hash of the mode parameters. The full key is stored in the file header
+ *   and checked on lookup, so hash collisions are never served.
+ *
+ *   Input hash: XXH64 (https://github.com/Cyan4973/xxHash) of fixed 1 MiB
+ *   chunks, hashed in parallel (OpenMP, when enabled), then XXH64 of the
+ *   chunk digests. The digest does not depend on the number of threads.
+ *
+ *   Files are stored in a compact form: integral results (e.g. histMat) are
+ *   stored as uint16 or uint32 when they fit, other results as doubles.
+ *   Writes go to a temporary file which is then renamed (atomic on POSIX),
+ *   so concurrent jobs can share a cache directory. Least recently used
+ *   entries (by modification time, refreshed on each hit) are evicted when
+ *   the directory exceeds its size cap.
+ *
+ *   The cache is only available on POSIX systems; elsewhere lookups always
+ *   miss and stores are no-ops.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_CACHE_H
+#define TSWHIST_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "tswHist.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#define TSWHIST_CACHE_ENABLED 1
+#else
+#define TSWHIST_CACHE_ENABLED 0
+#endif
+
+#define TSWHIST_CACHE_VERSION  1
+#define TSWHIST_CACHE_BINNING  1         // version of the binning stage (tswHistBinning)
+#define TSWHIST_HASH_CHUNK     (1 << 20) // bytes per independently hashed chunk
+#define TSWHIST_CACHE_EXT      ".tswc"
+
+/* ---------------------------------------------------------------------------
+ * XXH64
+ * ------------------------------------------------------------------------- */
+
+#define TSWHIST_XXH_P1 0x9E3779B185EBCA87ULL
+#define TSWHIST_XXH_P2 0xC2B2AE3D27D4EB4FULL
+#define TSWHIST_XXH_P3 0x165667B19E3779F9ULL
+#define TSWHIST_XXH_P4 0x85EBCA77C2B2AE63ULL
+#define TSWHIST_XXH_P5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t tswHistRotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t tswHistXxhRound(uint64_t acc, uint64_t input) {
+    acc += input * TSWHIST_XXH_P2;
+    acc  = tswHistRotl64(acc, 31);
+    return acc * TSWHIST_XXH_P1;
+}
+
+static inline uint64_t tswHistXxhMerge(uint64_t acc, uint64_t val) {
+    acc ^= tswHistXxhRound(0, val);
+    return acc * TSWHIST_XXH_P1 + TSWHIST_XXH_P4;
+}
+
+// XXH64 of len bytes (little-endian reads)
+uint64_t tswHistHash64(const void *data, size_t len, uint64_t seed) {
+    const unsigned char *p   = (const unsigned char *)data;
+    const unsigned char *end = p + len;
+    uint64_t h, k;
+    uint32_t k32;
+
+    if (len >= 32) {
+        // Four independent lanes: the compiler keeps them in flight together
+        uint64_t v1 = seed + TSWHIST_XXH_P1 + TSWHIST_XXH_P2;
+        uint64_t v2 = seed + TSWHIST_XXH_P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - TSWHIST_XXH_P1;
+        const unsigned char *limit = end - 32;
+        do {
+            uint64_t l[4];
+            memcpy(l, p, 32);
+            v1 = tswHistXxhRound(v1, l[0]);
+            v2 = tswHistXxhRound(v2, l[1]);
+            v3 = tswHistXxhRound(v3, l[2]);
+            v4 = tswHistXxhRound(v4, l[3]);
+            p += 32;
+        } while (p <= limit);
+        h = tswHistRotl64(v1, 1) + tswHistRotl64(v2, 7) + tswHistRotl64(v3, 12) + tswHistRotl64(v4, 18);
+        h = tswHistXxhMerge(h, v1);
+        h = tswHistXxhMerge(h, v2);
+        h = tswHistXxhMerge(h, v3);
+        h = tswHistXxhMerge(h, v4);
+    } else {
+        h = seed + TSWHIST_XXH_P5;
+    }
+    h += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        memcpy(&k, p, 8);
+        h ^= tswHistXxhRound(0, k);
+        h  = tswHistRotl64(h, 27) * TSWHIST_XXH_P1 + TSWHIST_XXH_P4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        memcpy(&k32, p, 4);
+        h ^= (uint64_t)k32 * TSWHIST_XXH_P1;
+        h  = tswHistRotl64(h, 23) * TSWHIST_XXH_P2 + TSWHIST_XXH_P3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * TSWHIST_XXH_P5;
+        h  = tswHistRotl64(h, 11) * TSWHIST_XXH_P1;
+        p++;
+    }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= TSWHIST_XXH_P2;
+    h ^= h >> 29;
+    h *= TSWHIST_XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Hash of a large buffer: XXH64 of the XXH64 digests of its 1 MiB chunks
+uint64_t tswHistHashInput(const void *data, size_t len) {
+    size_t n_chunks = (len + TSWHIST_HASH_CHUNK - 1) / TSWHIST_HASH_CHUNK;
+    if (n_chunks <= 1)
+        return tswHistHash64(data, len, 0);
+
+    uint64_t *digests = (uint64_t *)malloc(n_chunks * sizeof(uint64_t));
+    const unsigned char *p = (const unsigned char *)data;
+    #pragma omp parallel for schedule(static)
+    for (long long c = 0; c < (long long)n_chunks; ++c) {
+        size_t start = (size_t)c * TSWHIST_HASH_CHUNK;
+        size_t n     = (len - start < TSWHIST_HASH_CHUNK) ? len - start : TSWHIST_HASH_CHUNK;
+        digests[c]   = tswHistHash64(p + start, n, 0);
+    }
+    uint64_t h = tswHistHash64(digests, n_chunks * sizeof(uint64_t), (uint64_t)len);
+    free(digests);
+    return h;
+}
+
+/* ---------------------------------------------------------------------------
+ * Cache entries
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    uint64_t input_hash;  // tswHistHashInput of the input samples
+    uint64_t input_len;   // samples per channel
+    uint64_t n_channels;
+    uint64_t n_bins;
+    uint64_t win_len;
+    uint64_t stride;
+    uint64_t param_hash;  // hash of the mode parameters (0 if none)
+    char     mode[16];    // output mode name
+    uint32_t binning;     // TSWHIST_CACHE_BINNING
+    uint32_t reserved;
+} tswHistCacheKey;
+
+typedef struct {
+    char     magic[4];    // "TSWC"
+    uint32_t version;     // TSWHIST_CACHE_VERSION
+    tswHistCacheKey key;
+    uint64_t rows;
+    uint64_t cols;
+    uint32_t elem_bytes;  // 2 (uint16), 4 (uint32) or 8 (double)
+    uint32_t reserved;
+} tswHistCacheHeader;
+
+void tswHistCacheKeyInit(
+    tswHistCacheKey *key,
+    uint64_t input_hash, size_t input_len, size_t n_channels,
+    size_t n_bins, size_t win_len, size_t stride,
+    const char *mode, uint64_t param_hash
+) {
+    memset(key, 0, sizeof(*key)); // padding-free, compared with memcmp
+    key->input_hash = input_hash;
+    key->input_len  = input_len;
+    key->n_channels = n_channels;
+    key->n_bins     = n_bins;
+    key->win_len    = win_len;
+    key->stride     = stride;
+    key->param_hash = param_hash;
+    strncpy(key->mode, mode, sizeof(key->mode) - 1);
+    key->binning    = TSWHIST_CACHE_BINNING;
+}
+
+// Cache file of a key: <dir>/<16 hex digits of the key hash>.tswc
+void tswHistCachePath(char *path, size_t size, const char *dir, const tswHistCacheKey *key) {
+    snprintf(path, size, "%s/%016llx" TSWHIST_CACHE_EXT, dir,
+             (unsigned long long)tswHistHash64(key, sizeof(*key), 0));
+}
+
+// Smallest element size holding all values exactly
+uint32_t tswHistCacheElemBytes(const double *data, size_t n) {
+    double mx = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double v = data[i];
+        if (!(v >= 0) || v != floor(v))
+            return 8;
+        mx = (v > mx) ? v : mx;
+    }
+    return (mx <= 65535.0) ? 2 : (mx <= 4294967295.0) ? 4 : 8;
+}
+
+#if TSWHIST_CACHE_ENABLED
+
+// Returns 1 and fills out [rows x cols] on a hit, 0 on a miss
+int tswHistCacheLookup(const char *dir, const tswHistCacheKey *key, double *out, size_t rows, size_t cols) {
+    char path[4096];
+    tswHistCacheHeader hdr;
+    tswHistCachePath(path, sizeof(path), dir, key);
+
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    int hit = fread(&hdr, sizeof(hdr), 1, f) == 1
+           && memcmp(hdr.magic, "TSWC", 4) == 0
+           && hdr.version == TSWHIST_CACHE_VERSION
+           && memcmp(&hdr.key, key, sizeof(*key)) == 0
+           && hdr.rows == rows && hdr.cols == cols;
+    size_t n = rows * cols;
+    if (hit && hdr.elem_bytes == 8) {
+        hit = fread(out, sizeof(double), n, f) == n;
+    } else if (hit && (hdr.elem_bytes == 2 || hdr.elem_bytes == 4)) {
+        // Read the compact payload at the tail of out, then widen in place
+        // from the front (each double is written past the bytes it consumes)
+        unsigned char *raw = (unsigned char *)out + n * (8 - hdr.elem_bytes);
+        hit = fread(raw, hdr.elem_bytes, n, f) == n;
+        for (size_t i = 0; hit && i < n; ++i) {
+            if (hdr.elem_bytes == 2) { uint16_t v; memcpy(&v, raw + 2 * i, 2); out[i] = v; }
+            else                     { uint32_t v; memcpy(&v, raw + 4 * i, 4); out[i] = v; }
+        }
+    } else {
+        hit = 0;
+    }
+    fclose(f);
+    if (hit)
+        utimes(path, NULL); // refresh the entry for the LRU eviction
+    return hit;
+}
+
+typedef struct {
+    char   name[256];
+    off_t  size;
+    double mtime;
+} tswHistCacheEntry;
+
+#ifdef __APPLE__
+#define TSWHIST_MTIME(st) ((double)(st).st_mtimespec.tv_sec + 1e-9 * (st).st_mtimespec.tv_nsec)
+#else
+#define TSWHIST_MTIME(st) ((double)(st).st_mtim.tv_sec + 1e-9 * (st).st_mtim.tv_nsec)
+#endif
+
+int tswHistCacheEntryCmp(const void *a, const void *b) {
+    double ta = ((const tswHistCacheEntry *)a)->mtime, tb = ((const tswHistCacheEntry *)b)->mtime;
+    return (ta > tb) - (ta < tb);
+}
+
+// Remove least recently used entries, except keep, until the directory holds max_bytes
+void tswHistCacheEvict(const char *dir, size_t max_bytes, const char *keep) {
+    DIR *d = opendir(dir);
+    if (!d)
+        return;
+    size_t n = 0, cap = 64, total = 0;
+    tswHistCacheEntry *entries = (tswHistCacheEntry *)malloc(cap * sizeof(tswHistCacheEntry));
+    struct dirent *e;
+    char path[4096];
+    while ((e = readdir(d)) != NULL) {
+        size_t len = strlen(e->d_name);
+        struct stat st;
+        if (len < 5 || len >= 256 || e->d_name[0] == '.' || strcmp(e->d_name + len - 5, TSWHIST_CACHE_EXT) != 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (stat(path, &st) != 0)
+            continue;
+        if (n == cap) {
+            cap *= 2;
+            entries = (tswHistCacheEntry *)realloc(entries, cap * sizeof(tswHistCacheEntry));
+        }
+        memcpy(entries[n].name, e->d_name, len + 1);
+        entries[n].size  = st.st_size;
+        entries[n].mtime = (keep && strcmp(e->d_name, keep) == 0) ? INFINITY : TSWHIST_MTIME(st);
+        total += (size_t)st.st_size;
+        n++;
+    }
+    closedir(d);
+
+    if (total > max_bytes) {
+        qsort(entries, n, sizeof(tswHistCacheEntry), tswHistCacheEntryCmp);
+        for (size_t i = 0; i < n && total > max_bytes && entries[i].mtime != INFINITY; ++i) {
+            snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+            if (unlink(path) == 0)
+                total -= (size_t)entries[i].size;
+        }
+    }
+    free(entries);
+}
+
+// Store [rows x cols] data under key, then enforce the size cap. Returns 1 on success.
+int tswHistCacheStore(const char *dir, size_t max_bytes, const tswHistCacheKey *key,
+                      const double *data, size_t rows, size_t cols) {
+    static unsigned counter = 0;
+    char path[4096], tmp[4096];
+    tswHistCacheHeader hdr;
+    size_t n = rows * cols;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "TSWC", 4);
+    hdr.version    = TSWHIST_CACHE_VERSION;
+    hdr.key        = *key;
+    hdr.rows       = rows;
+    hdr.cols       = cols;
+    hdr.elem_bytes = tswHistCacheElemBytes(data, n);
+    if (sizeof(hdr) + n * hdr.elem_bytes > max_bytes)
+        return 0;
+
+    mkdir(dir, 0777); // may already exist
+    tswHistCachePath(path, sizeof(path), dir, key);
+    snprintf(tmp, sizeof(tmp), "%s/.%016llx.%ld.%u.tmp", dir,
+             (unsigned long long)tswHistHash64(key, sizeof(*key), 0), (long)getpid(), counter++);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0)
+        return 0;
+    FILE *f = fdopen(fd, "wb");
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+
+    // Narrow into a bounded buffer
+    unsigned char buf[1 << 16];
+    size_t per_buf = sizeof(buf) / hdr.elem_bytes;
+    for (size_t i0 = 0; ok && i0 < n; i0 += per_buf) {
+        size_t m = (n - i0 < per_buf) ? n - i0 : per_buf;
+        for (size_t i = 0; i < m; ++i) {
+            double v = data[i0 + i];
+            if (hdr.elem_bytes == 2)      { uint16_t u = (uint16_t)v; memcpy(buf + 2 * i, &u, 2); }
+            else if (hdr.elem_bytes == 4) { uint32_t u = (uint32_t)v; memcpy(buf + 4 * i, &u, 4); }
+            else                          { memcpy(buf + 8 * i, &v, 8); }
+        }
+        ok = fwrite(buf, hdr.elem_bytes, m, f) == m;
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return 0;
+    }
+    tswHistCacheEvict(dir, max_bytes, strrchr(path, '/') + 1);
+    return 1;
+}
+
+#else // !TSWHIST_CACHE_ENABLED
+
+int tswHistCacheLookup(const char *dir, const tswHistCacheKey *key, double *out, size_t rows, size_t cols) {
+    return 0;
+}
+
+int tswHistCacheStore(const char *dir, size_t max_bytes, const tswHistCacheKey *key,
+                      const double *data, size_t rows, size_t cols) {
+    return 0;
+}
+
+#endif // TSWHIST_CACHE_ENABLED
+
+// tswHist through the cache. Returns 1 if the result was served from the cache.
+int tswHistCached(
+    const char *cache_dir, size_t max_bytes,
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    tswHistCacheKey key;
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistCacheKeyInit(&key, tswHistHashInput(input_norm, input_len * sizeof(double)),
+                        input_len, 1, n_bins, win_len, stride, "hist", 0);
+    if (tswHistCacheLookup(cache_dir, &key, histMat, n_bins, num_windows)) {
+        tswHistLoci(strided_windows_loci, num_windows, stride);
+        tswHistEdges(edges, n_bins);
+        return 1;
+    }
+    tswHist(input_norm, input_len, n_bins, win_len, stride, histMat, strided_windows_loci, edges);
+    tswHistCacheStore(cache_dir, max_bytes, &key, histMat, n_bins, num_windows);
+    return 0;
+}
+
+#endif // TSWHIST_CACHE_H
@@ -0,0 +1,162 @@
+/*
+ * tswHist_codebook.h - Online assignment of window histograms to a codebook
+ *
+ *   Assigns every window histogram to the nearest of K prototype histograms
+ *   (bag-of-words features) without ever storing histMat. The K distances
+ *   between bufferHist and the prototypes are kept up to date on each
+ *   push/pop: a sample moving bin b by delta (+1 or -1) changes
+ *     squared L2  : D_k += delta * (2 * (h_b - P_bk) + delta)
+ *     dot product : D_k += delta * P_bk
+ *   so each window costs O(K * stride) updates plus the O(K) search of the
+ *   nearest prototype. The distances are recomputed from scratch every
+ *   TSWHIST_CODEBOOK_RESYNC windows to bound the rounding drift.
+ *
+ *   Prototypes are given as an [n_bins x K] (column-major) matrix, in counts
+ *   per window (scale probability prototypes by win_len).
+ *
+ *   Rows of codeMat: index of the nearest prototype (1-based), its distance
+ *   (squared L2) or its dot product ('dot' metric: the largest dot product is
+ *   the nearest).
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_CODEBOOK_H
+#define TSWHIST_CODEBOOK_H
+
+#include "tswHist.h"
+
+typedef enum {
+    TSWHIST_CODEBOOK_L2 = 0,
+    TSWHIST_CODEBOOK_DOT
+} tswHistCodebookMetric;
+
+#define TSWHIST_CODEBOOK_NROWS  2
+#define TSWHIST_CODEBOOK_RESYNC 4096 // windows between two exact recomputations
+
+// Exact distances of hist to the prototypes (protoT is [K x n_bins], bin-major)
+void tswHistCodebookDistances(
+    double *dist, const double *hist, const double *protoT,
+    size_t n_bins, size_t K, tswHistCodebookMetric metric
+) {
+    for (size_t k = 0; k < K; ++k)
+        dist[k] = 0;
+    for (size_t b = 0; b < n_bins; ++b) {
+        const double *p = &protoT[b * K];
+        double h = hist[b];
+        for (size_t k = 0; k < K; ++k)
+            dist[k] += (metric == TSWHIST_CODEBOOK_L2) ? (h - p[k]) * (h - p[k]) : h * p[k];
+    }
+}
+
+// Moves the samples input_int[first, first+len) in (delta = +1) or out (-1)
+void tswHistCodebookUpdate(
+    double *dist, double *bufferHist, const double *input_int,
+    size_t first, size_t len, const double *protoT,
+    size_t n_bins, size_t K, tswHistCodebookMetric metric, double delta
+) {
+    for (size_t i = first; i < first + len; ++i) {
+        int bin = (int)input_int[i];
+        if (bin < 0 || bin >= (int)n_bins)
+            continue;
+        const double *p = &protoT[(size_t)bin * K];
+        if (metric == TSWHIST_CODEBOOK_L2) {
+            double h = bufferHist[bin];
+            for (size_t k = 0; k < K; ++k)
+                dist[k] += delta * (2 * (h - p[k]) + delta);
+        } else {
+            for (size_t k = 0; k < K; ++k)
+                dist[k] += delta * p[k];
+        }
+        bufferHist[bin] += delta;
+    }
+}
+
+void tswHistCodebookSlidingWindow(
+    double *codeMat,
+    double *bufferHist,
+    const double *input_int,
+    size_t num_windows,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride,
+    const double *prototypes, // [n_bins x K]
+    size_t K,
+    tswHistCodebookMetric metric
+) {
+    // Bin-major copy: the K prototype values of a bin are contiguous
+    double *protoT = (double *)malloc(n_bins * K * sizeof(double));
+    double *dist   = (double *)malloc(K * sizeof(double));
+    for (size_t k = 0; k < K; ++k)
+        for (size_t b = 0; b < n_bins; ++b)
+            protoT[b * K + k] = prototypes[b + k * n_bins];
+
+    // First window
+    pushHist(bufferHist, input_int, win_len, n_bins);
+    tswHistCodebookDistances(dist, bufferHist, protoT, n_bins, K, metric);
+
+    for (size_t w = 0; w < num_windows; ++w) {
+        if (w > 0) {
+            // pop then push (same schedule as tswHistSlidingWindow)
+            size_t base_pop = (w - 1) * stride;
+            tswHistCodebookUpdate(dist, bufferHist, input_int, base_pop, stride,
+                                  protoT, n_bins, K, metric, -1);
+            tswHistCodebookUpdate(dist, bufferHist, input_int, base_pop + win_len, stride,
+                                  protoT, n_bins, K, metric, +1);
+            if (w % TSWHIST_CODEBOOK_RESYNC == 0)
+                tswHistCodebookDistances(dist, bufferHist, protoT, n_bins, K, metric);
+        }
+
+        // Nearest prototype
+        size_t best = 0;
+        for (size_t k = 1; k < K; ++k)
+            if ((metric == TSWHIST_CODEBOOK_L2) ? dist[k] < dist[best] : dist[k] > dist[best])
+                best = k;
+        codeMat[w * TSWHIST_CODEBOOK_NROWS]     = (double)(best + 1); // MATLAB 1-based
+        codeMat[w * TSWHIST_CODEBOOK_NROWS + 1] = dist[best];
+    }
+
+    free(protoT);
+    free(dist);
+}
+
+void tswHistCodebook(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    const double *prototypes, size_t K,
+    tswHistCodebookMetric metric,
+    double *codeMat,              // [2 x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    double *input_int = (double *)calloc(input_len, sizeof(double));
+    tswHistBinning(input_norm, input_len, n_bins, input_int);
+
+    double *bufferHist = (double *)calloc(n_bins, sizeof(double));
+    tswHistCodebookSlidingWindow(
+        codeMat,
+        bufferHist,
+        input_int,
+        num_windows,
+        win_len,
+        n_bins,
+        stride,
+        prototypes,
+        K,
+        metric
+    );
+
+    free(input_int);
+    free(bufferHist);
+}
+
+#endif // TSWHIST_CODEBOOK_H
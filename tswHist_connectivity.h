@@ -0,0 +1,350 @@
+/*
+ * tswHist_connectivity.h - Sliding all-pairs mutual information between channels
+ *
+ *   Computes, for every window, the mutual information (in nats) between every
+ *   pair of the n_channels channels of a [input_len x n_channels] input,
+ *   normalized in [0,1] like for tswHist. Every channel is binned once (sample
+ *   -major interleaving, see tswHist_pooled.h) and every pair keeps a joint
+ *   sliding histogram updated by push/pop like bufferHist.
+ *
+ *   The mutual information is kept up to date from the touched cells only:
+ *   with S = sum(n log n) over the cells of a histogram of N samples,
+ *     MI = (S_xy - S_x - S_y) / N + log N
+ *   and each push/pop changes S_xy, S_x and S_y by one table lookup each.
+ *
+ *   Joint histograms are sparse (open addressing on the occupied cells, at
+ *   most win_len of them) unless n_bins^2 cells are not larger than the hash
+ *   table, in which case they are dense. Pairs are processed in tiles of
+ *   TSWHIST_CONN_TILE x TSWHIST_CONN_TILE channels, so that a tile only reads
+ *   a few cache lines of each interleaved sample and its joint histograms stay
+ *   in cache while sliding over all the windows. Tiles are distributed over
+ *   the OpenMP threads (when enabled).
+ *
+ *   Output layouts:
+ *     full : [n_channels x n_channels x num_windows], symmetric, the diagonal
+ *            holds the entropy of each channel (MI of a channel with itself)
+ *     triu : [n_pairs x num_windows], n_pairs = n_channels*(n_channels-1)/2,
+ *            pairs (i, j), i < j, in the column-major order of the strict
+ *            upper triangle (MATLAB: M(triu(true(n_channels), 1)))
+ *
+ *   A sample only enters the histograms of a pair when both channels fall in
+ *   [0, n_bins). Cells are 32-bit keys, so n_bins is at most
+ *   TSWHIST_CONN_MAX_BINS (checked by the gateways).
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_CONNECTIVITY_H
+#define TSWHIST_CONNECTIVITY_H
+
+#include <stdint.h>
+#include "tswHist.h"
+#include "tswHist_pooled.h"
+
+#define TSWHIST_CONN_TILE  8           // channels per side of a tile of pairs
+#define TSWHIST_CONN_EMPTY 0xFFFFFFFFu // free slot of a sparse joint histogram
+#define TSWHIST_CONN_MAX_BINS 65535     // largest n_bins: cells x*n_bins+y stay below TSWHIST_CONN_EMPTY
+
+typedef enum {
+    TSWHIST_CONN_FULL = 0,
+    TSWHIST_CONN_TRIU
+} tswHistConnLayout;
+
+// Joint histogram of a pair with its marginals and running sums of n log n
+typedef struct {
+    uint32_t *keys;   // cell index x*n_bins+y of each slot, NULL when dense
+    uint32_t *counts; // joint counts (per slot, or per cell when dense)
+    uint32_t *hx;     // marginal counts of the first channel
+    uint32_t *hy;     // marginal counts of the second channel
+    size_t mask;      // number of slots - 1 (sparse)
+    unsigned shift;   // 64 - log2(number of slots) (sparse)
+    double S, Sx, Sy; // sum of n log n over the joint and marginal cells
+    double N;         // number of samples
+} tswHistJoint;
+
+size_t tswHistConnNumPairs(size_t n_channels) {
+    return n_channels * (n_channels - 1) / 2;
+}
+
+// Number of slots of a sparse joint histogram, 0 when dense is not larger
+size_t tswHistConnSlots(size_t win_len, size_t n_bins) {
+    size_t cells = n_bins * n_bins;
+    size_t occupied = (win_len < cells) ? win_len : cells;
+    size_t slots = 16;
+    while (slots < 2 * occupied)
+        slots <<= 1;
+    return (cells <= slots) ? 0 : slots;
+}
+
+void tswHistJointInit(tswHistJoint *jh, size_t n_bins, size_t slots) {
+    if (slots) {
+        jh->keys   = (uint32_t *)malloc(slots * sizeof(uint32_t));
+        jh->counts = (uint32_t *)calloc(slots, sizeof(uint32_t));
+        memset(jh->keys, 0xFF, slots * sizeof(uint32_t));
+        jh->mask   = slots - 1;
+        jh->shift  = 64;
+        while (slots > 1) {
+            slots >>= 1;
+            jh->shift--;
+        }
+    } else {
+        jh->keys   = NULL;
+        jh->counts = (uint32_t *)calloc(n_bins * n_bins, sizeof(uint32_t));
+        jh->mask   = 0;
+        jh->shift  = 0;
+    }
+    jh->hx = (uint32_t *)calloc(n_bins, sizeof(uint32_t));
+    jh->hy = (uint32_t *)calloc(n_bins, sizeof(uint32_t));
+    jh->S = jh->Sx = jh->Sy = jh->N = 0;
+}
+
+void tswHistJointFree(tswHistJoint *jh) {
+    free(jh->keys);
+    free(jh->counts);
+    free(jh->hx);
+    free(jh->hy);
+}
+
+// Home slot of a cell: high bits of a Fibonacci hash, which depend on all the
+// bits of x*n_bins+y (the low bits only depend on its low bits, and cluster
+// the probe chains when n_bins is a power of two)
+size_t tswHistJointHome(const tswHistJoint *jh, uint32_t cell) {
+    return (size_t)(((uint64_t)cell * 0x9E3779B97F4A7C15ULL) >> jh->shift);
+}
+
+// Count of cell incremented by delta (+1 or -1), returns the previous count
+uint32_t tswHistJointCell(tswHistJoint *jh, uint32_t cell, int delta) {
+    if (!jh->keys) {
+        uint32_t old = jh->counts[cell];
+        jh->counts[cell] = old + delta;
+        return old;
+    }
+    size_t s = tswHistJointHome(jh, cell);
+    while (jh->keys[s] != cell && jh->keys[s] != TSWHIST_CONN_EMPTY)
+        s = (s + 1) & jh->mask;
+    uint32_t old = (jh->keys[s] == cell) ? jh->counts[s] : 0;
+    if (old + delta > 0) {
+        jh->keys[s]   = cell;
+        jh->counts[s] = old + delta;
+        return old;
+    }
+    // Cell emptied: backward-shift deletion keeps the probe chains intact
+    size_t hole = s;
+    for (size_t t = (s + 1) & jh->mask; jh->keys[t] != TSWHIST_CONN_EMPTY; t = (t + 1) & jh->mask) {
+        size_t home = tswHistJointHome(jh, jh->keys[t]);
+        if (((t - home) & jh->mask) >= ((t - hole) & jh->mask)) {
+            jh->keys[hole]   = jh->keys[t];
+            jh->counts[hole] = jh->counts[t];
+            hole = t;
+        }
+    }
+    jh->keys[hole]   = TSWHIST_CONN_EMPTY;
+    jh->counts[hole] = 0;
+    return old;
+}
+
+// Push (delta = +1) or pop (delta = -1) the sample of bins (x, y).
+// nlogn[k] = k log k.
+void tswHistJointUpdate(tswHistJoint *jh, int x, int y, int delta, size_t n_bins, const double *nlogn) {
+    if (x < 0 || x >= (int)n_bins || y < 0 || y >= (int)n_bins)
+        return;
+    uint32_t old = tswHistJointCell(jh, (uint32_t)(x * n_bins + y), delta);
+    jh->S  += nlogn[old + delta] - nlogn[old];
+    old = jh->hx[x];
+    jh->hx[x] = old + delta;
+    jh->Sx += nlogn[old + delta] - nlogn[old];
+    old = jh->hy[y];
+    jh->hy[y] = old + delta;
+    jh->Sy += nlogn[old + delta] - nlogn[old];
+    jh->N  += delta;
+}
+
+double tswHistJointMI(const tswHistJoint *jh) {
+    if (jh->N <= 0)
+        return NAN;
+    double mi = (jh->S - jh->Sx - jh->Sy) / jh->N + log(jh->N);
+    return (mi > 0) ? mi : 0; // rounding of the running sums
+}
+
+// Output index of pair (i, j), i < j, for window w
+size_t tswHistConnIndex(size_t i, size_t j, size_t w, size_t n_channels, tswHistConnLayout layout) {
+    if (layout == TSWHIST_CONN_TRIU)
+        return j * (j - 1) / 2 + i + w * tswHistConnNumPairs(n_channels);
+    return i + j * n_channels + w * n_channels * n_channels;
+}
+
+// Slides the pairs (pi[k], pj[k]) of a tile over all the windows
+void tswHistConnTile(
+    double *miMat,
+    const double *input_int, // interleaved [n_channels x input_len]
+    const size_t *pi, const size_t *pj, size_t n_tile_pairs,
+    size_t num_windows, size_t win_len, size_t n_bins, size_t stride,
+    size_t n_channels, tswHistConnLayout layout, const double *nlogn
+) {
+    size_t slots = tswHistConnSlots(win_len, n_bins);
+    tswHistJoint *jh = (tswHistJoint *)malloc(n_tile_pairs * sizeof(tswHistJoint));
+    for (size_t k = 0; k < n_tile_pairs; ++k)
+        tswHistJointInit(&jh[k], n_bins, slots);
+
+    for (size_t w = 0; w < num_windows; ++w) {
+        for (size_t k = 0; k < n_tile_pairs; ++k) {
+            tswHistJoint *h = &jh[k];
+            size_t i = pi[k], j = pj[k];
+            if (w == 0) {
+                for (size_t s = 0; s < win_len; ++s) {
+                    const double *row = &input_int[s * n_channels];
+                    tswHistJointUpdate(h, (int)row[i], (int)row[j], +1, n_bins, nlogn);
+                }
+            } else {
+                // pop then push (same schedule as tswHistSlidingWindow)
+                size_t base_pop  = (w - 1) * stride;
+                size_t base_push = base_pop + win_len;
+                for (size_t s = 0; s < stride; ++s) {
+                    const double *row = &input_int[(base_pop + s) * n_channels];
+                    tswHistJointUpdate(h, (int)row[i], (int)row[j], -1, n_bins, nlogn);
+                }
+                for (size_t s = 0; s < stride; ++s) {
+                    const double *row = &input_int[(base_push + s) * n_channels];
+                    tswHistJointUpdate(h, (int)row[i], (int)row[j], +1, n_bins, nlogn);
+                }
+            }
+            double mi = tswHistJointMI(h);
+            miMat[tswHistConnIndex(i, j, w, n_channels, layout)] = mi;
+            if (layout == TSWHIST_CONN_FULL)
+                miMat[j + i * n_channels + w * n_channels * n_channels] = mi;
+        }
+    }
+
+    for (size_t k = 0; k < n_tile_pairs; ++k)
+        tswHistJointFree(&jh[k]);
+    free(jh);
+}
+
+// Push (delta = +1) or pop (delta = -1) the samples [first, first+n) of channel c
+void tswHistConnChannelUpdate(
+    uint32_t *hist, double *S, double *N, const double *input_int,
+    size_t first, size_t n, size_t c, size_t n_channels, size_t n_bins,
+    int delta, const double *nlogn
+) {
+    for (size_t s = first; s < first + n; ++s) {
+        int bin = (int)input_int[s * n_channels + c];
+        if (bin >= 0 && bin < (int)n_bins) {
+            uint32_t old = hist[bin];
+            hist[bin] = old + delta;
+            *S += nlogn[old + delta] - nlogn[old];
+            *N += delta;
+        }
+    }
+}
+
+// Entropy of every channel on the diagonal of the full layout
+void tswHistConnDiagonal(
+    double *miMat, const double *input_int,
+    size_t num_windows, size_t win_len, size_t n_bins, size_t stride,
+    size_t n_channels, const double *nlogn
+) {
+    #pragma omp parallel for schedule(static)
+    for (long long c = 0; c < (long long)n_channels; ++c) {
+        uint32_t *hist = (uint32_t *)calloc(n_bins, sizeof(uint32_t));
+        double S = 0, N = 0;
+        tswHistConnChannelUpdate(hist, &S, &N, input_int, 0, win_len, c, n_channels, n_bins, +1, nlogn);
+        for (size_t w = 0; w < num_windows; ++w) {
+            if (w > 0) {
+                size_t base_pop = (w - 1) * stride;
+                tswHistConnChannelUpdate(hist, &S, &N, input_int, base_pop, stride, c, n_channels, n_bins, -1, nlogn);
+                tswHistConnChannelUpdate(hist, &S, &N, input_int, base_pop + win_len, stride, c, n_channels, n_bins, +1, nlogn);
+            }
+            double h = (N > 0) ? log(N) - S / N : NAN;
+            miMat[c + c * n_channels + w * n_channels * n_channels] = (h > 0 || isnan(h)) ? h : 0;
+        }
+        free(hist);
+    }
+}
+
+void tswHistConnectivitySlidingWindow(
+    double *miMat,
+    const double *input_int, // interleaved [n_channels x input_len]
+    size_t num_windows,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride,
+    size_t n_channels,
+    tswHistConnLayout layout
+) {
+    // n log n table, counts never exceed win_len
+    double *nlogn = (double *)malloc((win_len + 1) * sizeof(double));
+    nlogn[0] = 0;
+    for (size_t k = 1; k <= win_len; ++k)
+        nlogn[k] = (double)k * log((double)k);
+
+    // Pairs ordered by tiles of channel blocks (bi <= bj)
+    size_t n_pairs  = tswHistConnNumPairs(n_channels);
+    size_t n_blocks = (n_channels + TSWHIST_CONN_TILE - 1) / TSWHIST_CONN_TILE;
+    size_t n_tiles  = n_blocks * (n_blocks + 1) / 2;
+    size_t *pi = (size_t *)malloc((n_pairs + 1) * sizeof(size_t));
+    size_t *pj = (size_t *)malloc((n_pairs + 1) * sizeof(size_t));
+    size_t *tile_start = (size_t *)malloc((n_tiles + 1) * sizeof(size_t));
+    size_t p = 0, t = 0;
+    for (size_t bj = 0; bj < n_blocks; ++bj) {
+        for (size_t bi = 0; bi <= bj; ++bi) {
+            tile_start[t++] = p;
+            for (size_t j = bj * TSWHIST_CONN_TILE; j < (bj + 1) * TSWHIST_CONN_TILE && j < n_channels; ++j)
+                for (size_t i = bi * TSWHIST_CONN_TILE; i < (bi + 1) * TSWHIST_CONN_TILE && i < j; ++i) {
+                    pi[p] = i;
+                    pj[p] = j;
+                    ++p;
+                }
+        }
+    }
+    tile_start[n_tiles] = p;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (long long k = 0; k < (long long)n_tiles; ++k) {
+        size_t first = tile_start[k];
+        tswHistConnTile(miMat, input_int, &pi[first], &pj[first], tile_start[k + 1] - first,
+                        num_windows, win_len, n_bins, stride, n_channels, layout, nlogn);
+    }
+    if (layout == TSWHIST_CONN_FULL)
+        tswHistConnDiagonal(miMat, input_int, num_windows, win_len, n_bins, stride, n_channels, nlogn);
+
+    free(nlogn);
+    free(pi);
+    free(pj);
+    free(tile_start);
+}
+
+void tswHistConnectivity(
+    const double *input_norm, size_t input_len, size_t n_channels,
+    size_t n_bins, size_t win_len, size_t stride,
+    tswHistConnLayout layout,
+    double *miMat,                // [n_channels x n_channels x num_windows] or [n_pairs x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    double *input_int = (double *)calloc(input_len * n_channels, sizeof(double));
+    tswHistBinningInterleaved(input_norm, input_len, n_channels, n_bins, input_int);
+
+    tswHistConnectivitySlidingWindow(
+        miMat,
+        input_int,
+        num_windows,
+        win_len,
+        n_bins,
+        stride,
+        n_channels,
+        layout
+    );
+
+    free(input_int);
+}
+
+#endif // TSWHIST_CONNECTIVITY_H
@@ -0,0 +1,182 @@
+/*
+ * tswHist_exact.h - Exact (binless) sliding quantiles of the raw values
+ *
+ *   Computes exact sliding medians and percentiles of the raw double values,
+ *   without the 1/n_bins quantization of the histogram engines. The input is
+ *   sorted once and every sample is replaced by its rank (ties broken by
+ *   position), so that a window is a set of distinct ranks: its "histogram"
+ *   over one bin per rank is kept in a Fenwick tree (binary indexed tree),
+ *   a flat array order-statistic structure supporting insert, delete and
+ *   select of the k-th smallest in O(log input_len). The window content is
+ *   updated with the same strided pop/push schedule as tswHistSlidingWindow,
+ *   with matching strided_windows_loci.
+ *
+ *   Quantiles follow the default definition of MATLAB's prctile/quantile:
+ *   the sorted window values are placed at the probabilities (i-0.5)/n and
+ *   linearly interpolated (clamped to the min and max), so that p = 0.5 is
+ *   the median of movmedian. A window holding a NaN gives NaN (like
+ *   movmedian's default 'includenan').
+ *
+ *   Ranks and counts are stored as uint32: input_len must be < 2^32.
+ *
+ *   Tiny windows (tswHistTinySelected) are dispatched by tswHistExact to the
+ *   sorted-window engine of tswHist_tiny.h, with identical results.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_EXACT_H
+#define TSWHIST_EXACT_H
+
+#include <stdint.h>
+#include "tswHist.h"
+#include "tswHist_tiny.h"
+
+// Sorting of the sample indices by value, NaNs last, ties by position
+typedef struct {
+    double   value;
+    uint32_t index;
+} tswHistExactSample;
+
+int tswHistExactCmp(const void *a, const void *b) {
+    const tswHistExactSample *x = (const tswHistExactSample *)a, *y = (const tswHistExactSample *)b;
+    int xn = isnan(x->value), yn = isnan(y->value);
+    if (xn != yn)
+        return xn - yn;
+    if (!xn && x->value != y->value)
+        return (x->value > y->value) - (x->value < y->value);
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+// Fenwick tree of the window ranks (1-based tree over input_len ranks)
+void tswHistExactUpdate(uint32_t *tree, size_t n, size_t rank, int delta) {
+    for (size_t i = rank + 1; i <= n; i += i & (~i + 1))
+        tree[i] += delta;
+}
+
+// Rank of the k-th smallest (k >= 1) sample of the window
+size_t tswHistExactSelect(const uint32_t *tree, size_t n, size_t top, size_t k) {
+    size_t pos = 0;
+    for (size_t step = top; step > 0; step >>= 1) {
+        if (pos + step <= n && tree[pos + step] < k) {
+            pos += step;
+            k -= tree[pos];
+        }
+    }
+    return pos; // 0-based rank
+}
+
+void tswHistExactSlidingWindow(
+    double *quantMat,
+    const double *input,
+    size_t input_len,
+    size_t num_windows,
+    size_t win_len,
+    size_t stride,
+    const double *probs,
+    size_t n_probs
+) {
+    // Ranks of the samples and values of the ranks
+    tswHistExactSample *sorted = (tswHistExactSample *)malloc(input_len * sizeof(tswHistExactSample));
+    for (size_t i = 0; i < input_len; ++i) {
+        sorted[i].value = input[i];
+        sorted[i].index = (uint32_t)i;
+    }
+    qsort(sorted, input_len, sizeof(tswHistExactSample), tswHistExactCmp);
+    uint32_t *rank   = (uint32_t *)malloc(input_len * sizeof(uint32_t));
+    double   *values = (double *)malloc(input_len * sizeof(double));
+    for (size_t r = 0; r < input_len; ++r) {
+        rank[sorted[r].index] = (uint32_t)r;
+        values[r] = sorted[r].value;
+    }
+    free(sorted);
+
+    uint32_t *tree = (uint32_t *)calloc(input_len + 1, sizeof(uint32_t));
+    size_t top = 1;
+    while (top * 2 <= input_len)
+        top *= 2;
+    size_t nans = 0;
+
+    // First window
+    for (size_t i = 0; i < win_len; ++i) {
+        if (isnan(input[i])) nans++;
+        else tswHistExactUpdate(tree, input_len, rank[i], +1);
+    }
+
+    for (size_t w = 0; w < num_windows; ++w) {
+        if (w > 0) {
+            // pop then push (same schedule as tswHistSlidingWindow)
+            size_t base_pop  = (w - 1) * stride;
+            size_t base_push = base_pop + win_len;
+            for (size_t j = 0; j < stride; ++j) {
+                size_t i = base_pop + j;
+                if (isnan(input[i])) nans--;
+                else tswHistExactUpdate(tree, input_len, rank[i], -1);
+            }
+            for (size_t j = 0; j < stride; ++j) {
+                size_t i = base_push + j;
+                if (isnan(input[i])) nans++;
+                else tswHistExactUpdate(tree, input_len, rank[i], +1);
+            }
+        }
+
+        // Quantiles of the n samples of the window
+        size_t n = win_len - nans;
+        for (size_t q = 0; q < n_probs; ++q) {
+            double *out = &quantMat[q + w * n_probs];
+            if (nans > 0 || n == 0) {
+                *out = NAN;
+                continue;
+            }
+            double pos = (double)n * probs[q] + 0.5; // 1-based position in the sorted window
+            if (pos <= 1) {
+                *out = values[tswHistExactSelect(tree, input_len, top, 1)];
+            } else if (pos >= (double)n) {
+                *out = values[tswHistExactSelect(tree, input_len, top, n)];
+            } else {
+                size_t lo = (size_t)floor(pos);
+                double frac = pos - (double)lo;
+                double v_lo = values[tswHistExactSelect(tree, input_len, top, lo)];
+                double v_hi = (frac > 0) ? values[tswHistExactSelect(tree, input_len, top, lo + 1)] : v_lo;
+                *out = v_lo + frac * (v_hi - v_lo);
+            }
+        }
+    }
+
+    free(rank);
+    free(values);
+    free(tree);
+}
+
+void tswHistExact(
+    const double *input, size_t input_len,
+    size_t win_len, size_t stride,
+    const double *probs, size_t n_probs,
+    double *quantMat,             // [n_probs x num_windows] output
+    double *strided_windows_loci  // [num_windows] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+
+    if (tswHistTinySelected(win_len)) {
+        tswHistTinySlidingWindow(quantMat, input, num_windows, win_len, stride, probs, n_probs);
+        return;
+    }
+    tswHistExactSlidingWindow(
+        quantMat,
+        input,
+        input_len,
+        num_windows,
+        win_len,
+        stride,
+        probs,
+        n_probs
+    );
+}
+
+#endif // TSWHIST_EXACT_H
@@ -0,0 +1,219 @@
+/*
+ * tswHist_glcm.h - Sliding gray-level co-occurrence matrices of image patches
+ *
+ *   Computes the Haralick features (contrast, correlation, energy and
+ *   homogeneity, as graycoprops) of the gray-level co-occurrence matrices
+ *   (GLCM, as graycomatrix) of sliding patches of an image, for a set of
+ *   pixel pair offsets. A pair (r,c) -> (r+dr,c+dc) is counted when both of
+ *   its pixels are in the patch, so the pairs of a patch are a rectangle of
+ *   anchor pixels: when the patch slides right by stride columns, only the
+ *   anchor columns leaving and entering the patch are popped and pushed,
+ *   like the samples of tswHistSlidingWindow.
+ *
+ *   The features are kept up to date from the touched cells only: the sums
+ *   of the levels, of their squares and products, of the squared cells
+ *   (energy) and the histogram of |i-j| (contrast, homogeneity) are all
+ *   updated in O(1) per pair, so each patch costs O(patch_rows * stride)
+ *   updates plus O(n_levels) for the features, never O(n_levels^2).
+ *
+ *   Patch rows (row bands of the image) are independent and computed by
+ *   OpenMP threads (when enabled), each with its own GLCMs.
+ *
+ *   The image is column-major ([rows x cols], as MATLAB) and normalized in
+ *   [0,1]: the gray level of a pixel is its bin out of n_levels (see
+ *   tswHistBinning), pixels out of [0,1] (or NaN) are left out of the pairs.
+ *   Offsets are given as an [n_offsets x 2] (column-major) matrix of [dr dc]
+ *   rows, as the 'Offset' of graycomatrix (default: [0 1]).
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_GLCM_H
+#define TSWHIST_GLCM_H
+
+#include <stdint.h>
+#include "tswHist.h"
+
+#define TSWHIST_GLCM_NFEATURES 4 // contrast, correlation, energy, homogeneity
+
+// GLCM of one offset over the current patch, with its running sums
+typedef struct {
+    uint32_t *glcm;   // [n_levels x n_levels] pair counts (row: first pixel)
+    double   *diff;   // [n_levels] pair counts by |i-j|
+    double    n, si, sj, sii, sjj, sij; // pairs, sums of i, j, i^2, j^2, i*j
+    double    energy; // sum of the squared counts
+} tswHistGlcmState;
+
+void tswHistGlcmReset(tswHistGlcmState *s, size_t n_levels) {
+    memset(s->glcm, 0, n_levels * n_levels * sizeof(uint32_t));
+    memset(s->diff, 0, n_levels * sizeof(double));
+    s->n = s->si = s->sj = s->sii = s->sjj = s->sij = s->energy = 0;
+}
+
+// Moves the pair (a,b) in (delta = +1) or out (-1) of the GLCM
+void tswHistGlcmPair(tswHistGlcmState *s, int a, int b, size_t n_levels, int delta) {
+    uint32_t *cell = &s->glcm[(size_t)a * n_levels + b];
+    s->energy += delta * (2.0 * *cell + delta);
+    *cell     += delta;
+    s->diff[(a > b) ? a - b : b - a] += delta;
+    s->n   += delta;
+    s->si  += delta * a;
+    s->sj  += delta * b;
+    s->sii += delta * (double)a * a;
+    s->sjj += delta * (double)b * b;
+    s->sij += delta * (double)a * b;
+}
+
+// Moves the pairs anchored at the rows [r_begin, r_end) of column c
+void tswHistGlcmColumn(
+    tswHistGlcmState *s, const int *levels, size_t rows,
+    size_t r_begin, size_t r_end, size_t c, long dr, long dc,
+    size_t n_levels, int symmetric, int delta
+) {
+    const int *first  = &levels[c * rows];
+    const int *second = &levels[(size_t)((long)c + dc) * rows];
+    for (size_t r = r_begin; r < r_end; ++r) {
+        int a = first[r], b = second[(long)r + dr];
+        if (a < 0 || b < 0)
+            continue;
+        tswHistGlcmPair(s, a, b, n_levels, delta);
+        if (symmetric)
+            tswHistGlcmPair(s, b, a, n_levels, delta);
+    }
+}
+
+// Features of the GLCM (graycoprops definitions, NaN for an empty GLCM)
+void tswHistGlcmFeatures(const tswHistGlcmState *s, size_t n_levels, double *feat) {
+    double contrast = 0, homogeneity = 0;
+    for (size_t k = 0; k < n_levels; ++k) {
+        contrast    += s->diff[k] * (double)(k * k);
+        homogeneity += s->diff[k] / (double)(1 + k);
+    }
+    // Integer numerators of the covariance and variances (exact)
+    double cov = s->n * s->sij - s->si * s->sj;
+    double vi  = s->n * s->sii - s->si * s->si;
+    double vj  = s->n * s->sjj - s->sj * s->sj;
+    feat[0] = contrast / s->n;
+    feat[1] = cov / sqrt(vi * vj);
+    feat[2] = s->energy / (s->n * s->n);
+    feat[3] = homogeneity / s->n;
+}
+
+void tswHistGlcmSlidingWindow(
+    double *featMat,          // [4 x n_offsets x n_patch_rows x n_patch_cols]
+    tswHistGlcmState *states, // [n_offsets]
+    const int *levels,
+    size_t rows,
+    size_t n_levels,
+    size_t patch_row,         // index of the patch row
+    size_t n_patch_rows,
+    size_t n_patch_cols,
+    size_t patch_rows, size_t patch_cols,
+    size_t stride_rows, size_t stride_cols,
+    const double *offsets, size_t n_offsets,
+    int symmetric
+) {
+    size_t r0 = patch_row * stride_rows;
+    for (size_t o = 0; o < n_offsets; ++o) {
+        long dr = (long)offsets[o], dc = (long)offsets[o + n_offsets];
+        // Anchors of the pairs in the patch
+        size_t r_begin = r0 + (size_t)(dr < 0 ? -dr : 0);
+        size_t r_end   = r0 + patch_rows - (size_t)(dr > 0 ? dr : 0);
+        size_t c_begin = (size_t)(dc < 0 ? -dc : 0);
+        size_t c_end   = patch_cols - (size_t)(dc > 0 ? dc : 0);
+        tswHistGlcmState *s = &states[o];
+
+        // First patch of the row
+        tswHistGlcmReset(s, n_levels);
+        for (size_t c = c_begin; c < c_end; ++c)
+            tswHistGlcmColumn(s, levels, rows, r_begin, r_end, c, dr, dc, n_levels, symmetric, +1);
+
+        for (size_t w = 0; w < n_patch_cols; ++w) {
+            if (w > 0) {
+                // pop the anchor columns leaving the patch, push the entering ones
+                size_t pop_end    = (c_begin + stride_cols < c_end) ? c_begin + stride_cols : c_end;
+                size_t push_begin = (c_begin + stride_cols > c_end) ? c_begin + stride_cols : c_end;
+                for (size_t c = c_begin; c < pop_end; ++c)
+                    tswHistGlcmColumn(s, levels, rows, r_begin, r_end, c, dr, dc, n_levels, symmetric, -1);
+                for (size_t c = push_begin; c < c_end + stride_cols; ++c)
+                    tswHistGlcmColumn(s, levels, rows, r_begin, r_end, c, dr, dc, n_levels, symmetric, +1);
+                c_begin += stride_cols;
+                c_end   += stride_cols;
+            }
+            tswHistGlcmFeatures(s, n_levels,
+                &featMat[TSWHIST_GLCM_NFEATURES * (o + n_offsets * (patch_row + n_patch_rows * w))]);
+        }
+    }
+}
+
+// Returns 0 if an offset is not an integer pair within the patch
+int tswHistGlcmValidOffsets(const double *offsets, size_t n_offsets,
+                            size_t patch_rows, size_t patch_cols) {
+    for (size_t o = 0; o < n_offsets; ++o) {
+        double dr = offsets[o], dc = offsets[o + n_offsets];
+        if (dr != floor(dr) || dc != floor(dc)
+            || fabs(dr) >= (double)patch_rows || fabs(dc) >= (double)patch_cols)
+            return 0;
+    }
+    return 1;
+}
+
+void tswHistGlcm(
+    const double *image_norm, size_t rows, size_t cols,
+    size_t n_levels,
+    size_t patch_rows, size_t patch_cols,
+    size_t stride_rows, size_t stride_cols,
+    const double *offsets, size_t n_offsets, // [n_offsets x 2]
+    int symmetric,
+    size_t n_threads,             // 0: OpenMP default
+    double *featMat,              // [4 x n_offsets x n_patch_rows x n_patch_cols] output
+    double *patch_row_loci,       // [n_patch_rows] output
+    double *patch_col_loci        // [n_patch_cols] output
+) {
+    size_t n_patch_rows = tswHistNumWindows(rows, patch_rows, stride_rows);
+    size_t n_patch_cols = tswHistNumWindows(cols, patch_cols, stride_cols);
+    tswHistLoci(patch_row_loci, n_patch_rows, stride_rows);
+    tswHistLoci(patch_col_loci, n_patch_cols, stride_cols);
+
+    // Gray levels, -1 for the pixels left out
+    size_t n_pixels = rows * cols;
+    double *image_int = (double *)malloc(n_pixels * sizeof(double));
+    int    *levels    = (int *)malloc(n_pixels * sizeof(int));
+    tswHistBinning(image_norm, n_pixels, n_levels, image_int);
+    for (size_t i = 0; i < n_pixels; ++i)
+        levels[i] = (image_int[i] >= 0 && image_int[i] < (double)n_levels) ? (int)image_int[i] : -1;
+    free(image_int);
+
+    size_t n_bands = tswHistNumThreads(n_threads);
+    if (n_bands > n_patch_rows)
+        n_bands = n_patch_rows;
+
+    #pragma omp parallel num_threads((int)n_bands)
+    {
+        tswHistGlcmState *states = (tswHistGlcmState *)malloc(n_offsets * sizeof(tswHistGlcmState));
+        for (size_t o = 0; o < n_offsets; ++o) {
+            states[o].glcm = (uint32_t *)malloc(n_levels * n_levels * sizeof(uint32_t));
+            states[o].diff = (double *)malloc(n_levels * sizeof(double));
+        }
+        #pragma omp for schedule(dynamic)
+        for (long long p = 0; p < (long long)n_patch_rows; ++p)
+            tswHistGlcmSlidingWindow(featMat, states, levels, rows, n_levels,
+                                     (size_t)p, n_patch_rows, n_patch_cols,
+                                     patch_rows, patch_cols, stride_rows, stride_cols,
+                                     offsets, n_offsets, symmetric);
+        for (size_t o = 0; o < n_offsets; ++o) {
+            free(states[o].glcm);
+            free(states[o].diff);
+        }
+        free(states);
+    }
+
+    free(levels);
+}
+
+#endif // TSWHIST_GLCM_H
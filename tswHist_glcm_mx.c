@@ -0,0 +1,112 @@
+/*
+ * tswHist_glcm_mx.c - Sliding GLCM texture features of image patches (MEX gateway)
+ *
+ *   Haralick features of the gray-level co-occurrence matrices of sliding
+ *   patches of an image, updated incrementally from the pixel columns
+ *   entering and leaving each patch (see tswHist_glcm.h). Equivalent to
+ *   graycoprops(graycomatrix(patch, 'NumLevels', n_levels, 'Offset', offsets,
+ *   'Symmetric', symmetric)) on every patch, with the gray levels of
+ *   tswHist's binning.
+ *
+ *   Usage:
+ *     [featMat, patch_row_loci, patch_col_loci] = tswHist_glcm_mx(image_norm, n_levels, patch, stride)
+ *     [featMat, patch_row_loci, patch_col_loci] = tswHist_glcm_mx(image_norm, n_levels, patch, stride, offsets, symmetric)
+ *
+ *   Inputs:
+ *     image_norm - Normalized image (real double matrix) (in [0,1]), pixels
+ *                  out of [0,1] or NaN are left out of the pairs
+ *     n_levels   - Number of gray levels (integer > 1 and <= 4096)
+ *     patch      - Patch size, [patch_rows patch_cols] or a scalar for square
+ *                  patches
+ *     stride     - (optional) Patch stride, [stride_rows stride_cols] or a
+ *                  scalar (default: 1)
+ *     offsets    - (optional) [n_offsets x 2] matrix of pixel pair offsets
+ *                  [dr dc], within the patch (default: [0 1])
+ *     symmetric  - (optional) true to count each pair both ways (default:
+ *                  false)
+ *
+ *   Outputs:
+ *     featMat        - 4 x n_offsets x n_patch_rows x n_patch_cols array,
+ *                      features are contrast, correlation, energy and
+ *                      homogeneity
+ *     patch_row_loci - First row of each patch row (1-based)
+ *     patch_col_loci - First column of each patch column (1-based)
+ *
+ *   See also: tswHist_glcm.h, tswHist_mx.c
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#include "mex.h"
+#include "tswHist.h"
+#include "tswHist_glcm.h"
+
+/* Data pointer of a real double array */
+double *mexDoubles(const mxArray *a) {
+    #if MX_HAS_INTERLEAVED_COMPLEX
+        return mxGetDoubles(a);
+    #else
+        return mxGetPr(a);
+    #endif
+}
+
+/* Pair of sizes from a scalar or a 2-element vector */
+void mexSizePair(const mxArray *a, size_t *first, size_t *second, const char *id, const char *msg) {
+    mwSize n = mxGetNumberOfElements(a);
+    if (!mxIsDouble(a) || mxIsComplex(a) || (n != 1 && n != 2))
+        mexErrMsgIdAndTxt(id, "%s", msg);
+    const double *v = mexDoubles(a);
+    if (!(v[0] >= 1 && v[n - 1] >= 1))
+        mexErrMsgIdAndTxt(id, "%s", msg);
+    *first  = (size_t)v[0];
+    *second = (size_t)v[n - 1];
+}
+
+/* Gateway function */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+    if (nrhs < 3 || nrhs > 6)
+        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [featMat, patch_row_loci, patch_col_loci] = tswHist_glcm_mx(image_norm, n_levels, patch, stride, offsets, symmetric)");
+    if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]) || mxGetNumberOfDimensions(prhs[0]) != 2)
+        mexErrMsgIdAndTxt("tswHist_mx:inputNotReal", "Image must be a real double matrix.");
+
+    size_t rows = mxGetM(prhs[0]), cols = mxGetN(prhs[0]);
+    size_t n_levels = (size_t)mxGetScalar(prhs[1]);
+    if (n_levels < 2 || n_levels > 4096)
+        mexErrMsgIdAndTxt("tswHist_mx:badBins", "Number of gray levels must be > 1 and <= 4096.");
+    size_t patch_rows, patch_cols, stride_rows = 1, stride_cols = 1;
+    mexSizePair(prhs[2], &patch_rows, &patch_cols, "tswHist_mx:winLen", "Patch size must be a positive scalar or [rows cols].");
+    if (nrhs >= 4)
+        mexSizePair(prhs[3], &stride_rows, &stride_cols, "tswHist_mx:strideWin", "Stride must be a positive scalar or [rows cols].");
+    if (patch_rows > rows || patch_cols > cols)
+        mexErrMsgIdAndTxt("tswHist_mx:winLen", "Patch size must not exceed the image size.");
+
+    double default_offset[2] = {0, 1};
+    const double *offsets = default_offset;
+    size_t n_offsets = 1;
+    if (nrhs >= 5 && !mxIsEmpty(prhs[4])) {
+        if (!mxIsDouble(prhs[4]) || mxIsComplex(prhs[4]) || mxGetN(prhs[4]) != 2)
+            mexErrMsgIdAndTxt("tswHist_mx:badOffsets", "Offsets must be a real double [n_offsets x 2] matrix.");
+        offsets   = mexDoubles(prhs[4]);
+        n_offsets = mxGetM(prhs[4]);
+    }
+    if (!tswHistGlcmValidOffsets(offsets, n_offsets, patch_rows, patch_cols))
+        mexErrMsgIdAndTxt("tswHist_mx:badOffsets", "Offsets must be integer pairs within the patch.");
+    int symmetric = (nrhs >= 6) && mxGetScalar(prhs[5]) != 0;
+
+    size_t n_patch_rows = tswHistNumWindows(rows, patch_rows, stride_rows);
+    size_t n_patch_cols = tswHistNumWindows(cols, patch_cols, stride_cols);
+    mwSize dims[4] = {TSWHIST_GLCM_NFEATURES, n_offsets, n_patch_rows, n_patch_cols};
+    plhs[0] = mxCreateUninitNumericArray(4, dims, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, n_patch_rows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_patch_cols, mxREAL);
+
+    tswHistGlcm(mexDoubles(prhs[0]), rows, cols, n_levels,
+                patch_rows, patch_cols, stride_rows, stride_cols,
+                offsets, n_offsets, symmetric, 0,
+                mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+}
@@ -0,0 +1,292 @@
+/*
+ * tswHist_integral.h - Integral histograms of 2D images for rectangle queries
+ *
+ *   Builds the integral histogram (F. Porikli, "Integral histogram: a fast
+ *   way to extract histograms in cartesian spaces", CVPR 2005) of an image
+ *   binned by tswHistBinning: the cumulative counts H(r,c) of every bin over
+ *   the pixels [0,r) x [0,c). The histogram of any rectangle [r0,r1) x
+ *   [c0,c1) is then H(r1,c1) - H(r0,c1) - H(r1,c0) + H(r0,c0), whatever its
+ *   size, with 4 * n_bins lookups.
+ *
+ *   The counts of a corner are stored contiguously (bin-fastest, corners in
+ *   column-major order like MATLAB images) so that the bins of a query are
+ *   read and combined as vectors (SIMD). Counts are unsigned integers: the
+ *   differences of a query wrap around exactly.
+ *
+ *   Tiling bounds the memory: with tiles of tile x tile pixels, H(r,c) is
+ *   split into the counts above the band of tile rows of r (uint32, one
+ *   corner row per band), the counts of the band left of the tile of c
+ *   (uint32, one corner column per tile column) and the counts inside the
+ *   tile (uint8 when tile^2 < 256, uint16 when tile^2 < 65536). The in-tile
+ *   counts dominate, so tiles of up to 15 (resp. 255) pixels store about 1.5
+ *   (resp. 2) bytes per pixel and bin instead of 4, for 3 lookups per corner.
+ *
+ *   Bands of corner rows are built by OpenMP threads (when enabled), then
+ *   chained by a prefix sum over the bands.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_INTEGRAL_H
+#define TSWHIST_INTEGRAL_H
+
+#include <stdint.h>
+#include "tswHist.h"
+
+typedef struct {
+    size_t    rows, cols, n_bins;
+    size_t    tile;       // tile size, 0 when untiled
+    uint32_t  elem_bytes; // 1, 2 or 4 bytes per in-tile count
+    void     *local;      // [n_bins x (rows+1) x (cols+1)] in-tile counts (all counts when untiled)
+    uint32_t *band_left;  // [n_bins x (rows+1) x (cols/tile+1)] counts of the band left of the tile
+    uint32_t *band_above; // [n_bins x (rows/tile+1) x (cols+1)] counts above the band
+} tswHistIntegral;
+
+// Stores the counts of a corner in the in-tile array
+void tswHistIntegralPut(tswHistIntegral *ih, size_t corner, const uint32_t *counts) {
+    size_t n_bins = ih->n_bins;
+    if (ih->elem_bytes == 1) {
+        uint8_t *dst = (uint8_t *)ih->local + corner * n_bins;
+        for (size_t b = 0; b < n_bins; ++b) dst[b] = (uint8_t)counts[b];
+    } else if (ih->elem_bytes == 2) {
+        uint16_t *dst = (uint16_t *)ih->local + corner * n_bins;
+        for (size_t b = 0; b < n_bins; ++b) dst[b] = (uint16_t)counts[b];
+    } else {
+        memcpy((uint32_t *)ih->local + corner * n_bins, counts, n_bins * sizeof(uint32_t));
+    }
+}
+
+// Builds the corner rows [band * band_h, (band+1) * band_h) relative to the
+// top of the band, and the counts of the whole band (band_sum) if not NULL
+void tswHistIntegralBand(
+    tswHistIntegral *ih, const int *levels,
+    size_t band, size_t band_h, size_t tile_w,
+    uint32_t *colcum, uint32_t *tot, uint32_t *loc,
+    uint32_t *band_sum            // [(cols+1) x n_bins] output, or NULL
+) {
+    size_t rows = ih->rows, cols = ih->cols, n_bins = ih->n_bins;
+    size_t r_begin = band * band_h;
+    size_t r_end   = (r_begin + band_h < rows + 1) ? r_begin + band_h : rows + 1;
+    size_t r_last  = band_sum ? r_begin + band_h : r_end - 1; // bottom of the band for band_sum
+
+    memset(colcum, 0, cols * n_bins * sizeof(uint32_t));
+    for (size_t r = r_begin; r <= r_last; ++r) {
+        // Column counts of the pixel rows [r_begin, r)
+        if (r > r_begin)
+            for (size_t c = 0; c < cols; ++c) {
+                int lv = levels[(r - 1) + c * rows];
+                if (lv >= 0)
+                    colcum[c * n_bins + lv]++;
+            }
+        // Sweep of the corners of the row
+        memset(tot, 0, n_bins * sizeof(uint32_t));
+        for (size_t c = 0; c <= cols; ++c) {
+            if (c % tile_w == 0) {
+                if (r < r_end && ih->band_left)
+                    memcpy(&ih->band_left[(r + (c / tile_w) * (rows + 1)) * n_bins], tot, n_bins * sizeof(uint32_t));
+                memset(loc, 0, n_bins * sizeof(uint32_t));
+            }
+            if (r < r_end)
+                tswHistIntegralPut(ih, r + c * (rows + 1), loc);
+            else
+                memcpy(&band_sum[c * n_bins], tot, n_bins * sizeof(uint32_t));
+            if (c < cols) {
+                const uint32_t *cc = &colcum[c * n_bins];
+                for (size_t b = 0; b < n_bins; ++b) {
+                    tot[b] += cc[b];
+                    loc[b] += cc[b];
+                }
+            }
+        }
+    }
+}
+
+void tswHistIntegralFree(tswHistIntegral *ih) {
+    free(ih->local);
+    free(ih->band_left);
+    free(ih->band_above);
+    memset(ih, 0, sizeof(*ih));
+}
+
+// Integral histogram of image_norm ([rows x cols], column-major, in [0,1]),
+// pixels out of [0,1] (or NaN) are not counted. tile: 0 (untiled) or tile
+// size. Returns 0 on allocation failure.
+int tswHistIntegralBuild(
+    tswHistIntegral *ih,
+    const double *image_norm, size_t rows, size_t cols,
+    size_t n_bins, size_t tile,
+    size_t n_threads              // 0: OpenMP default
+) {
+    memset(ih, 0, sizeof(*ih));
+    // A tile larger than the image is one tile: clamped so that tile * tile
+    // cannot wrap and select too narrow in-tile counts
+    size_t max_tile = ((rows > cols) ? rows : cols) + 1;
+    if (tile > max_tile)
+        tile = max_tile;
+    ih->rows = rows;
+    ih->cols = cols;
+    ih->n_bins = n_bins;
+    ih->tile = tile;
+    ih->elem_bytes = (tile == 0 || tile * tile >= 65536) ? 4 : (tile * tile < 256) ? 1 : 2;
+
+    size_t n_corners = (rows + 1) * (cols + 1);
+    ih->local = malloc(n_corners * n_bins * ih->elem_bytes);
+    size_t n_threads_eff = tswHistNumThreads(n_threads);
+    size_t band_h, tile_w;
+    if (tile > 0) {
+        band_h = tile;
+        tile_w = tile;
+        ih->band_left  = (uint32_t *)malloc((rows + 1) * (cols / tile + 1) * n_bins * sizeof(uint32_t));
+        ih->band_above = (uint32_t *)malloc((rows / tile + 1) * (cols + 1) * n_bins * sizeof(uint32_t));
+    } else {
+        // Untiled: bands of one per thread, chained afterwards
+        band_h = (rows + 1 + n_threads_eff - 1) / n_threads_eff;
+        tile_w = cols + 1;
+    }
+    size_t n_bands = (rows + 1 + band_h - 1) / band_h;
+    uint32_t *band_sum = (uint32_t *)malloc(n_bands * (cols + 1) * n_bins * sizeof(uint32_t));
+    int *levels = (int *)malloc(rows * cols * sizeof(int));
+    if (!ih->local || (tile > 0 && (!ih->band_left || !ih->band_above)) || !band_sum || !levels) {
+        free(band_sum);
+        free(levels);
+        tswHistIntegralFree(ih);
+        return 0;
+    }
+
+    // Binning stage, -1 for the pixels not counted
+    double *image_int = (double *)malloc(rows * cols * sizeof(double));
+    tswHistBinning(image_norm, rows * cols, n_bins, image_int);
+    for (size_t i = 0; i < rows * cols; ++i)
+        levels[i] = (image_int[i] >= 0 && image_int[i] < (double)n_bins) ? (int)image_int[i] : -1;
+    free(image_int);
+
+    if (n_threads_eff > n_bands)
+        n_threads_eff = n_bands;
+    #pragma omp parallel num_threads((int)n_threads_eff)
+    {
+        uint32_t *colcum = (uint32_t *)malloc(cols * n_bins * sizeof(uint32_t));
+        uint32_t *tot    = (uint32_t *)malloc(n_bins * sizeof(uint32_t));
+        uint32_t *loc    = (uint32_t *)malloc(n_bins * sizeof(uint32_t));
+        #pragma omp for schedule(dynamic)
+        for (long long B = 0; B < (long long)n_bands; ++B)
+            tswHistIntegralBand(ih, levels, (size_t)B, band_h, tile_w, colcum, tot, loc,
+                                ((size_t)B + 1 < n_bands) ? &band_sum[(size_t)B * (cols + 1) * n_bins] : NULL);
+        free(colcum);
+        free(tot);
+        free(loc);
+    }
+
+    // Prefix sum over the bands: counts above each band, in band_sum
+    size_t plane = (cols + 1) * n_bins;
+    for (size_t B = n_bands - 1; B > 0; --B)
+        memcpy(&band_sum[B * plane], &band_sum[(B - 1) * plane], plane * sizeof(uint32_t));
+    memset(band_sum, 0, plane * sizeof(uint32_t));
+    for (size_t B = 1; B < n_bands; ++B)
+        for (size_t i = 0; i < plane; ++i)
+            band_sum[B * plane + i] += band_sum[(B - 1) * plane + i];
+
+    if (tile > 0) {
+        for (size_t B = 0; B < n_bands; ++B)
+            for (size_t c = 0; c <= cols; ++c)
+                memcpy(&ih->band_above[(B + c * n_bands) * n_bins], &band_sum[B * plane + c * n_bins],
+                       n_bins * sizeof(uint32_t));
+    } else {
+        // Untiled: counts above the band added to the corners of the band
+        #pragma omp parallel for schedule(static) num_threads((int)n_threads_eff)
+        for (long long c = 0; c <= (long long)cols; ++c) {
+            for (size_t r = band_h; r <= rows; ++r) {
+                uint32_t *dst = (uint32_t *)ih->local + (r + (size_t)c * (rows + 1)) * n_bins;
+                const uint32_t *above = &band_sum[(r / band_h) * plane + (size_t)c * n_bins];
+                for (size_t b = 0; b < n_bins; ++b)
+                    dst[b] += above[b];
+            }
+        }
+    }
+
+    free(band_sum);
+    free(levels);
+    return 1;
+}
+
+// Adds (sign > 0) or subtracts the counts H(r,c) of a corner to hist32
+void tswHistIntegralCorner(const tswHistIntegral *ih, size_t r, size_t c, int sign, uint32_t *hist32) {
+    size_t n_bins = ih->n_bins, corner = r + c * (ih->rows + 1);
+    uint32_t s = (sign > 0) ? 1u : ~0u; // +1 or -1 (mod 2^32)
+    if (ih->elem_bytes == 1) {
+        const uint8_t *p = (const uint8_t *)ih->local + corner * n_bins;
+        #pragma omp simd
+        for (size_t b = 0; b < n_bins; ++b) hist32[b] += s * p[b];
+    } else if (ih->elem_bytes == 2) {
+        const uint16_t *p = (const uint16_t *)ih->local + corner * n_bins;
+        #pragma omp simd
+        for (size_t b = 0; b < n_bins; ++b) hist32[b] += s * p[b];
+    } else {
+        const uint32_t *p = (const uint32_t *)ih->local + corner * n_bins;
+        #pragma omp simd
+        for (size_t b = 0; b < n_bins; ++b) hist32[b] += s * p[b];
+    }
+    if (ih->tile > 0) {
+        size_t tile = ih->tile;
+        const uint32_t *left  = &ih->band_left[(r + (c / tile) * (ih->rows + 1)) * n_bins];
+        const uint32_t *above = &ih->band_above[(r / tile + c * (ih->rows / tile + 1)) * n_bins];
+        #pragma omp simd
+        for (size_t b = 0; b < n_bins; ++b) hist32[b] += s * (left[b] + above[b]);
+    }
+}
+
+// Histogram of the rectangle of pixels [r0,r1) x [c0,c1) (0-based)
+void tswHistIntegralQuery(
+    const tswHistIntegral *ih,
+    size_t r0, size_t c0, size_t r1, size_t c1,
+    uint32_t *hist32,             // [n_bins] work buffer
+    double *hist                  // [n_bins] output
+) {
+    memset(hist32, 0, ih->n_bins * sizeof(uint32_t));
+    tswHistIntegralCorner(ih, r1, c1, +1, hist32);
+    tswHistIntegralCorner(ih, r0, c1, -1, hist32);
+    tswHistIntegralCorner(ih, r1, c0, -1, hist32);
+    tswHistIntegralCorner(ih, r0, c0, +1, hist32);
+    for (size_t b = 0; b < ih->n_bins; ++b)
+        hist[b] = (double)hist32[b];
+}
+
+// Returns 0 if a rectangle ([x y width height], 1-based, MATLAB bounding box
+// convention: x is the column) is not within the image
+int tswHistIntegralValidRects(const double *rects, size_t n_rects, size_t rows, size_t cols) {
+    for (size_t k = 0; k < n_rects; ++k) {
+        double x = rects[k], y = rects[k + n_rects], w = rects[k + 2 * n_rects], h = rects[k + 3 * n_rects];
+        if (x != floor(x) || y != floor(y) || w != floor(w) || h != floor(h)
+            || !(x >= 1 && y >= 1 && w >= 0 && h >= 0)
+            || x - 1 + w > (double)cols || y - 1 + h > (double)rows)
+            return 0;
+    }
+    return 1;
+}
+
+// Histograms of n_rects rectangles ([n_rects x 4] matrix of [x y width height])
+void tswHistIntegralQueries(
+    const tswHistIntegral *ih,
+    const double *rects, size_t n_rects,
+    size_t n_threads,             // 0: OpenMP default
+    double *histMat               // [n_bins x n_rects] output
+) {
+    size_t n_bins = ih->n_bins;
+    #pragma omp parallel num_threads((int)tswHistNumThreads(n_threads))
+    {
+        uint32_t *hist32 = (uint32_t *)malloc(n_bins * sizeof(uint32_t));
+        #pragma omp for schedule(static)
+        for (long long k = 0; k < (long long)n_rects; ++k) {
+            size_t c0 = (size_t)rects[k] - 1, r0 = (size_t)rects[k + n_rects] - 1;
+            size_t c1 = c0 + (size_t)rects[k + 2 * n_rects], r1 = r0 + (size_t)rects[k + 3 * n_rects];
+            tswHistIntegralQuery(ih, r0, c0, r1, c1, hist32, &histMat[(size_t)k * n_bins]);
+        }
+        free(hist32);
+    }
+}
+
+#endif // TSWHIST_INTEGRAL_H
@@ -0,0 +1,83 @@
+/*
+ * tswHist_integral_mx.c - Histograms of image rectangles from an integral histogram (MEX gateway)
+ *
+ *   Builds the integral histogram of a normalized image (see
+ *   tswHist_integral.h) and returns the histograms of any number of
+ *   rectangles of arbitrary sizes, each with 4 * n_bins lookups (12 * n_bins
+ *   when tiled), e.g. all the candidate boxes of a tracker on a frame.
+ *
+ *   Usage:
+ *     [histMat, edges] = tswHist_integral_mx(image_norm, n_bins, rects)
+ *     [histMat, edges] = tswHist_integral_mx(image_norm, n_bins, rects, tile)
+ *
+ *   Inputs:
+ *     image_norm - Normalized image (real double matrix) (in [0,1]), pixels
+ *                  out of [0,1] or NaN are not counted
+ *     n_bins     - Number of histogram bins (integer > 2)
+ *     rects      - [n_rects x 4] matrix of rectangles [x y width height]
+ *                  (1-based, x is the column, as bounding boxes in MATLAB)
+ *     tile       - (optional) tile size bounding the memory of the integral
+ *                  histogram, 0 for untiled (default: 0). Tiles of up to 15
+ *                  (resp. 255) pixels store in-tile counts as uint8 (resp.
+ *                  uint16) instead of uint32.
+ *
+ *   Outputs:
+ *     histMat - n_bins x n_rects matrix of histograms
+ *     edges   - Bin edges used for histogramming
+ *
+ *   See also: tswHist_integral.h, tswHist_mx.c
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#include "mex.h"
+#include "tswHist.h"
+#include "tswHist_integral.h"
+
+/* Data pointer of a real double array */
+double *mexDoubles(const mxArray *a) {
+    #if MX_HAS_INTERLEAVED_COMPLEX
+        return mxGetDoubles(a);
+    #else
+        return mxGetPr(a);
+    #endif
+}
+
+/* Gateway function */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+    if (nrhs < 3 || nrhs > 4)
+        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [histMat, edges] = tswHist_integral_mx(image_norm, n_bins, rects, tile)");
+    if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]) || mxGetNumberOfDimensions(prhs[0]) != 2)
+        mexErrMsgIdAndTxt("tswHist_mx:inputNotReal", "Image must be a real double matrix.");
+
+    size_t rows = mxGetM(prhs[0]), cols = mxGetN(prhs[0]);
+    size_t n_bins = (size_t)mxGetScalar(prhs[1]);
+    if (n_bins <= 2)
+        mexErrMsgIdAndTxt("tswHist_mx:badBins", "Number of bins must be > 2.");
+    if (!mxIsDouble(prhs[2]) || mxIsComplex(prhs[2]) || (mxGetN(prhs[2]) != 4 && !mxIsEmpty(prhs[2])))
+        mexErrMsgIdAndTxt("tswHist_mx:badRects", "Rectangles must be a real double [n_rects x 4] matrix.");
+    size_t n_rects = mxGetM(prhs[2]);
+    const double *rects = mexDoubles(prhs[2]);
+    if (!tswHistIntegralValidRects(rects, n_rects, rows, cols))
+        mexErrMsgIdAndTxt("tswHist_mx:badRects", "Rectangles must be integer [x y width height] within the image.");
+    double tile = (nrhs >= 4) ? mxGetScalar(prhs[3]) : 0;
+    if (!(tile >= 0) || tile != floor(tile))
+        mexErrMsgIdAndTxt("tswHist_mx:badTile", "Tile size must be a non-negative integer.");
+    if (tile > (double)((rows > cols) ? rows : cols) + 1)
+        tile = (double)((rows > cols) ? rows : cols) + 1; // one tile, no out of range conversion
+
+    plhs[0] = mxCreateUninitNumericMatrix(n_bins, n_rects, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistEdges(mexDoubles(plhs[1]), n_bins);
+
+    tswHistIntegral ih;
+    if (!tswHistIntegralBuild(&ih, mexDoubles(prhs[0]), rows, cols, n_bins, (size_t)tile, 0))
+        mexErrMsgIdAndTxt("tswHist_mx:outOfMemory", "Not enough memory for the integral histogram, use a smaller tile.");
+    tswHistIntegralQueries(&ih, rects, n_rects, 0, mexDoubles(plhs[0]));
+    tswHistIntegralFree(&ih);
+}
@@ -0,0 +1,295 @@
+/*
+ * tswHist_jit.h - Runtime specialization of the sliding histogram kernel
+ *
+ *   Opt-in JIT path for long-running jobs using one (n_bins, win_len,
+ *   stride) combination for hours: at plan time, the C source of a kernel
+ *   specialized for these exact parameters is generated, compiled by the
+ *   system C compiler into a shared object and loaded (dlopen). In the
+ *   generated kernel:
+ *     - n_bins, win_len and stride are compile-time constants;
+ *     - the binning stage stores compact bin indices (uint16 or uint32) and
+ *       maps the samples out of [0, n_bins) (and NaN) to an extra bin
+ *       n_bins, which is never stored: the range checks of pushHist and
+ *       popHist are removed from the sliding steps;
+ *     - the pop/push updates of a step are unrolled stride times (up to
+ *       TSWHIST_JIT_MAX_UNROLL, a loop of constant trip count beyond);
+ *     - the histogram is kept as integer counts, converted when stored.
+ *   The histograms are identical to those of tswHist.
+ *
+ *   The shared objects are cached in a directory, named by a hash of the
+ *   generated source and of the compile command, so that the compile cost
+ *   (typically 0.1 to 1 s) is paid once per parameter set and compiler,
+ *   across processes. They are written to a temporary file then renamed,
+ *   like the entries of tswHist_cache.h. Since the shared objects are
+ *   executed, the directory is created private (0700), and a directory or
+ *   shared object not owned by the current user, or writable by its group
+ *   or others, is never loaded: such a shared object is recompiled, and such
+ *   a directory gives no kernel. When no compiler is found, the compilation
+ *   fails, the directory is not trusted or the platform has no dlopen, the
+ *   plan holds no kernel and tswHistJit falls back to tswHist.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_JIT_H
+#define TSWHIST_JIT_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "tswHist.h"
+#include "tswHist_cache.h" // for tswHistHash64
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define TSWHIST_JIT_ENABLED 1
+#else
+#define TSWHIST_JIT_ENABLED 0
+#endif
+
+#define TSWHIST_JIT_VERSION      1
+#define TSWHIST_JIT_MAX_UNROLL   256     // longest stride unrolled statement by statement
+#define TSWHIST_JIT_CC           "cc"    // default compiler
+#define TSWHIST_JIT_CFLAGS       "-O3"   // default compile flags
+#define TSWHIST_JIT_SYMBOL       "tswHistJitKernel"
+
+// Generated kernel: histMat [n_bins x num_windows], scratch bins
+// [input_len] (uint16 or uint32) and hist [n_bins+1] (uint32)
+typedef void (*tswHistJitFn)(const double *input_norm, size_t input_len, double *histMat,
+                             void *bins, uint32_t *hist);
+
+typedef struct {
+    size_t n_bins, win_len, stride;
+    size_t bin_bytes;      // 2 (uint16) or 4 (uint32)
+    void  *handle;         // dlopen handle, NULL without kernel
+    tswHistJitFn kernel;   // NULL: fallback to tswHist
+    int    compiled;       // 1 if compiled by this plan, 0 if loaded from the directory
+    char   dir[4096], cc[4096], cflags[4096]; // as given to tswHistJitPlanCreate (NULL: "")
+} tswHistJitPlan;
+
+// Records the arguments of tswHistJitPlanCreate in plan
+void tswHistJitPlanInit(tswHistJitPlan *plan, const char *dir, const char *cc, const char *cflags,
+                        size_t n_bins, size_t win_len, size_t stride) {
+    memset(plan, 0, sizeof(*plan));
+    plan->n_bins    = n_bins;
+    plan->win_len   = win_len;
+    plan->stride    = stride;
+    plan->bin_bytes = (n_bins < 65535) ? 2 : 4;
+    snprintf(plan->dir, sizeof(plan->dir), "%s", dir ? dir : "");
+    snprintf(plan->cc, sizeof(plan->cc), "%s", cc ? cc : "");
+    snprintf(plan->cflags, sizeof(plan->cflags), "%s", cflags ? cflags : "");
+}
+
+typedef struct {
+    char  *data;
+    size_t len, cap;
+} tswHistJitBuf;
+
+// printf to the end of a growing buffer
+void tswHistJitPrintf(tswHistJitBuf *buf, const char *fmt, ...) {
+    va_list ap;
+    for (;;) {
+        va_start(ap, fmt);
+        int n = vsnprintf(buf->data ? buf->data + buf->len : NULL, buf->data ? buf->cap - buf->len : 0, fmt, ap);
+        va_end(ap);
+        if (n < 0)
+            return;
+        if (buf->data && buf->len + (size_t)n < buf->cap) {
+            buf->len += (size_t)n;
+            return;
+        }
+        size_t cap = 2 * (buf->cap + (size_t)n) + 256;
+        char *data = (char *)realloc(buf->data, cap);
+        if (!data)
+            return;
+        buf->data = data;
+        buf->cap  = cap;
+    }
+}
+
+// C source of the kernel specialized for (n_bins, win_len, stride), to be
+// freed by the caller
+char *tswHistJitSource(size_t n_bins, size_t win_len, size_t stride, size_t bin_bytes) {
+    tswHistJitBuf buf = {NULL, 0, 0};
+    tswHistJitPrintf(&buf,
+        "/* tswHist JIT kernel v%d (generated by tswHist_jit.h) */\n"
+        "#include <stddef.h>\n"
+        "#include <stdint.h>\n"
+        "#include <math.h>\n"
+        "#define N_BINS  %zuu\n"
+        "#define WIN_LEN %zuu\n"
+        "#define STRIDE  %zuu\n"
+        "typedef %s bin_t;\n\n",
+        TSWHIST_JIT_VERSION, n_bins, win_len, stride, (bin_bytes == 2) ? "uint16_t" : "uint32_t");
+    tswHistJitPrintf(&buf,
+        "void " TSWHIST_JIT_SYMBOL "(const double *input_norm, size_t input_len, double *histMat,\n"
+        "                      void *bins_v, uint32_t *hist) {\n"
+        "    bin_t *restrict bins = (bin_t *)bins_v;\n"
+        "    size_t num_windows = (input_len - WIN_LEN) / STRIDE + 1;\n"
+        "    /* Binning (tswHistBinning), out of range samples in bin N_BINS */\n"
+        "    for (size_t i = 0; i < input_len; ++i) {\n"
+        "        double f = floor(input_norm[i] * N_BINS);\n"
+        "        bins[i] = (f >= 0 && f < N_BINS) ? (bin_t)f : (f == N_BINS) ? (bin_t)(N_BINS - 1) : (bin_t)N_BINS;\n"
+        "    }\n"
+        "    for (size_t b = 0; b <= N_BINS; ++b)\n"
+        "        hist[b] = 0;\n"
+        "    for (size_t i = 0; i < WIN_LEN; ++i)\n"
+        "        hist[bins[i]]++;\n"
+        "    for (size_t b = 0; b < N_BINS; ++b)\n"
+        "        histMat[b] = (double)hist[b];\n"
+        "    for (size_t w = 1; w < num_windows; ++w) {\n"
+        "        const bin_t *pop  = &bins[(w - 1) * STRIDE];\n"
+        "        const bin_t *push = pop + WIN_LEN;\n");
+    if (stride <= TSWHIST_JIT_MAX_UNROLL) {
+        for (size_t j = 0; j < stride; ++j)
+            tswHistJitPrintf(&buf, "        hist[pop[%zu]]--;\n", j);
+        for (size_t j = 0; j < stride; ++j)
+            tswHistJitPrintf(&buf, "        hist[push[%zu]]++;\n", j);
+    } else {
+        tswHistJitPrintf(&buf,
+            "        for (size_t j = 0; j < STRIDE; ++j)\n"
+            "            hist[pop[j]]--;\n"
+            "        for (size_t j = 0; j < STRIDE; ++j)\n"
+            "            hist[push[j]]++;\n");
+    }
+    tswHistJitPrintf(&buf,
+        "        double *out = &histMat[w * N_BINS];\n"
+        "        for (size_t b = 0; b < N_BINS; ++b)\n"
+        "            out[b] = (double)hist[b];\n"
+        "    }\n"
+        "}\n");
+    return buf.data;
+}
+
+void tswHistJitPlanFree(tswHistJitPlan *plan) {
+#if TSWHIST_JIT_ENABLED
+    if (plan->handle)
+        dlclose(plan->handle);
+#endif
+    plan->handle = NULL;
+    plan->kernel = NULL;
+}
+
+#if TSWHIST_JIT_ENABLED
+
+// Whether path is owned by the current user and not writable by its group or
+// others: a directory (symbolic links followed), or a regular file which is
+// not a symbolic link
+int tswHistJitTrusted(const char *path, int is_dir) {
+    struct stat st;
+    if ((is_dir ? stat(path, &st) : lstat(path, &st)) != 0)
+        return 0;
+    if (is_dir ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode))
+        return 0;
+    return st.st_uid == geteuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+// Loads the kernel of the shared object at path. Returns 1 on success.
+int tswHistJitLoad(tswHistJitPlan *plan, const char *path) {
+    plan->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!plan->handle)
+        return 0;
+    plan->kernel = (tswHistJitFn)dlsym(plan->handle, TSWHIST_JIT_SYMBOL);
+    if (!plan->kernel)
+        tswHistJitPlanFree(plan);
+    return plan->kernel != NULL;
+}
+
+// Plan of the kernel specialized for (n_bins, win_len, stride): loaded from
+// the directory dir, or compiled into it by cc with cflags (NULL: defaults).
+// Returns 1 if the plan holds a kernel, 0 if tswHistJit falls back to tswHist.
+int tswHistJitPlanCreate(tswHistJitPlan *plan, const char *dir, const char *cc, const char *cflags,
+                         size_t n_bins, size_t win_len, size_t stride) {
+    static unsigned counter = 0;
+    tswHistJitPlanInit(plan, dir, cc, cflags, n_bins, win_len, stride);
+    if (!dir || dir[0] == '\0' || strchr(dir, '\'') || n_bins >= 4294967295u || stride == 0)
+        return 0;
+    if (!cc || cc[0] == '\0')
+        cc = TSWHIST_JIT_CC;
+    if (!cflags)
+        cflags = TSWHIST_JIT_CFLAGS;
+
+    // Shared object named by the source and the compile command
+    char *src = tswHistJitSource(n_bins, win_len, stride, plan->bin_bytes);
+    if (!src)
+        return 0;
+    char cmd[8192], path[4096], tmp[4096];
+    snprintf(cmd, sizeof(cmd), "%s %s -shared -fPIC", cc, cflags);
+    uint64_t hash = tswHistHash64(cmd, strlen(cmd), tswHistHash64(src, strlen(src), 0));
+    snprintf(path, sizeof(path), "%s/tswhist_jit_%016llx.so", dir, (unsigned long long)hash);
+    mkdir(dir, 0700); // may already exist
+    if (!tswHistJitTrusted(dir, 1)) {
+        free(src);
+        return 0;
+    }
+    if (tswHistJitTrusted(path, 0) && tswHistJitLoad(plan, path)) {
+        free(src);
+        return 1;
+    }
+
+    // Compile into a temporary file, then rename (atomic on POSIX) over any
+    // untrusted shared object
+    snprintf(tmp, sizeof(tmp), "%s/.tswhist_jit_%016llx.%ld.%u", dir,
+             (unsigned long long)hash, (long)getpid(), counter++);
+    char src_path[4200], so_path[4200], line[8192 + 8600];
+    snprintf(src_path, sizeof(src_path), "%s.c", tmp);
+    snprintf(so_path, sizeof(so_path), "%s.so", tmp);
+    FILE *f = fopen(src_path, "w");
+    int ok = (f != NULL) && fputs(src, f) >= 0;
+    if (f)
+        ok = (fclose(f) == 0) && ok;
+    free(src);
+    if (ok) {
+        snprintf(line, sizeof(line), "%s -o '%s' '%s' -lm > /dev/null 2>&1", cmd, so_path, src_path);
+        ok = (system(line) == 0) && (chmod(so_path, 0755) == 0) && (rename(so_path, path) == 0);
+    }
+    unlink(src_path);
+    unlink(so_path);
+    plan->compiled = ok && tswHistJitTrusted(path, 0) && tswHistJitLoad(plan, path);
+    return plan->compiled;
+}
+
+#else // !TSWHIST_JIT_ENABLED
+
+int tswHistJitPlanCreate(tswHistJitPlan *plan, const char *dir, const char *cc, const char *cflags,
+                         size_t n_bins, size_t win_len, size_t stride) {
+    tswHistJitPlanInit(plan, dir, cc, cflags, n_bins, win_len, stride);
+    return 0;
+}
+
+#endif // TSWHIST_JIT_ENABLED
+
+// tswHist with the kernel of the plan (same outputs), or tswHist itself when
+// the plan holds no kernel
+void tswHistJit(
+    const tswHistJitPlan *plan,
+    const double *input_norm, size_t input_len,
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    void     *bins = plan->kernel ? malloc(input_len * plan->bin_bytes) : NULL;
+    uint32_t *hist = plan->kernel ? (uint32_t *)malloc((plan->n_bins + 1) * sizeof(uint32_t)) : NULL;
+    if (!bins || !hist) {
+        free(bins);
+        free(hist);
+        tswHist(input_norm, input_len, plan->n_bins, plan->win_len, plan->stride,
+                histMat, strided_windows_loci, edges);
+        return;
+    }
+    tswHistLoci(strided_windows_loci, tswHistNumWindows(input_len, plan->win_len, plan->stride), plan->stride);
+    tswHistEdges(edges, plan->n_bins);
+    plan->kernel(input_norm, input_len, histMat, bins, hist);
+    free(bins);
+    free(hist);
+}
+
+#endif // TSWHIST_JIT_H
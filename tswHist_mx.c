@@ -10,19 +10,128 @@
  *
  *   Usage from matlab:
  *     [histMat, strided_windows_loci, edges] = tswHist_mx(input, n_bins, win_len, stride)
+ *     [robustMat, strided_windows_loci, edges] = tswHist_mx(input, n_bins, win_len, stride, 'robust', trim)
+ *     [threshMat, strided_windows_loci, edges, labels] = tswHist_mx(input, n_bins, win_len, stride, 'otsu')
+ *     [histMat, strided_windows_loci, edges] = tswHist_mx(input_mat, n_bins, win_len, stride, 'pooled')
+ *     [miMat, strided_windows_loci, edges] = tswHist_mx(input_mat, n_bins, win_len, stride, 'connectivity', layout)
+ *     [histMat, strided_windows_loci, edges, segment_ids] = tswHist_mx(input, n_bins, win_len, stride, 'segments', segments)
+ *     [codeMat, strided_windows_loci, edges] = tswHist_mx(input, n_bins, win_len, stride, 'codebook', prototypes, metric)
+ *     [quantMat, strided_windows_loci, edges] = tswHist_mx(input, n_bins, win_len, stride, 'exact', probs)
+ *     [histMat, windows_loci, edges, stat] = tswHist_mx(input, n_bins, win_len, stride, 'adaptive', criterion, params)
+ *     [histMat, windows_loci, edges] = tswHist_mx(input, n_bins, win_revs, stride_revs, 'phase', phase, params)
+ *     [histMat, strided_windows_loci, edges] = tswHist_mx(bin_file, n_bins, win_len, stride)
  *
  *   Inputs:
  *     input    - Input vector (real double, 1D)
+ *     bin_file - Binned-index file written by tswHist_bins_mx, used instead of
+ *                the input ('hist' mode only). The binning stage is skipped and
+ *                n_bins may be [] (n_bins of the file).
  *     n_bins   - Number of histogram bins (integer > 2)
  *     win_len  - Sliding window length
  *     stride   - Stride for sliding window (default: 1)
+ *     mode     - Output mode (default: 'hist')
+ *                'hist'   : sliding histograms
+ *                'robust' : sliding robust statistics, histMat is never
+ *                           allocated. trim (default: 0.1) is the fraction
+ *                           trimmed/winsorized on each side.
+ *                'otsu'   : sliding Otsu threshold, histMat is never allocated
+ *                'minerror' : sliding minimum-error (Kittler-Illingworth)
+ *                           threshold, histMat is never allocated
+ *                'pooled' : input_mat is [input_len x n_channels], histMat
+ *                           holds the histograms of all channels pooled
+ *                           together over each window
+ *                'connectivity' : input_mat is [input_len x n_channels],
+ *                           miMat holds the mutual information between every
+ *                           pair of channels over each window. layout is
+ *                           'full' (default) or 'triu'.
+ *                'segments' : sliding histograms restarted at every segment of
+ *                           the input, windows never cross a segment bound.
+ *                           segments is a vector of segment start indices
+ *                           (each segment ends before the next start) or a
+ *                           [n_segments x 2] matrix of [start, end] indices
+ *                           (samples outside of the segments are gaps).
+ *                'codebook' : nearest of the K prototype histograms
+ *                           (prototypes, [n_bins x K], in counts per window)
+ *                           for every window, histMat is never allocated.
+ *                           metric is 'l2' (squared L2, default) or 'dot'
+ *                           (largest dot product).
+ *                'exact'  : exact (binless) sliding quantiles of the raw
+ *                           input values (not normalized, n_bins unused) at
+ *                           the probabilities probs (default: 0.5, the
+ *                           median), histMat is never allocated
+ *                'adaptive' : sliding histograms at the (coarse) stride,
+ *                           backfilled at a fine stride between two coarse
+ *                           windows whose statistic jumps. criterion is
+ *                           'entropy' (default, nats) or 'tail' (mass at or
+ *                           above a level), params is [threshold, fine_stride,
+ *                           tail_level] (default: [0.1, 1, 0.9]).
+ *                'phase'    : phase-folded [n_phase x n_bins] histograms of
+ *                           the last win_len revolutions, sliding by stride
+ *                           revolutions. phase is the unwrapped phase of
+ *                           every sample in turns (nondecreasing), params is
+ *                           [n_phase, probs] (default: 36): when probs are
+ *                           given, histMat is replaced by the
+ *                           [n_phase x numel(probs)] per-phase quantiles.
  *
  *   Outputs:
  *     histMat              - n_bins x num_windows matrix of histograms
+ *     robustMat            - 7 x num_windows matrix, rows are median, MAD, Q1,
+ *                            Q3, IQR, trimmed mean and winsorized mean (in the
+ *                            units of edges)
+ *     threshMat            - 3 x num_windows matrix, rows are the threshold (in
+ *                            the units of edges) and the weights of the lower
+ *                            and upper classes
+ *     codeMat              - 2 x num_windows matrix, rows are the index of
+ *                            the nearest prototype (1-based) and its squared
+ *                            L2 distance (or dot product)
+ *     quantMat             - numel(probs) x num_windows matrix of exact
+ *                            quantiles (MATLAB prctile/quantile definition)
+ *     miMat                - n_channels x n_channels x num_windows array of
+ *                            mutual information (in nats), symmetric with the
+ *                            channel entropies on the diagonal ('full'), or
+ *                            n_pairs x num_windows matrix of the strict upper
+ *                            triangles, M(triu(true(n_channels), 1)) ('triu')
+ *     windows_loci         - ('adaptive' mode) start indices of the coarse and
+ *                            backfilled windows (1-based, increasing)
+ *     stat                 - (optional, 'adaptive' mode) statistic of each
+ *                            window
+ *     windows_loci         - ('phase' mode) first sample of every window
+ *                            (1-based)
+ *     segment_ids          - (optional, 'segments' mode) segment index of
+ *                            each window (1-based)
+ *     labels               - (optional) logical vector, true for the samples
+ *                            above the threshold of the window they enter in
  *     strided_windows_loci - Start indices of each window (1-based)
  *     edges                - Bin edges used for histogramming
  *
- *   See also: tswHist.m, hist_int_mx.c
+ *   Cache:
+ *     Results can be kept in an on-disk cache (see tswHist_cache.h) shared by
+ *     repeated runs, by setting the environment variables TSWHIST_CACHE_DIR
+ *     (cache directory) and optionally TSWHIST_CACHE_MAX_MB (size cap,
+ *     default: 1024), e.g. setenv('TSWHIST_CACHE_DIR', '/tmp/tswhist').
+ *
+ *   JIT:
+ *     In 'hist' mode, a kernel specialized for (n_bins, win_len, stride) can
+ *     be compiled at runtime by the system C compiler (see tswHist_jit.h), by
+ *     setting the environment variable TSWHIST_JIT_DIR (directory of the
+ *     compiled kernels) and optionally TSWHIST_JIT_CC (default: cc) and
+ *     TSWHIST_JIT_CFLAGS (default: -O3), e.g.
+ *     setenv('TSWHIST_JIT_DIR', '/tmp/tswhist_jit'). Without a working
+ *     compiler, the generic kernel is used.
+ *
+ *   Workload recorder:
+ *     The shape (mode, n_bins, win_len, stride, input_len), wall time and a
+ *     sketch of the value distribution of every call can be appended to a
+ *     log (see tswHist_record.h) by setting the environment variable
+ *     TSWHIST_RECORD_LOG, e.g. setenv('TSWHIST_RECORD_LOG', '/tmp/tswhist.log'),
+ *     then replayed with make bench-native RECORD_LOG=/tmp/tswhist.log.
+ *     Binned-index file inputs are not recorded.
+ *
+ *   See also: tswHist.m, hist_int_mx.c, tswHist_robust.h, tswHist_threshold.h,
+ *             tswHist_pooled.h, tswHist_connectivity.h, tswHist_cache.h,
+ *             tswHist_codebook.h, tswHist_exact.h, tswHist_binfile.h, tswHist_bins_mx.c,
+ *             tswHist_bitplane.h, tswHist_adaptive.h, tswHist_phase.h, tswHist_jit.h,
+ *             tswHist_record.h
  *
  *   Project: tswHist (https://github.com/cyber-g/tswHist)
  *
@@ -35,38 +144,371 @@
 
 #include "mex.h"
 #include <math.h>
+#include <string.h>
 # if __has_include("tswHist_mx.h")   /* try the MATLAB-enabled version first */
 #   include "tswHist_mx.h"
 # else                               /* otherwise use pure C version (equally the same) */
 #   include "tswHist.h"
 # endif
+#include "tswHist_robust.h"
+#include "tswHist_threshold.h"
+#include "tswHist_pooled.h"
+#include "tswHist_connectivity.h"
+#include "tswHist_codebook.h"
+#include "tswHist_exact.h"
+#include "tswHist_bitplane.h"
+#include "tswHist_adaptive.h"
+#include "tswHist_phase.h"
+#include "tswHist_cache.h"
+#include "tswHist_jit.h"
+#include "tswHist_record.h"
+#include "tswHist_binfile.h"
 
 
-void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
-    // Argument parsing and validation
-    if (nrhs < 3 || nrhs > 4)
-        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [histMat, strided_windows_loci, edges] = tswHist_mx(input, n_bins, win_len, stride)");
-
-    // Input
-    const mxArray *input_mx = prhs[0];
-    mwSize n_bins  = (mwSize)mxGetScalar(prhs[1]);
-    mwSize win_len = (mwSize)mxGetScalar(prhs[2]);
-    // Optional stride, set to 1 if not provided
-    mwSize stride  = (nrhs >= 4) ? (mwSize)mxGetScalar(prhs[3]) : 1;
-
-    if (!mxIsDouble(input_mx) || mxIsComplex(input_mx))
-        mexErrMsgIdAndTxt("tswHist_mx:inputNotReal", "Input must be a real double vector.");
-    mwSize input_len    = mxGetNumberOfElements(input_mx);
+/* Data pointer of a real double array */
+double *mexDoubles(const mxArray *a) {
     #if MX_HAS_INTERLEAVED_COMPLEX
-        mxDouble *input_norm = mxGetDoubles(input_mx);
+        return mxGetDoubles(a);
     #else
-        double *input_norm   = mxGetPr(input_mx);
+        return mxGetPr(a);
     #endif
+}
+
+
+/* Robust statistics mode: robustMat replaces histMat */
+void mexRobust(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+               const double *input_norm, mwSize input_len,
+               mwSize n_bins, mwSize win_len, mwSize stride) {
+    double trim = (nrhs >= 6) ? mxGetScalar(prhs[5]) : 0.1;
+    if (!(trim >= 0 && trim < 0.5))
+        mexErrMsgIdAndTxt("tswHist_mx:badTrim", "Trim fraction must be in [0, 0.5).");
+
+    mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+    plhs[0] = mxCreateDoubleMatrix(TSWHIST_ROBUST_NSTATS, num_windows, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistRobust(input_norm, input_len, n_bins, win_len, stride, trim,
+                  mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+}
+
+
+/* Thresholding mode: threshMat replaces histMat, optional per-sample labels */
+void mexThreshold(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+                  const double *input_norm, mwSize input_len,
+                  mwSize n_bins, mwSize win_len, mwSize stride,
+                  tswHistThresholdMethod method) {
+    mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+    plhs[0] = mxCreateDoubleMatrix(TSWHIST_THRESHOLD_NROWS, num_windows, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    unsigned char *labels = NULL;
+    if (nlhs >= 4) {
+        plhs[3] = mxCreateLogicalMatrix(1, input_len);
+        labels  = (unsigned char *)mxGetLogicals(plhs[3]);
+    }
+    tswHistThreshold(input_norm, input_len, n_bins, win_len, stride, method,
+                     mexDoubles(plhs[0]), labels, mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+}
+
+
+/* Pooled mode: one histogram per window over all the columns (channels) */
+void mexPooled(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+               const double *input_norm,
+               mwSize n_bins, mwSize win_len, mwSize stride) {
+    mwSize input_len  = mxGetM(prhs[0]);
+    mwSize n_channels = mxGetN(prhs[0]);
+    if (win_len > input_len)
+        mexErrMsgIdAndTxt("tswHist_mx:winLen", "Window length must not exceed the number of rows of the input.");
+
+    mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+    plhs[0] = mxCreateDoubleMatrix(n_bins, num_windows, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistPooled(input_norm, input_len, n_channels, n_bins, win_len, stride,
+                  mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+}
+
+
+/* Connectivity layout from the optional 6th argument */
+tswHistConnLayout mexConnLayout(int nrhs, const mxArray *prhs[]) {
+    if (nrhs < 6)
+        return TSWHIST_CONN_FULL;
+    char layout[8] = "";
+    if (!mxIsChar(prhs[5]) || mxGetString(prhs[5], layout, sizeof(layout)) != 0
+        || (strcmp(layout, "full") != 0 && strcmp(layout, "triu") != 0))
+        mexErrMsgIdAndTxt("tswHist_mx:badLayout", "Layout must be 'full' or 'triu'.");
+    return (strcmp(layout, "triu") == 0) ? TSWHIST_CONN_TRIU : TSWHIST_CONN_FULL;
+}
+
+/* Set the [n_channels x n_channels x num_windows] dimensions of a full miMat */
+void mexConnDims(mxArray *miMat, mwSize n_channels, mwSize num_windows) {
+    mwSize dims[3] = {n_channels, n_channels, num_windows};
+    mxSetDimensions(miMat, dims, 3);
+}
+
+
+/* Connectivity mode: mutual information between every pair of columns */
+void mexConnectivity(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+                     const double *input_norm,
+                     mwSize n_bins, mwSize win_len, mwSize stride) {
+    mwSize input_len  = mxGetM(prhs[0]);
+    mwSize n_channels = mxGetN(prhs[0]);
+    if (win_len > input_len)
+        mexErrMsgIdAndTxt("tswHist_mx:winLen", "Window length must not exceed the number of rows of the input.");
+    if (n_bins > TSWHIST_CONN_MAX_BINS)
+        mexErrMsgIdAndTxt("tswHist_mx:badBins", "Number of bins must not exceed 65535 in the connectivity mode.");
+    tswHistConnLayout layout = mexConnLayout(nrhs, prhs);
+
+    mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+    mwSize rows = (layout == TSWHIST_CONN_TRIU) ? tswHistConnNumPairs(n_channels) : n_channels * n_channels;
+    plhs[0] = mxCreateUninitNumericMatrix(rows, num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistConnectivity(input_norm, input_len, n_channels, n_bins, win_len, stride, layout,
+                        mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+}
+
+
+/* Codebook mode: nearest prototype of every window, histMat is never allocated */
+void mexCodebook(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+                 const double *input_norm, mwSize input_len,
+                 mwSize n_bins, mwSize win_len, mwSize stride) {
+    if (nrhs < 6 || !mxIsDouble(prhs[5]) || mxIsComplex(prhs[5]) || mxGetM(prhs[5]) != n_bins || mxGetN(prhs[5]) < 1)
+        mexErrMsgIdAndTxt("tswHist_mx:badPrototypes", "Prototypes must be a real double [n_bins x K] matrix.");
+    tswHistCodebookMetric metric = TSWHIST_CODEBOOK_L2;
+    if (nrhs >= 7) {
+        char name[8] = "";
+        if (!mxIsChar(prhs[6]) || mxGetString(prhs[6], name, sizeof(name)) != 0
+            || (strcmp(name, "l2") != 0 && strcmp(name, "dot") != 0))
+            mexErrMsgIdAndTxt("tswHist_mx:badMetric", "Metric must be 'l2' or 'dot'.");
+        metric = (strcmp(name, "dot") == 0) ? TSWHIST_CODEBOOK_DOT : TSWHIST_CODEBOOK_L2;
+    }
+
+    mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+    plhs[0] = mxCreateUninitNumericMatrix(TSWHIST_CODEBOOK_NROWS, num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistCodebook(input_norm, input_len, n_bins, win_len, stride,
+                    mexDoubles(prhs[5]), mxGetN(prhs[5]), metric,
+                    mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+}
+
+
+/* Exact mode: binless quantiles of the raw values, histMat is never allocated */
+void mexExact(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+              const double *input, mwSize input_len,
+              mwSize n_bins, mwSize win_len, mwSize stride) {
+    double median = 0.5;
+    const double *probs = &median;
+    mwSize n_probs = 1;
+    if (nrhs >= 6) {
+        if (!mxIsDouble(prhs[5]) || mxIsComplex(prhs[5]) || mxIsEmpty(prhs[5]))
+            mexErrMsgIdAndTxt("tswHist_mx:badProbs", "Probabilities must be a real double vector.");
+        probs   = mexDoubles(prhs[5]);
+        n_probs = mxGetNumberOfElements(prhs[5]);
+    }
+    for (mwSize q = 0; q < n_probs; ++q)
+        if (!(probs[q] >= 0 && probs[q] <= 1))
+            mexErrMsgIdAndTxt("tswHist_mx:badProbs", "Probabilities must be in [0, 1].");
+    if (input_len >= 4294967295.0)
+        mexErrMsgIdAndTxt("tswHist_mx:winLen", "Input is too long for the exact mode.");
+
+    mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+    plhs[0] = mxCreateUninitNumericMatrix(n_probs, num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistExact(input, input_len, win_len, stride, probs, n_probs,
+                 mexDoubles(plhs[0]), mexDoubles(plhs[1]));
+    tswHistEdges(mexDoubles(plhs[2]), n_bins);
+}
+
+
+/* Adaptive mode: coarse windows, backfilled at a fine stride around jumps */
+void mexAdaptive(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+                 const double *input_norm, mwSize input_len,
+                 mwSize n_bins, mwSize win_len, mwSize stride) {
+    tswHistAdaptiveCriterion criterion = TSWHIST_ADAPTIVE_ENTROPY;
+    if (nrhs >= 6) {
+        char name[8] = "";
+        if (!mxIsChar(prhs[5]) || mxGetString(prhs[5], name, sizeof(name)) != 0
+            || (strcmp(name, "entropy") != 0 && strcmp(name, "tail") != 0))
+            mexErrMsgIdAndTxt("tswHist_mx:badCriterion", "Criterion must be 'entropy' or 'tail'.");
+        criterion = (strcmp(name, "tail") == 0) ? TSWHIST_ADAPTIVE_TAIL : TSWHIST_ADAPTIVE_ENTROPY;
+    }
+    double params[3] = {0.1, 1, 0.9}; // threshold, fine_stride, tail_level
+    if (nrhs >= 7) {
+        mwSize n = mxGetNumberOfElements(prhs[6]);
+        if (!mxIsDouble(prhs[6]) || mxIsComplex(prhs[6]) || n > 3)
+            mexErrMsgIdAndTxt("tswHist_mx:badParams", "Parameters must be [threshold, fine_stride, tail_level].");
+        for (mwSize k = 0; k < n; ++k)
+            params[k] = mexDoubles(prhs[6])[k];
+    }
+    if (!(params[0] >= 0))
+        mexErrMsgIdAndTxt("tswHist_mx:badParams", "Threshold must be non-negative.");
+    if (!(params[1] >= 1 && params[1] < stride) || params[1] != floor(params[1]))
+        mexErrMsgIdAndTxt("tswHist_mx:badParams", "Fine stride must be an integer >= 1 and < stride.");
+    if (!(params[2] >= 0 && params[2] <= 1))
+        mexErrMsgIdAndTxt("tswHist_mx:badParams", "Tail level must be in [0, 1].");
+
+    tswHistAdaptiveResult res;
+    double *edges = (double *)mxMalloc((n_bins + 1) * sizeof(double));
+    if (!tswHistAdaptive(input_norm, input_len, n_bins, win_len, stride, (size_t)params[1],
+                         criterion, params[2], params[0], &res, edges)) {
+        tswHistAdaptiveFree(&res);
+        mexErrMsgIdAndTxt("tswHist_mx:outOfMemory", "Not enough memory for the adaptive windows.");
+    }
+
+    plhs[0] = mxCreateUninitNumericMatrix(n_bins, res.num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateUninitNumericMatrix(1, res.num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    memcpy(mexDoubles(plhs[0]), res.histMat, n_bins * res.num_windows * sizeof(double));
+    memcpy(mexDoubles(plhs[1]), res.loci, res.num_windows * sizeof(double));
+    memcpy(mexDoubles(plhs[2]), edges, (n_bins + 1) * sizeof(double));
+    if (nlhs >= 4) {
+        plhs[3] = mxCreateUninitNumericMatrix(1, res.num_windows, mxDOUBLE_CLASS, mxREAL);
+        memcpy(mexDoubles(plhs[3]), res.stat, res.num_windows * sizeof(double));
+    }
+    tswHistAdaptiveFree(&res);
+    mxFree(edges);
+}
+
+
+/* Phase mode: phase-folded histograms (or quantiles) over revolutions */
+void mexPhase(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+              const double *input_norm, mwSize input_len,
+              mwSize n_bins, mwSize win_revs, mwSize stride_revs) {
+    if (nrhs < 6 || !mxIsDouble(prhs[5]) || mxIsComplex(prhs[5]) || mxGetNumberOfElements(prhs[5]) != input_len)
+        mexErrMsgIdAndTxt("tswHist_mx:badPhase", "Phase must be a real double vector of the length of the input.");
+    const double *phase = mexDoubles(prhs[5]);
+    if (!tswHistPhaseValid(phase, input_len))
+        mexErrMsgIdAndTxt("tswHist_mx:badPhase", "Phase must be finite and nondecreasing (unwrapped, in turns).");
+    double n_phase = 36;
+    const double *probs = NULL;
+    mwSize n_probs = 0;
+    if (nrhs >= 7) {
+        if (!mxIsDouble(prhs[6]) || mxIsComplex(prhs[6]) || mxIsEmpty(prhs[6]))
+            mexErrMsgIdAndTxt("tswHist_mx:badParams", "Parameters must be [n_phase, probs].");
+        n_phase = mexDoubles(prhs[6])[0];
+        probs   = mexDoubles(prhs[6]) + 1;
+        n_probs = mxGetNumberOfElements(prhs[6]) - 1;
+    }
+    if (!(n_phase >= 1) || n_phase != floor(n_phase))
+        mexErrMsgIdAndTxt("tswHist_mx:badParams", "Number of phase bins must be a positive integer.");
+    for (mwSize q = 0; q < n_probs; ++q)
+        if (!(probs[q] >= 0 && probs[q] <= 1))
+            mexErrMsgIdAndTxt("tswHist_mx:badProbs", "Probabilities must be in [0, 1].");
+
+    size_t *rev_starts = (size_t *)mxMalloc((input_len + 1) * sizeof(size_t));
+    size_t n_revs = tswHistPhaseRevolutions(phase, input_len, rev_starts);
+    mwSize num_windows = tswHistPhaseNumWindows(n_revs, win_revs, stride_revs);
+    mwSize rows = (n_probs > 0) ? n_probs : n_bins;
+    plhs[0] = mxCreateUninitNumericMatrix((mwSize)n_phase * rows, num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateUninitNumericMatrix(1, num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistPhase(input_norm, phase, input_len, rev_starts, n_revs, n_bins, (size_t)n_phase,
+                 win_revs, stride_revs, probs, n_probs,
+                 (n_probs > 0) ? NULL : mexDoubles(plhs[0]), (n_probs > 0) ? mexDoubles(plhs[0]) : NULL,
+                 mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+    mwSize dims[3] = {(mwSize)n_phase, rows, num_windows};
+    mxSetDimensions(plhs[0], dims, 3);
+    mxFree(rev_starts);
+}
 
-    if (n_bins <= 2)
-        mexErrMsgIdAndTxt("tswHist_mx:badBins", "Number of bins must be > 2.");
-    if (stride >= win_len)
-        mexErrMsgIdAndTxt("tswHist_mx:strideWin", "Stride must be less than window length.");
+
+/* Segment bounds of the 6th argument (mxMalloc'ed), returns the number of segments */
+mwSize mexSegmentBounds(int nrhs, const mxArray *prhs[], mwSize input_len,
+                        size_t **seg_begin, size_t **seg_end) {
+    if (nrhs < 6 || !mxIsDouble(prhs[5]) || mxIsComplex(prhs[5]) || mxIsEmpty(prhs[5]))
+        mexErrMsgIdAndTxt("tswHist_mx:badSegments", "Segments must be a real double vector or [n_segments x 2] matrix.");
+    mwSize rows = mxGetM(prhs[5]), cols = mxGetN(prhs[5]);
+    mwSize n_segments = (cols == 2 && rows != 1) ? rows : rows * cols;
+    *seg_begin = (size_t *)mxMalloc(n_segments * sizeof(size_t));
+    *seg_end   = (size_t *)mxMalloc(n_segments * sizeof(size_t));
+    if (!tswHistSegmentBounds(mexDoubles(prhs[5]), rows, cols, input_len, *seg_begin, *seg_end))
+        mexErrMsgIdAndTxt("tswHist_mx:badSegments", "Segments must be non-empty and within the input.");
+    return n_segments;
+}
+
+
+/* Segments mode: windows restarted at every segment, with their segment ids */
+void mexSegments(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+                 const double *input_norm, mwSize input_len,
+                 mwSize n_bins, mwSize win_len, mwSize stride) {
+    size_t *seg_begin, *seg_end;
+    mwSize n_segments  = mexSegmentBounds(nrhs, prhs, input_len, &seg_begin, &seg_end);
+    mwSize num_windows = tswHistSegmentsNumWindows(seg_begin, seg_end, n_segments, win_len, stride);
+
+    plhs[0] = mxCreateUninitNumericMatrix(n_bins, num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    double *segment_ids = NULL;
+    if (nlhs >= 4) {
+        plhs[3] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+        segment_ids = mexDoubles(plhs[3]);
+    }
+    tswHistSegments(input_norm, input_len, seg_begin, seg_end, n_segments,
+                    n_bins, win_len, stride,
+                    mexDoubles(plhs[0]), mexDoubles(plhs[1]), segment_ids, mexDoubles(plhs[2]));
+
+    mxFree(seg_begin);
+    mxFree(seg_end);
+}
+
+
+/* Opt-in JIT kernel (see tswHist_jit.h): plan of the last parameters, kept
+   between calls so that the shared object is loaded once */
+static tswHistJitPlan jit_plan;
+static int jit_planned = 0;
+
+static void mexJitFree(void) {
+    if (jit_planned)
+        tswHistJitPlanFree(&jit_plan);
+    jit_planned = 0;
+}
+
+/* Whether the JIT plan of these parameters holds a kernel (a failed
+   compilation is not retried until the parameters, TSWHIST_JIT_DIR,
+   TSWHIST_JIT_CC or TSWHIST_JIT_CFLAGS change) */
+int mexJitPlan(const char *jit_dir, mwSize n_bins, mwSize win_len, mwSize stride) {
+    const char *cc = getenv("TSWHIST_JIT_CC"), *cflags = getenv("TSWHIST_JIT_CFLAGS");
+    if (!jit_planned || jit_plan.n_bins != n_bins || jit_plan.win_len != win_len || jit_plan.stride != stride
+        || strcmp(jit_plan.dir, jit_dir) != 0 || strcmp(jit_plan.cc, cc ? cc : "") != 0
+        || strcmp(jit_plan.cflags, cflags ? cflags : "") != 0) {
+        mexJitFree();
+        mexAtExit(mexJitFree);
+        tswHistJitPlanCreate(&jit_plan, jit_dir, cc, cflags, n_bins, win_len, stride);
+        jit_planned = 1;
+    }
+    return jit_plan.kernel != NULL;
+}
+
+
+/* Histogram mode (default) */
+void mexHist(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[],
+             const double *input_norm, mwSize input_len,
+             mwSize n_bins, mwSize win_len, mwSize stride) {
+    // Few bins and long strides: popcounts of bit-planes (see tswHist_bitplane.h)
+    if (tswHistBitplaneSelected(n_bins, stride)) {
+        mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+        plhs[0] = mxCreateUninitNumericMatrix(n_bins, num_windows, mxDOUBLE_CLASS, mxREAL);
+        plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+        plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+        tswHistBitplane(input_norm, input_len, n_bins, win_len, stride,
+                        mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+        return;
+    }
+
+    // Opt-in kernel specialized at runtime for these parameters
+    const char *jit_dir = getenv("TSWHIST_JIT_DIR");
+    if (jit_dir != NULL && jit_dir[0] != '\0' && mexJitPlan(jit_dir, n_bins, win_len, stride)) {
+        mwSize num_windows = tswHistNumWindows(input_len, win_len, stride);
+        plhs[0] = mxCreateUninitNumericMatrix(n_bins, num_windows, mxDOUBLE_CLASS, mxREAL);
+        plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+        plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+        tswHistJit(&jit_plan, input_norm, input_len,
+                   mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+        return;
+    }
 
     // Compute strided windows loci
     mwSize num_windows = (input_len - win_len) / stride + 1;
@@ -137,4 +579,213 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     mxFree(input_int);
     mxFree(bufferHist);
     mxFree(offsets);
-}
\ No newline at end of file
+}
+
+
+/* Binned-index file input: histograms read from the file's bin indices */
+void mexBinFile(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+    if (nrhs < 3 || nrhs > 4)
+        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [histMat, strided_windows_loci, edges] = tswHist_mx(bin_file, n_bins, win_len, stride)");
+    tswHistBinFile bf;
+    char *path = mxArrayToString(prhs[0]);
+    int ok = tswHistBinFileOpen(&bf, path);
+    mxFree(path);
+    if (!ok)
+        mexErrMsgIdAndTxt("tswHist_mx:badBinFile", "Cannot read the binned-index file.");
+
+    mwSize n_bins  = (mwSize)bf.hdr.n_bins;
+    mwSize win_len = (mwSize)mxGetScalar(prhs[2]);
+    mwSize stride  = (nrhs >= 4) ? (mwSize)mxGetScalar(prhs[3]) : 1;
+    const char *err = NULL;
+    if (!mxIsEmpty(prhs[1]) && (mwSize)mxGetScalar(prhs[1]) != n_bins)
+        err = "Number of bins does not match the binned-index file.";
+    else if (stride >= win_len)
+        err = "Stride must be less than window length.";
+    else if (win_len > bf.hdr.input_len)
+        err = "Window length must not exceed input length.";
+    if (err) {
+        tswHistBinFileClose(&bf);
+        mexErrMsgIdAndTxt("tswHist_mx:badBinFile", "%s", err);
+    }
+
+    mwSize num_windows = tswHistNumWindows((size_t)bf.hdr.input_len, win_len, stride);
+    plhs[0] = mxCreateUninitNumericMatrix(n_bins, num_windows, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistBinned(&bf, win_len, stride, mexDoubles(plhs[0]), mexDoubles(plhs[1]), mexDoubles(plhs[2]));
+    tswHistBinFileClose(&bf);
+}
+
+
+/* Opt-in on-disk cache: key of this call (see tswHist_cache.h) */
+void mexCacheKey(tswHistCacheKey *key, int nrhs, const mxArray *prhs[],
+                 const char *mode, mwSize n_bins, mwSize win_len, mwSize stride) {
+    // Mode parameters: hash of the bytes of every argument after the mode
+    uint64_t param_hash = 0;
+    for (int k = 5; k < nrhs; ++k) {
+        if (mxIsChar(prhs[k])) {
+            char *str = mxArrayToString(prhs[k]);
+            param_hash = tswHistHash64(str, strlen(str), param_hash + k);
+            mxFree(str);
+        } else if (mxIsDouble(prhs[k])) {
+            param_hash = tswHistHashInput(mexDoubles(prhs[k]), mxGetNumberOfElements(prhs[k]) * sizeof(double)) ^ (param_hash * TSWHIST_XXH_P1 + k);
+        }
+    }
+    const mxArray *input_mx = prhs[0];
+    tswHistCacheKeyInit(key,
+        tswHistHashInput(mexDoubles(input_mx), mxGetNumberOfElements(input_mx) * sizeof(double)),
+        mxGetM(input_mx), mxGetN(input_mx), n_bins, win_len, stride, mode, param_hash);
+}
+
+/* Serve the main output from the cache, loci and edges are recomputed */
+int mexCacheLookup(mxArray *plhs[], const char *cache_dir, const tswHistCacheKey *key,
+                   mwSize rows, mwSize num_windows, mwSize n_bins, mwSize stride) {
+    plhs[0] = mxCreateUninitNumericMatrix(rows, num_windows, mxDOUBLE_CLASS, mxREAL);
+    if (!tswHistCacheLookup(cache_dir, key, mexDoubles(plhs[0]), rows, num_windows)) {
+        mxDestroyArray(plhs[0]);
+        plhs[0] = NULL;
+        return 0;
+    }
+    plhs[1] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, n_bins + 1, mxREAL);
+    tswHistLoci(mexDoubles(plhs[1]), num_windows, stride);
+    tswHistEdges(mexDoubles(plhs[2]), n_bins);
+    return 1;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+    // Argument parsing and validation
+    if (nrhs < 3 || nrhs > 7)
+        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [histMat, strided_windows_loci, edges] = tswHist_mx(input, n_bins, win_len, stride, mode, ...)");
+
+    // Binned-index file instead of the input
+    if (mxIsChar(prhs[0])) {
+        mexBinFile(nlhs, plhs, nrhs, prhs);
+        return;
+    }
+
+    // Input
+    const mxArray *input_mx = prhs[0];
+    mwSize n_bins  = (mwSize)mxGetScalar(prhs[1]);
+    mwSize win_len = (mwSize)mxGetScalar(prhs[2]);
+    // Optional stride, set to 1 if not provided
+    mwSize stride  = (nrhs >= 4) ? (mwSize)mxGetScalar(prhs[3]) : 1;
+
+    if (!mxIsDouble(input_mx) || mxIsComplex(input_mx))
+        mexErrMsgIdAndTxt("tswHist_mx:inputNotReal", "Input must be a real double vector.");
+    mwSize input_len    = mxGetNumberOfElements(input_mx);
+    #if MX_HAS_INTERLEAVED_COMPLEX
+        mxDouble *input_norm = mxGetDoubles(input_mx);
+    #else
+        double *input_norm   = mxGetPr(input_mx);
+    #endif
+
+    if (n_bins <= 2)
+        mexErrMsgIdAndTxt("tswHist_mx:badBins", "Number of bins must be > 2.");
+    if (stride >= win_len)
+        mexErrMsgIdAndTxt("tswHist_mx:strideWin", "Stride must be less than window length.");
+    if (win_len > input_len)
+        mexErrMsgIdAndTxt("tswHist_mx:winLen", "Window length must not exceed input length.");
+
+    // Optional output mode
+    char mode[16] = "hist";
+    if (nrhs >= 5) {
+        if (!mxIsChar(prhs[4]) || mxGetNumberOfElements(prhs[4]) >= sizeof(mode))
+            mexErrMsgIdAndTxt("tswHist_mx:badMode", "Mode must be a character vector.");
+        char *str = mxArrayToString(prhs[4]);
+        strcpy(mode, str);
+        mxFree(str);
+    }
+
+    // Number of rows of the main output and of windows for each mode
+    mwSize rows, num_windows;
+    if (strcmp(mode, "hist") == 0 || strcmp(mode, "pooled") == 0 || strcmp(mode, "segments") == 0
+        || strcmp(mode, "adaptive") == 0 || strcmp(mode, "phase") == 0)
+        rows = n_bins;
+    else if (strcmp(mode, "robust") == 0)
+        rows = TSWHIST_ROBUST_NSTATS;
+    else if (strcmp(mode, "otsu") == 0 || strcmp(mode, "minerror") == 0)
+        rows = TSWHIST_THRESHOLD_NROWS;
+    else if (strcmp(mode, "codebook") == 0)
+        rows = TSWHIST_CODEBOOK_NROWS;
+    else if (strcmp(mode, "exact") == 0)
+        rows = (nrhs >= 6) ? mxGetNumberOfElements(prhs[5]) : 1;
+    else if (strcmp(mode, "connectivity") == 0)
+        rows = (mexConnLayout(nrhs, prhs) == TSWHIST_CONN_TRIU) ? tswHistConnNumPairs(mxGetN(input_mx))
+                                                                : mxGetN(input_mx) * mxGetN(input_mx);
+    else
+        mexErrMsgIdAndTxt("tswHist_mx:badMode", "Unknown mode. Use 'hist', 'robust', 'otsu', 'minerror', 'pooled', 'connectivity', 'segments', 'codebook', 'exact', 'adaptive' or 'phase'.");
+    int conn_full = (strcmp(mode, "connectivity") == 0 && mexConnLayout(nrhs, prhs) == TSWHIST_CONN_FULL);
+    if (strcmp(mode, "pooled") == 0 || strcmp(mode, "connectivity") == 0)
+        num_windows = (win_len <= mxGetM(input_mx)) ? tswHistNumWindows(mxGetM(input_mx), win_len, stride) : 0;
+    else
+        num_windows = tswHistNumWindows(input_len, win_len, stride);
+
+    // Opt-in workload recorder, enabled by the TSWHIST_RECORD_LOG environment
+    // variable: shape, wall time and value sketch of the call (see
+    // tswHist_record.h), including the cache hits
+    const char *record_log = getenv("TSWHIST_RECORD_LOG");
+    int record = (record_log != NULL && record_log[0] != '\0');
+    tswHistRecord rec;
+    if (record) {
+        int channels = (strcmp(mode, "pooled") == 0 || strcmp(mode, "connectivity") == 0);
+        tswHistRecordInit(&rec, "tswHist_mx", mode, input_norm, channels ? mxGetM(input_mx) : input_len,
+                          channels ? mxGetN(input_mx) : 1, n_bins, win_len, stride);
+    }
+    double t_start = tswHistRecordNow();
+
+    // Opt-in on-disk cache, enabled by the TSWHIST_CACHE_DIR environment
+    // variable (size cap in MB: TSWHIST_CACHE_MAX_MB, default: 1024). Only the
+    // main output is cached, so calls requesting more outputs bypass it, as do
+    // segments, adaptive and phase-folded windows whose loci are not
+    // recomputed from the stride alone.
+    const char *cache_dir = getenv("TSWHIST_CACHE_DIR");
+    int use_cache = (cache_dir != NULL && cache_dir[0] != '\0' && nlhs <= 3 && num_windows > 0
+                     && strcmp(mode, "segments") != 0 && strcmp(mode, "adaptive") != 0
+                     && strcmp(mode, "phase") != 0);
+    tswHistCacheKey key;
+    if (use_cache) {
+        mexCacheKey(&key, nrhs, prhs, mode, n_bins, win_len, stride);
+        if (mexCacheLookup(plhs, cache_dir, &key, rows, num_windows, n_bins, stride)) {
+            if (conn_full)
+                mexConnDims(plhs[0], mxGetN(input_mx), num_windows);
+            if (record)
+                tswHistRecordAppend(record_log, &rec, t_start);
+            return;
+        }
+    }
+
+    if (strcmp(mode, "robust") == 0)
+        mexRobust(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride);
+    else if (strcmp(mode, "otsu") == 0)
+        mexThreshold(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride, TSWHIST_THRESHOLD_OTSU);
+    else if (strcmp(mode, "minerror") == 0)
+        mexThreshold(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride, TSWHIST_THRESHOLD_MINERROR);
+    else if (strcmp(mode, "pooled") == 0)
+        mexPooled(nlhs, plhs, nrhs, prhs, input_norm, n_bins, win_len, stride);
+    else if (strcmp(mode, "exact") == 0)
+        mexExact(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride);
+    else if (strcmp(mode, "codebook") == 0)
+        mexCodebook(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride);
+    else if (strcmp(mode, "phase") == 0)
+        mexPhase(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride);
+    else if (strcmp(mode, "adaptive") == 0)
+        mexAdaptive(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride);
+    else if (strcmp(mode, "segments") == 0)
+        mexSegments(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride);
+    else if (strcmp(mode, "connectivity") == 0)
+        mexConnectivity(nlhs, plhs, nrhs, prhs, input_norm, n_bins, win_len, stride);
+    else
+        mexHist(nlhs, plhs, nrhs, prhs, input_norm, input_len, n_bins, win_len, stride);
+
+    if (use_cache) {
+        const char *max_mb = getenv("TSWHIST_CACHE_MAX_MB");
+        size_t max_bytes = (size_t)((max_mb ? atof(max_mb) : 1024.0) * 1024 * 1024);
+        tswHistCacheStore(cache_dir, max_bytes, &key, mexDoubles(plhs[0]), rows, num_windows);
+    }
+    if (conn_full)
+        mexConnDims(plhs[0], mxGetN(input_mx), num_windows);
+    if (record)
+        tswHistRecordAppend(record_log, &rec, t_start);
+}
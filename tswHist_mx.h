@@ -5,7 +5,9 @@
  *   using integer binning and differential updates. Used by the tswHist_mx MEX gateway.
  *
  *   The pushHist and popHist functions incrementally update histogram vectors.
- *   The tswHistSlidingWindow function implements the main sliding window logic.
+ *   The tswHistSlidingWindow function implements the main sliding window logic,
+ *   applying the popped and pushed runs of each step with the batched kernels
+ *   of tswHist_batch.h.
  *
  *   The core logic is adapted from the essential version of hist_int in:
  *   https://github.com/cyber-g/FastHist
@@ -18,8 +20,11 @@
  *   August 2025; Last revision:
  */
 
+#ifndef TSWHIST_MX_H
+#define TSWHIST_MX_H
 
 #include "mex.h"
+#include "tswHist_batch.h"
 
 void pushHist(double *hist_vec, const double *input_int, mwSize len, mwSize n_bins) {
     for (mwSize i = 0; i < len; ++i) {
@@ -51,23 +56,39 @@ void tswHistSlidingWindow(
     const double *offsets,
     mwSize input_len
 ) {
+    // Consecutive offsets (tswHistOffsets): the popped and pushed samples of
+    // a step are two runs, updated by batches (tswHist_batch.h)
+    int runs = (stride > 0);
+    for (mwSize j = 1; j < stride; ++j)
+        runs &= (offsets[j] == offsets[j - 1] + 1);
     for (mwSize w = 1; w < num_windows; ++w) {
-        // pop indices
-        mwSize base_pop = (mwSize)strided_windows_loci[w] - 2; // -1 for 0-based, -1 for previous window
-        for (mwSize j = 0; j < stride; ++j) {
-            mwSize idx = base_pop + (mwSize)offsets[j];
-            if (idx < input_len)
-                popHist(bufferHist, &input_int[idx], 1, n_bins);
-        }
-        // push indices
+        mwSize base_pop  = (mwSize)strided_windows_loci[w] - 2; // -1 for 0-based, -1 for previous window
         mwSize base_push = (mwSize)strided_windows_loci[w] + win_len - 2;
-        for (mwSize j = 0; j < stride; ++j) {
-            mwSize idx = base_push + (mwSize)offsets[j];
-            if (idx < input_len)
-                pushHist(bufferHist, &input_int[idx], 1, n_bins);
+        // offsets are <= 0: converted through a signed type (a negative
+        // double to unsigned conversion is undefined)
+        long long first_pop  = (long long)base_pop + (runs ? (long long)offsets[0] : 0);
+        long long first_push = (long long)base_push + (runs ? (long long)offsets[0] : 0);
+        if (runs && first_pop >= 0 && first_push + (long long)stride <= (long long)input_len) {
+            tswHistBatchUpdate(bufferHist, &input_int[first_pop], stride, n_bins, -1);
+            tswHistBatchUpdate(bufferHist, &input_int[first_push], stride, n_bins, +1);
+        } else {
+            // pop indices
+            for (mwSize j = 0; j < stride; ++j) {
+                mwSize idx = base_pop + (mwSize)(long long)offsets[j];
+                if (idx < input_len)
+                    popHist(bufferHist, &input_int[idx], 1, n_bins);
+            }
+            // push indices
+            for (mwSize j = 0; j < stride; ++j) {
+                mwSize idx = base_push + (mwSize)(long long)offsets[j];
+                if (idx < input_len)
+                    pushHist(bufferHist, &input_int[idx], 1, n_bins);
+            }
         }
         // Store
         for (mwSize b = 0; b < n_bins; ++b)
             histMat[b + w * n_bins] = bufferHist[b];
     }
-}
\ No newline at end of file
+}
+
+#endif // TSWHIST_MX_H
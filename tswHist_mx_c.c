@@ -14,19 +14,27 @@
  *
  *   Usage from matlab:
  *     [histMat, strided_windows_loci, edges] = tswHist_mx_c(input, n_bins, win_len, stride)
+ *     [histMat, strided_windows_loci, edges, segment_ids] = tswHist_mx_c(input, n_bins, win_len, stride, segments)
  *
  *   Inputs:
  *     input    - Input vector (real double, 1D)
  *     n_bins   - Number of histogram bins (integer > 2)
  *     win_len  - Sliding window length
  *     stride   - Stride for sliding window (default: 1)
+ *     segments - (optional) segment start indices, or [n_segments x 2] matrix
+ *                of [start, end] indices: windows are restarted at every
+ *                segment and never cross a segment bound (see tswHistSegments)
  *
  *   Outputs:
  *     histMat              - n_bins x num_windows matrix of histograms
  *     strided_windows_loci - Start indices of each window (1-based)
  *     edges                - Bin edges used for histogramming
+ *     segment_ids          - (optional) segment index of each window (1-based)
  *
- *   See also: tswHist.m, hist_int_mx.c
+ *   Calls are appended to the workload log TSWHIST_RECORD_LOG when this
+ *   environment variable is set (see tswHist_record.h).
+ *
+ *   See also: tswHist.m, hist_int_mx.c, tswHist_record.h
  *
  *   Project: tswHist (https://github.com/cyber-g/tswHist)
  *
@@ -40,12 +48,14 @@
 #include "mex.h"
 #include <math.h>
 #include "tswHist.h"
+#include "tswHist_bitplane.h"
+#include "tswHist_record.h"
 
 
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     // Argument parsing and validation
-    if (nrhs < 3 || nrhs > 4)
-        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [histMat, strided_windows_loci, edges] = tswHist_mx_c(input, n_bins, win_len, stride)");
+    if (nrhs < 3 || nrhs > 5)
+        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [histMat, strided_windows_loci, edges] = tswHist_mx_c(input, n_bins, win_len, stride, segments)");
 
     // Input
     const mxArray *input_mx = prhs[0];
@@ -67,8 +77,29 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     if (stride >= win_len)
         mexErrMsgIdAndTxt("tswHist_mx:strideWin", "Stride must be less than window length.");
 
+    // Optional segments
+    size_t *seg_begin = NULL, *seg_end = NULL;
+    mwSize n_segments = 0;
+    if (nrhs >= 5) {
+        const mxArray *seg_mx = prhs[4];
+        if (!mxIsDouble(seg_mx) || mxIsComplex(seg_mx) || mxIsEmpty(seg_mx))
+            mexErrMsgIdAndTxt("tswHist_mx:badSegments", "Segments must be a real double vector or [n_segments x 2] matrix.");
+        mwSize rows = mxGetM(seg_mx), cols = mxGetN(seg_mx);
+        n_segments = (cols == 2 && rows != 1) ? rows : rows * cols;
+        seg_begin  = (size_t *)mxMalloc(n_segments * sizeof(size_t));
+        seg_end    = (size_t *)mxMalloc(n_segments * sizeof(size_t));
+#if MX_HAS_INTERLEAVED_COMPLEX
+        const double *segments = mxGetDoubles(seg_mx);
+#else
+        const double *segments = mxGetPr(seg_mx);
+#endif
+        if (!tswHistSegmentBounds(segments, rows, cols, input_len, seg_begin, seg_end))
+            mexErrMsgIdAndTxt("tswHist_mx:badSegments", "Segments must be non-empty and within the input.");
+    }
+
     // Compute number of windows
-    mwSize num_windows = (input_len - win_len) / stride + 1;
+    mwSize num_windows = seg_begin ? tswHistSegmentsNumWindows(seg_begin, seg_end, n_segments, win_len, stride)
+                                   : (input_len - win_len) / stride + 1;
 
     // Allocate outputs
     plhs[0] = mxCreateDoubleMatrix(n_bins, num_windows, mxREAL);
@@ -85,13 +116,51 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     double *edges = mxGetPr(plhs[2]);
 #endif
 
+    // Opt-in workload recorder (see tswHist_record.h)
+    const char *record_log = getenv("TSWHIST_RECORD_LOG");
+    int record = (record_log != NULL && record_log[0] != '\0');
+    tswHistRecord rec;
+    if (record)
+        tswHistRecordInit(&rec, "tswHist_mx_c", seg_begin ? "segments" : "hist", input, input_len, 1,
+                          n_bins, win_len, stride);
+    double t_start = tswHistRecordNow();
+
     // Call pure C implementation
-    tswHist(
-        input, input_len,
-        n_bins, win_len, stride,
-        histMat,
-        strided_windows_loci,
-        edges
-    );
+    if (seg_begin) {
+        double *segment_ids = NULL;
+        if (nlhs >= 4) {
+            plhs[3] = mxCreateDoubleMatrix(1, num_windows, mxREAL);
+#if MX_HAS_INTERLEAVED_COMPLEX
+            segment_ids = mxGetDoubles(plhs[3]);
+#else
+            segment_ids = mxGetPr(plhs[3]);
+#endif
+        }
+        tswHistSegments(
+            input, input_len,
+            seg_begin, seg_end, n_segments,
+            n_bins, win_len, stride,
+            histMat,
+            strided_windows_loci,
+            segment_ids,
+            edges
+        );
+        mxFree(seg_begin);
+        mxFree(seg_end);
+    } else if (tswHistBitplaneSelected(n_bins, stride)) {
+        // Few bins and long strides: popcounts of bit-planes (see tswHist_bitplane.h)
+        tswHistBitplane(input, input_len, n_bins, win_len, stride,
+                        histMat, strided_windows_loci, edges);
+    } else {
+        tswHist(
+            input, input_len,
+            n_bins, win_len, stride,
+            histMat,
+            strided_windows_loci,
+            edges
+        );
+    }
 
+    if (record)
+        tswHistRecordAppend(record_log, &rec, t_start);
 }
\ No newline at end of file
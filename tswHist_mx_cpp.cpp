@@ -0,0 +1,709 @@
+/*
+ * tswHist_mx_cpp.cpp - Fast sliding window histogram computation (C++ MEX gateway)
+ *
+ *   Twin MEX function for tswHist.m using the MATLAB Data API
+ *
+ *   Compared to tswHist_mx.c, the inputs are received as typed arrays
+ *   (double or single) without copies, and the outputs are created
+ *   uninitialized, in the requested numeric type: histMat is not zero-filled
+ *   by MATLAB before the engine overwrites it. Options are given as
+ *   name-value pairs, parsed once per call. All modes of the pure C engines
+ *   (tswHist.h, tswHist_*.h) are reachable.
+ *
+ *   Please read tswHist.m for more information.
+ *
+ *   Usage from matlab:
+ *     [out, strided_windows_loci, edges, labels] = tswHist_mx_cpp(input, Name, Value, ...)
+ *     [histMat, windows_loci, edges, stat] = tswHist_mx_cpp(input, 'Mode', 'adaptive', Name, Value, ...)
+ *     [histMat, strided_windows_loci, edges, segment_ids] = tswHist_mx_cpp(input, 'Segments', segments, Name, Value, ...)
+ *     [histMat, strided_windows_loci, edges] = tswHist_mx_cpp(bin_file, 'Window', win_len, Name, Value, ...)
+ *
+ *   Inputs:
+ *     input    - Input vector (real double or single, 1D), or matrix
+ *                [input_len x n_channels] for the 'pooled' and 'connectivity'
+ *                modes
+ *     bin_file - Name of a binned-index file (see tswHist_binfile.h): double
+ *                histograms of the 'hist' mode, read from the file's bin
+ *                indices. 'Bins' may be omitted, or must match the file.
+ *
+ *   Name-value options:
+ *     'Bins'       - Number of histogram bins (integer > 2, required except
+ *                    with a bin_file)
+ *     'Window'     - Sliding window length (required)
+ *     'Stride'     - Stride for sliding window (default: 1)
+ *     'Mode'       - 'hist' (default), 'robust', 'otsu', 'minerror', 'pooled',
+ *                    'connectivity', 'codebook', 'exact', 'adaptive' or 'phase'
+ *                    (see tswHist_mx.c). In the 'phase' mode, Window and
+ *                    Stride count revolutions.
+ *     'Trim'       - Trim fraction of the 'robust' mode (default: 0.1)
+ *     'Layout'     - 'full' (default) or 'triu', layout of the 'connectivity'
+ *                    mode
+ *     'Prototypes' - [n_bins x K] prototype histograms of the 'codebook' mode
+ *     'Metric'     - 'l2' (default) or 'dot', metric of the 'codebook' mode
+ *     'Probs'      - Probabilities of the quantiles, in [0, 1], of the 'exact'
+ *                    mode (default: 0.5, the median) and of the 'phase' mode
+ *                    (default: none, histograms)
+ *     'Phase'      - Unwrapped phase of every sample in turns (nondecreasing,
+ *                    real double), required by the 'phase' mode
+ *     'NPhase'     - Number of phase bins of the 'phase' mode (default: 36)
+ *     'Criterion'  - 'entropy' (default) or 'tail', statistic of the
+ *                    'adaptive' mode
+ *     'Threshold'  - Jump of the statistic triggering a backfill ('adaptive'
+ *                    mode, default: 0.1)
+ *     'FineStride' - Stride of the backfilled windows ('adaptive' mode,
+ *                    integer < Stride, default: 1)
+ *     'TailLevel'  - Level of the 'tail' criterion, in [0, 1] (default: 0.9)
+ *     'OutputType' - Class of the main output: 'double' (default), 'single',
+ *                    'uint8', 'uint16', 'uint32' or 'int32' (integer classes
+ *                    only for the 'hist' and 'pooled' modes, and able to hold
+ *                    the count of a full window: Window, times the number of
+ *                    channels for 'pooled')
+ *     'Threads'    - Number of threads of the 'hist' mode (default: 1,
+ *                    0 for the OpenMP default). Long windows with double
+ *                    outputs use the scan of tswHist_scan.h instead of a
+ *                    full count per thread.
+ *     'Segments'   - Segment start indices, or [n_segments x 2] matrix of
+ *                    [start, end] indices ('hist' mode): windows are restarted
+ *                    at every segment and never cross a segment bound
+ *
+ *   Workload recorder:
+ *     As in tswHist_mx.c, every call is appended to the log named by the
+ *     environment variable TSWHIST_RECORD_LOG (see tswHist_record.h), with
+ *     the class of the input (double or single). Binned-index file inputs
+ *     are not recorded.
+ *
+ *   Outputs:
+ *     out                  - histMat, robustMat, threshMat, miMat, codeMat or quantMat
+ *                            depending on the mode (see tswHist_mx.c). The
+ *                            'phase' mode returns the [NPhase x n_bins x
+ *                            num_windows] phase-folded histograms, or the
+ *                            [NPhase x numel(Probs) x num_windows] quantiles.
+ *     strided_windows_loci - Start indices of each window (1-based), coarse
+ *                            and backfilled ones in the 'adaptive' mode,
+ *                            first sample of each window in the 'phase' mode
+ *     edges                - Bin edges used for histogramming
+ *     stat                 - (optional, 'adaptive' mode) statistic of each
+ *                            window
+ *     labels               - (optional, 'otsu' and 'minerror' modes) per-sample
+ *                            logical labels
+ *     segment_ids          - (optional, with 'Segments') segment index of each
+ *                            window (1-based)
+ *
+ *   See also: tswHist.m, tswHist_mx.c, tswHist.h
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom Paris, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#include "mex.hpp"
+#include "mexAdapter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "tswHist.h"
+#include "tswHist_robust.h"
+#include "tswHist_threshold.h"
+#include "tswHist_pooled.h"
+#include "tswHist_connectivity.h"
+#include "tswHist_codebook.h"
+#include "tswHist_exact.h"
+#include "tswHist_adaptive.h"
+#include "tswHist_phase.h"
+#include "tswHist_scan.h"
+#include "tswHist_binfile.h"
+#include "tswHist_record.h"
+
+using matlab::data::Array;
+using matlab::data::ArrayFactory;
+using matlab::data::ArrayType;
+using matlab::mex::ArgumentList;
+
+// Windows computed per block when storing into a non-double output
+#define TSWHIST_CPP_BLOCK 256
+
+struct tswHistOptions {
+    size_t      n_bins   = 0;
+    size_t      win_len  = 0;
+    size_t      stride   = 1;
+    size_t      threads  = 1;
+    double      trim     = 0.1;
+    std::string mode     = "hist";
+    std::string layout   = "full";
+    std::vector<double> segments;
+    size_t seg_rows = 0, seg_cols = 0;
+    std::vector<double> prototypes;
+    size_t n_prototypes = 0;
+    std::string metric   = "l2";
+    std::vector<double> probs;              // empty: median ('exact'), histograms ('phase')
+    const double *phase = NULL;             // into the inputs, no copy
+    size_t phase_len = 0;
+    double n_phase = 36;
+    std::string criterion = "entropy";
+    double      threshold   = 0.1;
+    double      fine_stride = 1;
+    double      tail_level  = 0.9;
+    std::string out_type = "double";
+};
+
+class MexFunction : public matlab::mex::Function {
+    ArrayFactory factory;
+    std::shared_ptr<matlab::engine::MATLABEngine> matlabPtr = getEngine();
+
+public:
+    void operator()(ArgumentList outputs, ArgumentList inputs) override {
+        if (inputs.size() < 1)
+            error("tswHist_mx:invalidNumInputs", "Usage: [out, strided_windows_loci, edges] = tswHist_mx_cpp(input, Name, Value, ...)");
+        const Array &input = inputs[0];
+        tswHistOptions opt = parseOptions(inputs, input.getType() == ArrayType::CHAR);
+
+        if (input.getType() == ArrayType::CHAR) {
+            runBinFile(outputs, charOption(input, "Binned-index file"), opt);
+        } else if (input.getType() == ArrayType::DOUBLE) {
+            const matlab::data::TypedArray<double> x = input;
+            run<double>(outputs, &*x.cbegin(), input.getDimensions(), opt);
+        } else if (input.getType() == ArrayType::SINGLE) {
+            const matlab::data::TypedArray<float> x = input;
+            run<float>(outputs, &*x.cbegin(), input.getDimensions(), opt);
+        } else {
+            error("tswHist_mx:inputNotReal", "Input must be a real double or single array, or a binned-index file name.");
+        }
+    }
+
+private:
+    void error(const std::string &id, const std::string &msg) {
+        matlabPtr->feval(u"error", 0, std::vector<Array>({factory.createCharArray(id), factory.createCharArray(msg)}));
+    }
+
+    double scalarOption(const Array &value, const std::string &name) {
+        if (value.getType() != ArrayType::DOUBLE || value.getNumberOfElements() != 1)
+            error("tswHist_mx:badOption", name + " must be a real double scalar.");
+        const matlab::data::TypedArray<double> v = value;
+        return v[0];
+    }
+
+    std::string charOption(const Array &value, const std::string &name) {
+        if (value.getType() != ArrayType::CHAR)
+            error("tswHist_mx:badOption", name + " must be a character vector.");
+        const matlab::data::CharArray c = value;
+        return c.toAscii();
+    }
+
+    void segmentsOption(const Array &value, tswHistOptions &opt) {
+        if (value.getType() != ArrayType::DOUBLE || value.getNumberOfElements() == 0)
+            error("tswHist_mx:badSegments", "Segments must be a real double vector or [n_segments x 2] matrix.");
+        const matlab::data::TypedArray<double> v = value;
+        opt.segments.assign(v.cbegin(), v.cend());
+        opt.seg_rows = value.getDimensions()[0];
+        opt.seg_cols = value.getNumberOfElements() / opt.seg_rows;
+    }
+
+    void probsOption(const Array &value, tswHistOptions &opt) {
+        if (value.getType() != ArrayType::DOUBLE || value.getNumberOfElements() == 0)
+            error("tswHist_mx:badProbs", "Probabilities must be a real double vector.");
+        const matlab::data::TypedArray<double> v = value;
+        opt.probs.assign(v.cbegin(), v.cend());
+        for (double p : opt.probs)
+            if (!(p >= 0 && p <= 1))
+                error("tswHist_mx:badProbs", "Probabilities must be in [0, 1].");
+    }
+
+    void phaseOption(const Array &value, tswHistOptions &opt) {
+        if (value.getType() != ArrayType::DOUBLE)
+            error("tswHist_mx:badPhase", "Phase must be a real double vector of the length of the input.");
+        const matlab::data::TypedArray<double> v = value;
+        opt.phase_len = value.getNumberOfElements();
+        opt.phase = (opt.phase_len > 0) ? &*v.cbegin() : NULL;
+    }
+
+    void prototypesOption(const Array &value, tswHistOptions &opt) {
+        if (value.getType() != ArrayType::DOUBLE || value.getNumberOfElements() == 0)
+            error("tswHist_mx:badPrototypes", "Prototypes must be a real double [n_bins x K] matrix.");
+        const matlab::data::TypedArray<double> v = value;
+        opt.prototypes.assign(v.cbegin(), v.cend());
+        opt.n_prototypes = value.getNumberOfElements() / value.getDimensions()[0];
+    }
+
+    // The number of bins of a binned-index file is read from the file
+    tswHistOptions parseOptions(ArgumentList &inputs, bool bin_file) {
+        tswHistOptions opt;
+        if (inputs.size() % 2 != 1)
+            error("tswHist_mx:invalidNumInputs", "Options must be given as name-value pairs.");
+        for (size_t k = 1; k + 1 < inputs.size(); k += 2) {
+            std::string name = charOption(inputs[k], "Option name");
+            for (auto &ch : name)
+                ch = (char)tolower(ch);
+            if (name == "bins")            opt.n_bins   = (size_t)scalarOption(inputs[k + 1], "Bins");
+            else if (name == "window")     opt.win_len  = (size_t)scalarOption(inputs[k + 1], "Window");
+            else if (name == "stride")     opt.stride   = (size_t)scalarOption(inputs[k + 1], "Stride");
+            else if (name == "threads")    opt.threads  = (size_t)scalarOption(inputs[k + 1], "Threads");
+            else if (name == "trim")       opt.trim     = scalarOption(inputs[k + 1], "Trim");
+            else if (name == "mode")       opt.mode     = charOption(inputs[k + 1], "Mode");
+            else if (name == "outputtype") opt.out_type = charOption(inputs[k + 1], "OutputType");
+            else if (name == "layout")     opt.layout   = charOption(inputs[k + 1], "Layout");
+            else if (name == "segments")   segmentsOption(inputs[k + 1], opt);
+            else if (name == "prototypes") prototypesOption(inputs[k + 1], opt);
+            else if (name == "metric")     opt.metric   = charOption(inputs[k + 1], "Metric");
+            else if (name == "probs")      probsOption(inputs[k + 1], opt);
+            else if (name == "phase")      phaseOption(inputs[k + 1], opt);
+            else if (name == "nphase")     opt.n_phase = scalarOption(inputs[k + 1], "NPhase");
+            else if (name == "criterion")  opt.criterion   = charOption(inputs[k + 1], "Criterion");
+            else if (name == "threshold")  opt.threshold   = scalarOption(inputs[k + 1], "Threshold");
+            else if (name == "finestride") opt.fine_stride = scalarOption(inputs[k + 1], "FineStride");
+            else if (name == "taillevel")  opt.tail_level  = scalarOption(inputs[k + 1], "TailLevel");
+            else error("tswHist_mx:badOption", "Unknown option " + name + ".");
+        }
+        if (opt.n_bins <= 2 && !(bin_file && opt.n_bins == 0))
+            error("tswHist_mx:badBins", "Number of bins must be > 2.");
+        if (opt.win_len == 0 || opt.stride == 0 || opt.stride >= opt.win_len)
+            error("tswHist_mx:strideWin", "Stride must be positive and less than window length.");
+        if (!(opt.trim >= 0 && opt.trim < 0.5))
+            error("tswHist_mx:badTrim", "Trim fraction must be in [0, 0.5).");
+        if (opt.layout != "full" && opt.layout != "triu")
+            error("tswHist_mx:badLayout", "Layout must be 'full' or 'triu'.");
+        if (opt.metric != "l2" && opt.metric != "dot")
+            error("tswHist_mx:badMetric", "Metric must be 'l2' or 'dot'.");
+        if (opt.criterion != "entropy" && opt.criterion != "tail")
+            error("tswHist_mx:badCriterion", "Criterion must be 'entropy' or 'tail'.");
+        if (!(opt.threshold >= 0))
+            error("tswHist_mx:badParams", "Threshold must be non-negative.");
+        if (opt.mode == "adaptive" && (!(opt.fine_stride >= 1 && opt.fine_stride < opt.stride)
+                                       || opt.fine_stride != std::floor(opt.fine_stride)))
+            error("tswHist_mx:badParams", "Fine stride must be an integer >= 1 and < stride.");
+        if (!(opt.tail_level >= 0 && opt.tail_level <= 1))
+            error("tswHist_mx:badParams", "Tail level must be in [0, 1].");
+        if (!(opt.n_phase >= 1) || opt.n_phase != std::floor(opt.n_phase))
+            error("tswHist_mx:badParams", "Number of phase bins must be a positive integer.");
+        if (opt.mode == "codebook" && opt.prototypes.size() != opt.n_bins * opt.n_prototypes)
+            error("tswHist_mx:badPrototypes", "Prototypes must be a real double [n_bins x K] matrix.");
+        return opt;
+    }
+
+    // Uninitialized output of class T and dimensions dims, filled by fill(T *)
+    template <typename T, typename F>
+    Array createOutput(matlab::data::ArrayDimensions dims, F fill) {
+        size_t numel = 1;
+        for (auto d : dims)
+            numel *= d;
+        matlab::data::buffer_ptr_t<T> buf = factory.createBuffer<T>(numel);
+        fill(buf.get());
+        return factory.createArrayFromBuffer<T>(dims, std::move(buf));
+    }
+
+    template <typename T, typename F>
+    Array createOutput(size_t rows, size_t cols, F fill) {
+        return createOutput<T>(matlab::data::ArrayDimensions({rows, cols}), fill);
+    }
+
+    // Binning stage (same as tswHistBinning) for any input class
+    template <typename T>
+    void binning(const T *input_norm, size_t input_len, size_t n_bins, double *input_int) {
+        for (size_t i = 0; i < input_len; ++i) {
+            int bin = (int)std::floor((double)input_norm[i] * n_bins);
+            if (bin == (int)n_bins) bin = n_bins - 1; // Patch for max value
+            input_int[i] = (double)bin;
+        }
+    }
+
+    template <typename T>
+    void binningInterleaved(const T *input_norm, size_t input_len, size_t n_channels, size_t n_bins, double *input_int) {
+        for (size_t c = 0; c < n_channels; ++c) {
+            for (size_t i = 0; i < input_len; ++i) {
+                int bin = (int)std::floor((double)input_norm[c * input_len + i] * n_bins);
+                if (bin == (int)n_bins) bin = n_bins - 1; // Patch for max value
+                input_int[i * n_channels + c] = (double)bin;
+            }
+        }
+    }
+
+    // Histograms of the windows [w_begin, w_end) stored as class O. Double
+    // outputs are written in place, other classes through a small block of
+    // double columns which stays in cache.
+    template <typename O>
+    void histRange(O *out, const double *input_int, const double *loci, const double *offsets,
+                   size_t w_begin, size_t w_end, const tswHistOptions &opt, size_t input_len) {
+        size_t n_bins = opt.n_bins;
+        std::vector<double> bufferHist(n_bins);
+        if (std::is_same<O, double>::value) {
+            tswHistWindowRange((double *)out + w_begin * n_bins, bufferHist.data(), input_int, loci,
+                               w_begin, w_end, opt.win_len, n_bins, opt.stride, offsets, input_len);
+            return;
+        }
+        std::vector<double> block((TSWHIST_CPP_BLOCK + 1) * n_bins);
+        for (size_t w0 = w_begin; w0 < w_end; w0 += TSWHIST_CPP_BLOCK) {
+            size_t n = (w_end - w0 < TSWHIST_CPP_BLOCK) ? w_end - w0 : TSWHIST_CPP_BLOCK;
+            double *cols;
+            if (w0 == w_begin) {
+                // Seed with the first window of the range, block column 0
+                tswHistWindowRange(block.data(), bufferHist.data(), input_int, loci,
+                                   w0, w0 + n, opt.win_len, n_bins, opt.stride, offsets, input_len);
+                cols = block.data();
+            } else {
+                // Keep sliding from window w0 - 1, block columns 1..n
+                tswHistSlidingWindow(block.data(), bufferHist.data(), input_int, &loci[w0 - 1],
+                                     n + 1, opt.win_len, n_bins, opt.stride, offsets, input_len);
+                cols = block.data() + n_bins;
+            }
+            for (size_t k = 0; k < n * n_bins; ++k)
+                out[w0 * n_bins + k] = (O)cols[k];
+        }
+    }
+
+    // Histograms of the window ranges [ranges[r], ranges[r+1]), each range
+    // seeded by a full count of its first window and computed by one thread
+    template <typename O>
+    Array histOutput(const double *input_int, const double *loci, size_t num_windows,
+                     const std::vector<size_t> &ranges, const tswHistOptions &opt, size_t input_len) {
+        std::vector<double> offsets(opt.stride);
+        tswHistOffsets(offsets.data(), opt.stride);
+        return createOutput<O>(opt.n_bins, num_windows, [&](O *out) {
+            size_t n_ranges = ranges.size() - 1;
+            #pragma omp parallel for num_threads((int)tswHistNumThreads(opt.threads)) schedule(dynamic)
+            for (long long r = 0; r < (long long)n_ranges; ++r) {
+                if (ranges[r] < ranges[r + 1])
+                    histRange<O>(out, input_int, loci, offsets.data(), ranges[r], ranges[r + 1], opt, input_len);
+            }
+        });
+    }
+
+    // Pooled histograms stored as class O, in place for double outputs,
+    // through a block of double columns for other classes (as histRange)
+    template <typename O>
+    Array pooledOutput(const double *input_int, size_t num_windows, size_t n_channels, const tswHistOptions &opt) {
+        size_t n_bins = opt.n_bins;
+        std::vector<double> bufferHist(n_bins, 0.0);
+        return createOutput<O>(n_bins, num_windows, [&](O *out) {
+            pushHist(bufferHist.data(), input_int, opt.win_len * n_channels, n_bins);
+            for (size_t b = 0; b < n_bins; ++b)
+                out[b] = (O)bufferHist[b];
+            if (std::is_same<O, double>::value) {
+                tswHistPooledSlidingWindow((double *)out, bufferHist.data(), input_int,
+                                           num_windows, opt.win_len, n_bins, opt.stride, n_channels);
+                return;
+            }
+            std::vector<double> block((TSWHIST_CPP_BLOCK + 1) * n_bins);
+            for (size_t w0 = 1; w0 < num_windows; w0 += TSWHIST_CPP_BLOCK) {
+                size_t n = (num_windows - w0 < TSWHIST_CPP_BLOCK) ? num_windows - w0 : TSWHIST_CPP_BLOCK;
+                // Keep sliding from window w0 - 1, block columns 1..n
+                tswHistPooledSlidingWindow(block.data(), bufferHist.data(),
+                                           &input_int[(w0 - 1) * opt.stride * n_channels],
+                                           n + 1, opt.win_len, n_bins, opt.stride, n_channels);
+                for (size_t k = 0; k < n * n_bins; ++k)
+                    out[w0 * n_bins + k] = (O)block[n_bins + k];
+            }
+        });
+    }
+
+    // Output of a statistics engine, filled by compute(double *): in place for
+    // double outputs. These engines carry state across all windows (ranks,
+    // labels, distance resync) and cannot be cut into blocks, so single
+    // outputs are converted from a double result of dims (one column of
+    // statistics per window, not n_bins counts).
+    template <typename F>
+    Array statOutput(matlab::data::ArrayDimensions dims, const std::string &type, F compute) {
+        if (type != "single")
+            return createOutput<double>(dims, compute);
+        size_t numel = 1;
+        for (auto d : dims)
+            numel *= d;
+        std::vector<double> res(numel);
+        compute(res.data());
+        return createOutput<float>(dims, [&](float *out) {
+            for (size_t k = 0; k < numel; ++k)
+                out[k] = (float)res[k];
+        });
+    }
+
+    template <typename F>
+    Array statOutput(size_t rows, size_t cols, const std::string &type, F compute) {
+        return statOutput(matlab::data::ArrayDimensions({rows, cols}), type, compute);
+    }
+
+    // Input as doubles: in place for double inputs, converted into buf otherwise
+    const double *asDouble(const double *input, size_t len, std::vector<double> &buf) {
+        return input;
+    }
+
+    const double *asDouble(const float *input, size_t len, std::vector<double> &buf) {
+        buf.assign(input, input + len);
+        return buf.data();
+    }
+
+    // Largest value of an integer output class (0 for unknown classes)
+    double integerMax(const std::string &type) {
+        if (type == "uint8")  return 255.0;
+        if (type == "uint16") return 65535.0;
+        if (type == "uint32") return 4294967295.0;
+        if (type == "int32")  return 2147483647.0;
+        return 0;
+    }
+
+    // Histograms of a binned-index file (tswHist_binfile.h), 'hist' mode only
+    void runBinFile(ArgumentList &outputs, const std::string &path, const tswHistOptions &opt) {
+        if (opt.mode != "hist" || opt.out_type != "double" || !opt.segments.empty())
+            error("tswHist_mx:badBinFile", "Binned-index files are only available for double histograms without segments.");
+        tswHistBinFile bf;
+        if (!tswHistBinFileOpen(&bf, path.c_str()))
+            error("tswHist_mx:badBinFile", "Cannot read the binned-index file.");
+
+        size_t n_bins = (size_t)bf.hdr.n_bins;
+        std::string err;
+        if (opt.n_bins != 0 && opt.n_bins != n_bins)
+            err = "Number of bins does not match the binned-index file.";
+        else if (opt.win_len > bf.hdr.input_len)
+            err = "Window length must not exceed input length.";
+        if (!err.empty()) {
+            tswHistBinFileClose(&bf);
+            error("tswHist_mx:badBinFile", err);
+        }
+
+        size_t num_windows = tswHistNumWindows((size_t)bf.hdr.input_len, opt.win_len, opt.stride);
+        double *loci = NULL, *edges = NULL;
+        Array loci_out  = createOutput<double>(1, num_windows, [&](double *out) { loci = out; });
+        Array edges_out = createOutput<double>(1, n_bins + 1, [&](double *out) { edges = out; });
+        outputs[0] = createOutput<double>(n_bins, num_windows, [&](double *out) {
+            tswHistBinned(&bf, opt.win_len, opt.stride, out, loci, edges);
+        });
+        tswHistBinFileClose(&bf);
+        if (outputs.size() >= 2)
+            outputs[1] = std::move(loci_out);
+        if (outputs.size() >= 3)
+            outputs[2] = std::move(edges_out);
+    }
+
+    template <typename T>
+    void run(ArgumentList &outputs, const T *input_norm, matlab::data::ArrayDimensions dims, const tswHistOptions &opt) {
+        size_t numel = 1;
+        for (auto d : dims)
+            numel *= d;
+        bool pooled = (opt.mode == "pooled");
+        bool connectivity = (opt.mode == "connectivity");
+        size_t input_len  = (pooled || connectivity) ? dims[0] : numel;
+        size_t n_channels = (pooled || connectivity) ? numel / dims[0] : 1;
+        size_t n_bins     = opt.n_bins;
+        bool integer_out  = (opt.out_type != "double" && opt.out_type != "single");
+
+        if (opt.win_len > input_len)
+            error("tswHist_mx:winLen", "Window length must not exceed input length.");
+        if (integer_out && opt.mode != "hist" && !pooled)
+            error("tswHist_mx:badOutputType", "Integer output types are only available for histograms.");
+        // A full window must fit: converting an out of range count is undefined
+        double int_max = integerMax(opt.out_type);
+        if (integer_out && int_max > 0 && (double)opt.win_len * (pooled ? n_channels : 1) > int_max)
+            error("tswHist_mx:badOutputType", "OutputType " + opt.out_type + " cannot hold the count of a full window.");
+
+        // Opt-in workload recorder, enabled by the TSWHIST_RECORD_LOG environment
+        // variable: shape, input class, wall time and value sketch of the call
+        // (see tswHist_record.h)
+        const char *record_log = getenv("TSWHIST_RECORD_LOG");
+        bool record = (record_log != NULL && record_log[0] != '\0');
+        tswHistRecord rec;
+        if (record)
+            tswHistRecordInitTyped(&rec, "tswHist_mx_cpp", opt.segments.empty() ? opt.mode.c_str() : "segments",
+                                   input_norm, std::is_same<T, float>::value ? TSWHIST_RECORD_SINGLE : TSWHIST_RECORD_DOUBLE,
+                                   input_len, n_channels, n_bins, opt.win_len, opt.stride);
+        double t_start = tswHistRecordNow();
+
+        // Windows, and ranges of windows seeded by a full count: one per
+        // thread, or one per segment (windows never cross a segment bound)
+        size_t num_windows = 0;
+        std::vector<size_t> ranges, seg_begin, seg_end;
+        if (!opt.segments.empty()) {
+            if (opt.mode != "hist")
+                error("tswHist_mx:badSegments", "Segments are only available for histograms.");
+            size_t n_segments = (opt.seg_cols == 2 && opt.seg_rows != 1) ? opt.seg_rows : opt.segments.size();
+            seg_begin.resize(n_segments);
+            seg_end.resize(n_segments);
+            if (!tswHistSegmentBounds(opt.segments.data(), opt.seg_rows, opt.seg_cols, input_len,
+                                      seg_begin.data(), seg_end.data()))
+                error("tswHist_mx:badSegments", "Segments must be non-empty and within the input.");
+            for (size_t k = 0; k < n_segments; ++k) {
+                ranges.push_back(num_windows);
+                num_windows += tswHistSegmentsNumWindows(&seg_begin[k], &seg_end[k], 1, opt.win_len, opt.stride);
+            }
+        } else {
+            num_windows = tswHistNumWindows(input_len, opt.win_len, opt.stride);
+            size_t n_chunks = tswHistNumThreads(opt.threads);
+            if (n_chunks > num_windows)
+                n_chunks = num_windows;
+            for (size_t c = 0; c < n_chunks; ++c)
+                ranges.push_back(c * num_windows / n_chunks);
+        }
+        ranges.push_back(num_windows);
+
+        // Loci and edges are computed in their output buffers
+        double *loci = NULL, *edges = NULL;
+        Array loci_out = createOutput<double>(1, num_windows, [&](double *out) {
+            loci = out;
+            if (opt.segments.empty()) {
+                tswHistLoci(out, num_windows, opt.stride);
+                return;
+            }
+            for (size_t k = 0, w = 0; k < seg_begin.size(); ++k)
+                for (size_t r = 0; r < ranges[k + 1] - ranges[k]; ++r)
+                    out[w++] = (double)(seg_begin[k] + r * opt.stride + 1); // MATLAB 1-based
+        });
+        Array edges_out = createOutput<double>(1, n_bins + 1, [&](double *out) {
+            edges = out;
+            tswHistEdges(out, n_bins);
+        });
+
+        // Binning stage (the exact, adaptive and phase modes read the samples themselves)
+        std::vector<double> input_int;
+        if (pooled || connectivity) {
+            input_int.resize(input_len * n_channels);
+            binningInterleaved<T>(input_norm, input_len, n_channels, n_bins, input_int.data());
+        } else if (opt.mode == "hist" || opt.mode == "robust" || opt.mode == "otsu"
+                   || opt.mode == "minerror" || opt.mode == "codebook") {
+            input_int.resize(input_len);
+            binning<T>(input_norm, input_len, n_bins, input_int.data());
+        }
+
+        std::vector<double> bufferHist(n_bins, 0.0);
+        if (opt.mode == "hist") {
+            const std::string &t = opt.out_type;
+            size_t n_chunks = ranges.size() - 1;
+            if (t == "double" && opt.segments.empty() && tswHistScanSelected(num_windows, opt.win_len, opt.stride, n_chunks)) {
+                // Long windows: scan over chunk deltas instead of re-seeding each chunk
+                std::vector<double> offsets(opt.stride);
+                tswHistOffsets(offsets.data(), opt.stride);
+                outputs[0] = createOutput<double>(n_bins, num_windows, [&](double *out) {
+                    tswHistScanWindows(out, input_int.data(), loci, num_windows, opt.win_len,
+                                       n_bins, opt.stride, offsets.data(), input_len, n_chunks);
+                });
+            }
+            else if (t == "double") outputs[0] = histOutput<double>(input_int.data(), loci, num_windows, ranges, opt, input_len);
+            else if (t == "single") outputs[0] = histOutput<float>(input_int.data(), loci, num_windows, ranges, opt, input_len);
+            else if (t == "uint8")  outputs[0] = histOutput<uint8_t>(input_int.data(), loci, num_windows, ranges, opt, input_len);
+            else if (t == "uint16") outputs[0] = histOutput<uint16_t>(input_int.data(), loci, num_windows, ranges, opt, input_len);
+            else if (t == "uint32") outputs[0] = histOutput<uint32_t>(input_int.data(), loci, num_windows, ranges, opt, input_len);
+            else if (t == "int32")  outputs[0] = histOutput<int32_t>(input_int.data(), loci, num_windows, ranges, opt, input_len);
+            else error("tswHist_mx:badOutputType", "Unknown output type " + t + ".");
+        } else if (pooled) {
+            const std::string &t = opt.out_type;
+            if (t == "double")      outputs[0] = pooledOutput<double>(input_int.data(), num_windows, n_channels, opt);
+            else if (t == "single") outputs[0] = pooledOutput<float>(input_int.data(), num_windows, n_channels, opt);
+            else if (t == "uint8")  outputs[0] = pooledOutput<uint8_t>(input_int.data(), num_windows, n_channels, opt);
+            else if (t == "uint16") outputs[0] = pooledOutput<uint16_t>(input_int.data(), num_windows, n_channels, opt);
+            else if (t == "uint32") outputs[0] = pooledOutput<uint32_t>(input_int.data(), num_windows, n_channels, opt);
+            else if (t == "int32")  outputs[0] = pooledOutput<int32_t>(input_int.data(), num_windows, n_channels, opt);
+            else error("tswHist_mx:badOutputType", "Unknown output type " + t + ".");
+        } else if (connectivity) {
+            if (n_bins > TSWHIST_CONN_MAX_BINS)
+                error("tswHist_mx:badBins", "Number of bins must not exceed 65535 in the connectivity mode.");
+            tswHistConnLayout layout = (opt.layout == "triu") ? TSWHIST_CONN_TRIU : TSWHIST_CONN_FULL;
+            matlab::data::ArrayDimensions mi_dims = (layout == TSWHIST_CONN_TRIU)
+                ? matlab::data::ArrayDimensions({tswHistConnNumPairs(n_channels), num_windows})
+                : matlab::data::ArrayDimensions({n_channels, n_channels, num_windows});
+            outputs[0] = statOutput(mi_dims, opt.out_type, [&](double *out) {
+                tswHistConnectivitySlidingWindow(out, input_int.data(), num_windows, opt.win_len,
+                                                 n_bins, opt.stride, n_channels, layout);
+            });
+        } else if (opt.mode == "exact") {
+            if (input_len >= 4294967295.0)
+                error("tswHist_mx:winLen", "Input is too long for the exact mode.");
+            std::vector<double> input_double;
+            const double *input = asDouble(input_norm, input_len, input_double);
+            std::vector<double> probs = opt.probs.empty() ? std::vector<double>({0.5}) : opt.probs;
+            outputs[0] = statOutput(probs.size(), num_windows, opt.out_type, [&](double *out) {
+                tswHistExact(input, input_len, opt.win_len, opt.stride, probs.data(), probs.size(),
+                             out, loci);
+            });
+        } else if (opt.mode == "adaptive") {
+            // Variable number of windows: results are copied from the engine's
+            // growing arrays, loci replaced by those of the adaptive windows
+            std::vector<double> input_double;
+            const double *input = asDouble(input_norm, input_len, input_double);
+            tswHistAdaptiveResult res;
+            if (!tswHistAdaptive(input, input_len, n_bins, opt.win_len, opt.stride, (size_t)opt.fine_stride,
+                                 (opt.criterion == "tail") ? TSWHIST_ADAPTIVE_TAIL : TSWHIST_ADAPTIVE_ENTROPY,
+                                 opt.tail_level, opt.threshold, &res, edges)) {
+                tswHistAdaptiveFree(&res);
+                error("tswHist_mx:outOfMemory", "Not enough memory for the adaptive windows.");
+            }
+            outputs[0] = statOutput(n_bins, res.num_windows, opt.out_type, [&](double *out) {
+                std::copy(res.histMat, res.histMat + n_bins * res.num_windows, out);
+            });
+            loci_out = createOutput<double>(1, res.num_windows, [&](double *out) {
+                std::copy(res.loci, res.loci + res.num_windows, out);
+            });
+            if (outputs.size() >= 4)
+                outputs[3] = createOutput<double>(1, res.num_windows, [&](double *out) {
+                    std::copy(res.stat, res.stat + res.num_windows, out);
+                });
+            tswHistAdaptiveFree(&res);
+        } else if (opt.mode == "phase") {
+            // Windows of Window revolutions, sliding by Stride revolutions
+            if (opt.phase_len != input_len)
+                error("tswHist_mx:badPhase", "Phase must be a real double vector of the length of the input.");
+            if (!tswHistPhaseValid(opt.phase, input_len))
+                error("tswHist_mx:badPhase", "Phase must be finite and nondecreasing (unwrapped, in turns).");
+            std::vector<double> input_double;
+            const double *input = asDouble(input_norm, input_len, input_double);
+            std::vector<size_t> rev_starts(input_len + 1);
+            size_t n_revs = tswHistPhaseRevolutions(opt.phase, input_len, rev_starts.data());
+            size_t n_phase = (size_t)opt.n_phase, n_probs = opt.probs.size();
+            num_windows = tswHistPhaseNumWindows(n_revs, opt.win_len, opt.stride);
+            loci_out = createOutput<double>(1, num_windows, [&](double *out) { loci = out; });
+            matlab::data::ArrayDimensions ph_dims({n_phase, (n_probs > 0) ? n_probs : n_bins, num_windows});
+            outputs[0] = statOutput(ph_dims, opt.out_type, [&](double *out) {
+                tswHistPhase(input, opt.phase, input_len, rev_starts.data(), n_revs, n_bins, n_phase,
+                             opt.win_len, opt.stride, opt.probs.data(), n_probs,
+                             (n_probs > 0) ? NULL : out, (n_probs > 0) ? out : NULL, loci, edges);
+            });
+        } else if (opt.mode == "codebook") {
+            outputs[0] = statOutput(TSWHIST_CODEBOOK_NROWS, num_windows, opt.out_type, [&](double *out) {
+                tswHistCodebookSlidingWindow(out, bufferHist.data(), input_int.data(),
+                                             num_windows, opt.win_len, n_bins, opt.stride,
+                                             opt.prototypes.data(), opt.n_prototypes,
+                                             (opt.metric == "dot") ? TSWHIST_CODEBOOK_DOT : TSWHIST_CODEBOOK_L2);
+            });
+        } else if (opt.mode == "robust") {
+            outputs[0] = statOutput(TSWHIST_ROBUST_NSTATS, num_windows, opt.out_type, [&](double *out) {
+                tswHistRobustSlidingWindow(out, bufferHist.data(), input_int.data(),
+                                           num_windows, opt.win_len, n_bins, opt.stride, opt.trim,
+                                           edges, input_len);
+            });
+        } else if (opt.mode == "otsu" || opt.mode == "minerror") {
+            std::vector<unsigned char> labels(outputs.size() >= 4 ? input_len : 0);
+            outputs[0] = statOutput(TSWHIST_THRESHOLD_NROWS, num_windows, opt.out_type, [&](double *out) {
+                tswHistThresholdSlidingWindow(out, labels.empty() ? NULL : labels.data(),
+                                              bufferHist.data(), input_int.data(), num_windows,
+                                              opt.win_len, n_bins, opt.stride,
+                                              (opt.mode == "otsu") ? TSWHIST_THRESHOLD_OTSU : TSWHIST_THRESHOLD_MINERROR,
+                                              edges, input_len);
+            });
+            if (outputs.size() >= 4)
+                outputs[3] = createOutput<bool>(1, input_len, [&](bool *out) {
+                    for (size_t i = 0; i < input_len; ++i)
+                        out[i] = labels[i] != 0;
+                });
+        } else {
+            error("tswHist_mx:badMode", "Unknown mode " + opt.mode + ".");
+        }
+
+        if (outputs.size() >= 4 && !opt.segments.empty())
+            outputs[3] = createOutput<double>(1, num_windows, [&](double *out) {
+                for (size_t k = 0; k + 1 < ranges.size(); ++k)
+                    for (size_t w = ranges[k]; w < ranges[k + 1]; ++w)
+                        out[w] = (double)(k + 1);
+            });
+        if (outputs.size() >= 2)
+            outputs[1] = std::move(loci_out);
+        if (outputs.size() >= 3)
+            outputs[2] = std::move(edges_out);
+        if (record)
+            tswHistRecordAppend(record_log, &rec, t_start);
+    }
+};
@@ -0,0 +1,172 @@
+/*
+ * tswHist_phase.h - Phase-folded (cyclostationary) sliding histograms
+ *
+ *   Amplitude histograms as a function of the shaft phase of rotating
+ *   machinery: every sample is mapped to a (phase bin, amplitude bin) cell,
+ *   and the [n_phase x n_bins] histogram of the cells is accumulated over
+ *   the last win_revs revolutions, sliding by stride_revs revolutions. The
+ *   phase is given per sample in turns, unwrapped (nondecreasing, e.g.
+ *   derived from a tachometer): revolution floor(phase), phase bin
+ *   floor((phase - floor(phase)) * n_phase). Revolutions are thus runs of
+ *   samples of variable lengths, and the window slides with the same
+ *   pop/push schedule as tswHistSlidingWindow, over revolutions instead of
+ *   samples: the data are read once whatever n_phase.
+ *
+ *   Instead of the histograms, the per-phase quantiles of the amplitude can
+ *   be output alone: rank pointers (tswHistRank, see tswHist_robust.h) are
+ *   kept for every (phase bin, probability) and updated on each push/pop,
+ *   the samples being modelled as uniformly spread inside their bin like in
+ *   the robust mode. A phase bin without samples gives NaN.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_PHASE_H
+#define TSWHIST_PHASE_H
+
+#include "tswHist.h"
+#include "tswHist_robust.h"
+
+// Whether phase is finite and nondecreasing
+int tswHistPhaseValid(const double *phase, size_t input_len) {
+    for (size_t i = 0; i < input_len; ++i)
+        if (!isfinite(phase[i]) || (i > 0 && phase[i] < phase[i - 1]))
+            return 0;
+    return 1;
+}
+
+// Start indices of the revolutions ([n_revs+1], the last one is input_len)
+// of a valid phase, returns n_revs
+size_t tswHistPhaseRevolutions(const double *phase, size_t input_len, size_t *rev_starts) {
+    size_t n_revs = 0;
+    for (size_t i = 0; i < input_len; ++i)
+        if (i == 0 || floor(phase[i]) != floor(phase[i - 1]))
+            rev_starts[n_revs++] = i;
+    rev_starts[n_revs] = input_len;
+    return n_revs;
+}
+
+size_t tswHistPhaseNumWindows(size_t n_revs, size_t win_revs, size_t stride_revs) {
+    return (n_revs >= win_revs) ? (n_revs - win_revs) / stride_revs + 1 : 0;
+}
+
+// Cell (phase bin * n_bins + amplitude bin) of every sample, -1 when the
+// amplitude is out of [0,1]
+void tswHistPhaseCells(const double *input_norm, const double *phase, size_t input_len,
+                       size_t n_bins, size_t n_phase, double *cells) {
+    tswHistBinning(input_norm, input_len, n_bins, cells);
+    for (size_t i = 0; i < input_len; ++i) {
+        size_t p = (size_t)floor((phase[i] - floor(phase[i])) * n_phase);
+        if (p >= n_phase) p = n_phase - 1; // rounding of phases just below a turn
+        cells[i] = (cells[i] >= 0 && cells[i] < (double)n_bins) ? (double)(p * n_bins) + cells[i] : -1;
+    }
+}
+
+// Pushes (delta = +1) or pops (delta = -1) the samples [first, last)
+void tswHistPhaseUpdate(double *hist, double *counts, tswHistRank *ranks, size_t n_probs,
+                        const double *cells, size_t first, size_t last, size_t n_bins, double delta) {
+    for (size_t i = first; i < last; ++i) {
+        if (cells[i] < 0)
+            continue;
+        size_t c = (size_t)cells[i], p = c / n_bins;
+        hist[c]   += delta;
+        counts[p] += delta;
+        for (size_t q = 0; q < n_probs; ++q)
+            tswHistRankUpdate(&ranks[p * n_probs + q], c - p * n_bins, delta);
+    }
+}
+
+void tswHistPhaseSlidingWindow(
+    double *histMat,              // [n_phase x n_bins x num_windows] output, or NULL
+    double *quantMat,             // [n_phase x n_probs x num_windows] output, or NULL
+    const double *cells,
+    const size_t *rev_starts,
+    size_t num_windows,
+    size_t win_revs,
+    size_t stride_revs,
+    size_t n_bins,
+    size_t n_phase,
+    const double *probs,
+    size_t n_probs,
+    const double *edges
+) {
+    double *hist   = (double *)calloc(n_phase * n_bins, sizeof(double)); // phase-major
+    double *counts = (double *)calloc(n_phase, sizeof(double));
+    if (!quantMat)
+        n_probs = 0; // no rank pointers to maintain
+    tswHistRank *ranks = (tswHistRank *)calloc(n_phase * n_probs + 1, sizeof(tswHistRank));
+    double width = (edges[n_bins] - edges[0]) / n_bins;
+
+    for (size_t w = 0; w < num_windows; ++w) {
+        if (w == 0) {
+            tswHistPhaseUpdate(hist, counts, ranks, n_probs, cells, rev_starts[0], rev_starts[win_revs], n_bins, +1);
+        } else {
+            // pop then push (same schedule as tswHistSlidingWindow, in revolutions)
+            size_t base_pop  = (w - 1) * stride_revs;
+            size_t base_push = base_pop + win_revs;
+            tswHistPhaseUpdate(hist, counts, ranks, n_probs, cells,
+                               rev_starts[base_pop], rev_starts[base_pop + stride_revs], n_bins, -1);
+            tswHistPhaseUpdate(hist, counts, ranks, n_probs, cells,
+                               rev_starts[base_push], rev_starts[base_push + stride_revs], n_bins, +1);
+        }
+
+        if (histMat) {
+            double *out = &histMat[w * n_phase * n_bins];
+            for (size_t p = 0; p < n_phase; ++p)
+                for (size_t b = 0; b < n_bins; ++b)
+                    out[p + b * n_phase] = hist[p * n_bins + b];
+        }
+        if (quantMat) {
+            double *out = &quantMat[w * n_phase * n_probs];
+            for (size_t p = 0; p < n_phase; ++p) {
+                const double *h = &hist[p * n_bins];
+                for (size_t q = 0; q < n_probs; ++q) {
+                    tswHistRank *r = &ranks[p * n_probs + q];
+                    if (counts[p] <= 0) {
+                        out[p + q * n_phase] = NAN;
+                        continue;
+                    }
+                    double rank = probs[q] * counts[p];
+                    tswHistRankSeek(r, h, n_bins, rank, counts[p]);
+                    out[p + q * n_phase] = edges[0] + width * tswHistRankPos(r, h, rank);
+                }
+            }
+        }
+    }
+
+    free(hist);
+    free(counts);
+    free(ranks);
+}
+
+void tswHistPhase(
+    const double *input_norm, const double *phase, size_t input_len,
+    const size_t *rev_starts, size_t n_revs, // from tswHistPhaseRevolutions
+    size_t n_bins, size_t n_phase,
+    size_t win_revs, size_t stride_revs,
+    const double *probs, size_t n_probs,
+    double *histMat,              // [n_phase x n_bins x num_windows] output, or NULL
+    double *quantMat,             // [n_phase x n_probs x num_windows] output, or NULL
+    double *windows_loci,         // [num_windows] output (first sample, 1-based)
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistPhaseNumWindows(n_revs, win_revs, stride_revs);
+    for (size_t w = 0; w < num_windows; ++w)
+        windows_loci[w] = (double)(rev_starts[w * stride_revs] + 1); // MATLAB 1-based
+    tswHistEdges(edges, n_bins);
+    if (num_windows == 0)
+        return;
+
+    double *cells = (double *)malloc(input_len * sizeof(double));
+    tswHistPhaseCells(input_norm, phase, input_len, n_bins, n_phase, cells);
+    tswHistPhaseSlidingWindow(histMat, quantMat, cells, rev_starts, num_windows, win_revs, stride_revs,
+                              n_bins, n_phase, probs, n_probs, edges);
+    free(cells);
+}
+
+#endif // TSWHIST_PHASE_H
@@ -0,0 +1,107 @@
+/*
+ * tswHist_pooled.h - Pooled cross-channel sliding window histograms
+ *
+ *   Computes, for every window, the histogram of the samples of all channels
+ *   pooled together, in a single pass and with a single bufferHist. The
+ *   channels keep their window alignment: window w holds the samples
+ *   [loci(w), loci(w) + win_len) of every channel.
+ *
+ *   The binned samples are stored interleaved (sample-major: the n_channels
+ *   bins of sample i are contiguous), so the samples leaving and entering the
+ *   window at each step are two contiguous runs of stride * n_channels bins,
+ *   which pushHist/popHist walk in one tight loop.
+ *
+ *   The input is column-major [input_len x n_channels] (one column per
+ *   channel, MATLAB layout) and normalized in [0,1] like for tswHist.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_POOLED_H
+#define TSWHIST_POOLED_H
+
+#include "tswHist.h"
+
+#define TSWHIST_POOLED_BLOCK 256 // samples per block of the interleaving transpose
+
+// Bin a column-major [input_len x n_channels] input into sample-major order
+void tswHistBinningInterleaved(
+    const double *input_norm, size_t input_len, size_t n_channels,
+    size_t n_bins, double *input_int
+) {
+    for (size_t i0 = 0; i0 < input_len; i0 += TSWHIST_POOLED_BLOCK) {
+        size_t i1 = (i0 + TSWHIST_POOLED_BLOCK < input_len) ? i0 + TSWHIST_POOLED_BLOCK : input_len;
+        for (size_t c = 0; c < n_channels; ++c) {
+            const double *col = &input_norm[c * input_len];
+            for (size_t i = i0; i < i1; ++i) {
+                int bin = (int)floor(col[i] * n_bins);
+                if (bin == (int)n_bins) bin = n_bins - 1; // Patch for max value
+                input_int[i * n_channels + c] = (double)bin;
+            }
+        }
+    }
+}
+
+void tswHistPooledSlidingWindow(
+    double *histMat,
+    double *bufferHist,
+    const double *input_int, // interleaved [n_channels x input_len]
+    size_t num_windows,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride,
+    size_t n_channels
+) {
+    size_t run = stride * n_channels;
+    for (size_t w = 1; w < num_windows; ++w) {
+        size_t base_pop  = (w - 1) * stride * n_channels;
+        size_t base_push = base_pop + win_len * n_channels;
+        popHist(bufferHist, &input_int[base_pop], run, n_bins);
+        pushHist(bufferHist, &input_int[base_push], run, n_bins);
+        // Store
+        for (size_t b = 0; b < n_bins; ++b)
+            histMat[b + w * n_bins] = bufferHist[b];
+    }
+}
+
+void tswHistPooled(
+    const double *input_norm, size_t input_len, size_t n_channels,
+    size_t n_bins, size_t win_len, size_t stride,
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    double *input_int = (double *)calloc(input_len * n_channels, sizeof(double));
+    tswHistBinningInterleaved(input_norm, input_len, n_channels, n_bins, input_int);
+
+    // Compute histogram for the first window (all channels)
+    double *bufferHist = (double *)calloc(n_bins, sizeof(double));
+    pushHist(bufferHist, input_int, win_len * n_channels, n_bins);
+    for (size_t b = 0; b < n_bins; ++b)
+        histMat[b] = bufferHist[b];
+
+    tswHistPooledSlidingWindow(
+        histMat,
+        bufferHist,
+        input_int,
+        num_windows,
+        win_len,
+        n_bins,
+        stride,
+        n_channels
+    );
+
+    free(input_int);
+    free(bufferHist);
+}
+
+#endif // TSWHIST_POOLED_H
@@ -0,0 +1,296 @@
+/*
+ * tswHist_record.h - Workload recorder of tswHist calls, and input synthesis for replays
+ *
+ *   Opt-in log of the shapes of production calls, so that optimizations can
+ *   be evaluated on realistic workloads without the (proprietary) signals.
+ *   Every recorded call appends one fixed-size binary record to a log file:
+ *   the caller and output mode, n_bins, win_len, stride, input_len, the
+ *   number of channels, the input type, the wall time of the call, and a
+ *   sketch of the distribution of the input values:
+ *     - the fractions of NaN samples and of samples binned below and above
+ *       [0, n_bins) (ignored by the histograms);
+ *     - the distribution of the in-range values over TSWHIST_RECORD_SKETCH
+ *       equal cells of [0, 1];
+ *     - the fraction of consecutive samples falling in the same bin, which
+ *       drives how often the pop/push updates hit the same bins;
+ *     - the fraction of the n_bins occupied by the sampled values.
+ *   The sketch reads TSWHIST_RECORD_SAMPLES samples at most (evenly spaced
+ *   blocks of consecutive samples), so that recording costs little against
+ *   the call itself. The values are sketched as passed (the raw values for
+ *   the 'exact' mode).
+ *
+ *   Records are written by one fwrite in append mode, so that concurrent jobs
+ *   can share a log. tswHistRecordSynthesize draws an input with the sketched
+ *   statistics (inverse-CDF sampling of the cells, then a first-order chain
+ *   keeping the bin of the previous sample at the recorded rate), which the
+ *   replay benchmark (test/bench_tswHist_native.c) runs through the engines.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_RECORD_H
+#define TSWHIST_RECORD_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "tswHist.h"
+
+#define TSWHIST_RECORD_VERSION 1
+#define TSWHIST_RECORD_SKETCH  64       // cells of the value sketch over [0, 1]
+#define TSWHIST_RECORD_SAMPLES 65536    // samples read by the sketch at most
+#define TSWHIST_RECORD_BLOCK   256      // consecutive samples per sketched block
+
+typedef enum {
+    TSWHIST_RECORD_DOUBLE = 1,
+    TSWHIST_RECORD_SINGLE = 2
+} tswHistRecordType;
+
+typedef struct {
+    char     magic[4];      // "TSWR"
+    uint32_t version;       // TSWHIST_RECORD_VERSION
+    char     source[16];    // caller (e.g. "tswHist_mx", "C")
+    char     mode[16];      // output mode
+    uint64_t n_bins;
+    uint64_t win_len;
+    uint64_t stride;
+    uint64_t input_len;     // samples per channel
+    uint64_t n_channels;
+    uint32_t input_type;    // tswHistRecordType
+    uint32_t n_sampled;     // samples read by the sketch
+    double   timestamp;     // end of the call, seconds since the epoch
+    double   wall_time;     // seconds
+    double   nan_frac;      // fractions of the sampled values: NaN,
+    double   below_frac;    // binned below 0,
+    double   above_frac;    // binned at or above n_bins
+    double   repeat_frac;   // consecutive samples in the same bin
+    double   occupied_frac; // fraction of the n_bins holding sampled values
+    float    sketch[TSWHIST_RECORD_SKETCH]; // in-range values per cell of [0, 1] (sum 1)
+} tswHistRecord;
+
+// Wall clock in seconds
+double tswHistRecordNow(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+// Bin of a value like tswHistBinning, -1 below, n_bins above, -2 for NaN
+long long tswHistRecordBin(double v, size_t n_bins) {
+    if (isnan(v))
+        return -2;
+    double f = floor(v * (double)n_bins);
+    if (f < 0)
+        return -1;
+    if (f == (double)n_bins)
+        return (long long)n_bins - 1; // Patch for max value
+    return (f > (double)n_bins) ? (long long)n_bins : (long long)f;
+}
+
+// Sample i of an input of class type (double or float)
+double tswHistRecordValue(const void *input, tswHistRecordType type, size_t i) {
+    return (type == TSWHIST_RECORD_SINGLE) ? (double)((const float *)input)[i] : ((const double *)input)[i];
+}
+
+// Shape and sketch of a call on input ([input_len x n_channels] of class type)
+void tswHistRecordInitTyped(
+    tswHistRecord *rec, const char *source, const char *mode,
+    const void *input, tswHistRecordType type, size_t input_len, size_t n_channels,
+    size_t n_bins, size_t win_len, size_t stride
+) {
+    memset(rec, 0, sizeof(*rec));
+    memcpy(rec->magic, "TSWR", 4);
+    rec->version    = TSWHIST_RECORD_VERSION;
+    strncpy(rec->source, source, sizeof(rec->source) - 1);
+    strncpy(rec->mode, mode, sizeof(rec->mode) - 1);
+    rec->n_bins     = n_bins;
+    rec->win_len    = win_len;
+    rec->stride     = stride;
+    rec->input_len  = input_len;
+    rec->n_channels = n_channels;
+    rec->input_type = type;
+
+    // Evenly spaced blocks of consecutive samples
+    size_t total    = input_len * n_channels;
+    size_t n_blocks = (total + TSWHIST_RECORD_BLOCK - 1) / TSWHIST_RECORD_BLOCK;
+    size_t max_blocks = TSWHIST_RECORD_SAMPLES / TSWHIST_RECORD_BLOCK;
+    size_t used     = (n_blocks < max_blocks) ? n_blocks : max_blocks;
+    unsigned char *occupied = (unsigned char *)calloc(n_bins > 0 ? n_bins : 1, 1);
+    double cells[TSWHIST_RECORD_SKETCH] = {0};
+    size_t n = 0, n_in = 0, n_nan = 0, n_below = 0, n_above = 0, n_pairs = 0, n_repeat = 0, n_occupied = 0;
+    for (size_t k = 0; k < used; ++k) {
+        size_t first = (k * n_blocks / used) * TSWHIST_RECORD_BLOCK;
+        size_t last  = (first + TSWHIST_RECORD_BLOCK < total) ? first + TSWHIST_RECORD_BLOCK : total;
+        long long prev = -3;
+        for (size_t i = first; i < last; ++i, ++n) {
+            double v = tswHistRecordValue(input, type, i);
+            long long bin = tswHistRecordBin(v, n_bins);
+            if (i > first) {
+                n_pairs++;
+                n_repeat += (bin == prev);
+            }
+            prev = bin;
+            if (bin == -2)      n_nan++;
+            else if (bin == -1) n_below++;
+            else if (bin == (long long)n_bins) n_above++;
+            else {
+                int cell = (int)(v * TSWHIST_RECORD_SKETCH);
+                cells[(cell < TSWHIST_RECORD_SKETCH) ? cell : TSWHIST_RECORD_SKETCH - 1] += 1;
+                n_in++;
+                if (occupied && !occupied[bin]) {
+                    occupied[bin] = 1;
+                    n_occupied++;
+                }
+            }
+        }
+    }
+    free(occupied);
+
+    rec->n_sampled     = (uint32_t)n;
+    rec->nan_frac      = n ? (double)n_nan / n : 0;
+    rec->below_frac    = n ? (double)n_below / n : 0;
+    rec->above_frac    = n ? (double)n_above / n : 0;
+    rec->repeat_frac   = n_pairs ? (double)n_repeat / n_pairs : 0;
+    rec->occupied_frac = n_bins ? (double)n_occupied / n_bins : 0;
+    for (int c = 0; c < TSWHIST_RECORD_SKETCH; ++c)
+        rec->sketch[c] = n_in ? (float)(cells[c] / n_in) : 1.0f / TSWHIST_RECORD_SKETCH;
+}
+
+// Shape and sketch of a call on a double input_norm ([input_len x n_channels])
+void tswHistRecordInit(
+    tswHistRecord *rec, const char *source, const char *mode,
+    const double *input_norm, size_t input_len, size_t n_channels,
+    size_t n_bins, size_t win_len, size_t stride
+) {
+    tswHistRecordInitTyped(rec, source, mode, input_norm, TSWHIST_RECORD_DOUBLE, input_len, n_channels,
+                           n_bins, win_len, stride);
+}
+
+// Appends the record of a call which started at t_start (tswHistRecordNow).
+// Returns 1 on success.
+int tswHistRecordAppend(const char *path, tswHistRecord *rec, double t_start) {
+    rec->timestamp = tswHistRecordNow();
+    rec->wall_time = rec->timestamp - t_start;
+    FILE *f = fopen(path, "ab");
+    if (!f)
+        return 0;
+    int ok = fwrite(rec, sizeof(*rec), 1, f) == 1;
+    return (fclose(f) == 0) && ok;
+}
+
+// Reads the valid records of a log into *recs (to be freed by the caller),
+// returns their number
+size_t tswHistRecordRead(const char *path, tswHistRecord **recs) {
+    *recs = NULL;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    size_t n = 0, cap = 0;
+    tswHistRecord rec;
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (memcmp(rec.magic, "TSWR", 4) != 0 || rec.version != TSWHIST_RECORD_VERSION)
+            break; // foreign or truncated log
+        if (n == cap) {
+            cap = 2 * cap + 64;
+            tswHistRecord *grown = (tswHistRecord *)realloc(*recs, cap * sizeof(tswHistRecord));
+            if (!grown)
+                break;
+            *recs = grown;
+        }
+        (*recs)[n++] = rec;
+    }
+    fclose(f);
+    return n;
+}
+
+// Uniform double in [0, 1) (splitmix64)
+double tswHistRecordRand(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (double)(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Value drawn from the sketch (NaN and out of range values at their rates)
+double tswHistRecordDraw(const tswHistRecord *rec, const double *cdf, uint64_t *state) {
+    double u = tswHistRecordRand(state);
+    if (u < rec->nan_frac)
+        return NAN;
+    if (u < rec->nan_frac + rec->below_frac)
+        return -0.5;
+    if (u < rec->nan_frac + rec->below_frac + rec->above_frac)
+        return 1.5;
+    u = tswHistRecordRand(state);
+    int c = 0;
+    while (c < TSWHIST_RECORD_SKETCH - 1 && cdf[c] <= u)
+        ++c;
+    return (c + tswHistRecordRand(state)) / TSWHIST_RECORD_SKETCH;
+}
+
+// Probability that two independent draws of tswHistRecordDraw fall in the
+// same bin (cells spread uniformly over their bins)
+double tswHistRecordCollision(const tswHistRecord *rec) {
+    double in = 1 - rec->nan_frac - rec->below_frac - rec->above_frac, p = 0;
+    if (rec->n_bins >= TSWHIST_RECORD_SKETCH) {
+        for (int c = 0; c < TSWHIST_RECORD_SKETCH; ++c)
+            p += (double)rec->sketch[c] * rec->sketch[c];
+        p *= (double)TSWHIST_RECORD_SKETCH / (double)rec->n_bins;
+    } else {
+        // Cells merged into the bin of their center
+        double bins[TSWHIST_RECORD_SKETCH] = {0};
+        for (int c = 0; c < TSWHIST_RECORD_SKETCH; ++c)
+            bins[(size_t)((c + 0.5) / TSWHIST_RECORD_SKETCH * rec->n_bins)] += rec->sketch[c];
+        for (size_t b = 0; b < rec->n_bins; ++b)
+            p += bins[b] * bins[b];
+    }
+    return in * in * p + rec->nan_frac * rec->nan_frac
+         + rec->below_frac * rec->below_frac + rec->above_frac * rec->above_frac;
+}
+
+// Synthetic input of len samples with the statistics of the record
+void tswHistRecordSynthesize(const tswHistRecord *rec, double *x, size_t len, uint64_t seed) {
+    double cdf[TSWHIST_RECORD_SKETCH], acc = 0;
+    for (int c = 0; c < TSWHIST_RECORD_SKETCH; ++c)
+        cdf[c] = (acc += rec->sketch[c]);
+    // Rate of kept bins, the independent draws repeating bins on their own
+    double coll = tswHistRecordCollision(rec);
+    double keep = (coll < 1) ? (rec->repeat_frac - coll) / (1 - coll) : 0;
+    uint64_t state = seed;
+    double n_bins = (double)rec->n_bins;
+    for (size_t i = 0; i < len; ++i) {
+        if (i > 0 && tswHistRecordRand(&state) < keep) {
+            // Same bin as the previous sample
+            double bin = floor(x[i - 1] * n_bins);
+            x[i] = (bin >= 0 && bin < n_bins) ? (bin + tswHistRecordRand(&state)) / n_bins : x[i - 1];
+        } else {
+            x[i] = tswHistRecordDraw(rec, cdf, &state);
+        }
+    }
+}
+
+// tswHist, recorded to the log at path (not recorded when path is NULL)
+void tswHistRecorded(
+    const char *path,
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    tswHistRecord rec;
+    if (path)
+        tswHistRecordInit(&rec, "C", "hist", input_norm, input_len, 1, n_bins, win_len, stride);
+    double t_start = tswHistRecordNow();
+    tswHist(input_norm, input_len, n_bins, win_len, stride, histMat, strided_windows_loci, edges);
+    if (path)
+        tswHistRecordAppend(path, &rec, t_start);
+}
+
+#endif // TSWHIST_RECORD_H
@@ -0,0 +1,236 @@
+/*
+ * tswHist_robust.h - Sliding robust scale statistics from the running histogram
+ *
+ *   Derives the median, MAD, quartiles, IQR, trimmed and winsorized means of
+ *   every window directly from the sliding bufferHist, without ever storing
+ *   histMat. Samples are modelled as uniformly spread inside their bin, so
+ *   every statistic is reported in value units (the units of edges).
+ *
+ *   Quantiles are followed by rank pointers (tswHistRank) which are updated on
+ *   each push/pop and only walk the few bins the window content has moved by.
+ *   The MAD is obtained by a two-pointer expansion around the median instead
+ *   of building a second histogram of absolute deviations.
+ *
+ *   Rows of robustMat (see the TSWHIST_ROBUST_* enum):
+ *     median, MAD, Q1, Q3, IQR, trimmed mean, winsorized mean
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_ROBUST_H
+#define TSWHIST_ROBUST_H
+
+#include "tswHist.h"
+
+enum {
+    TSWHIST_ROBUST_MEDIAN = 0,
+    TSWHIST_ROBUST_MAD,
+    TSWHIST_ROBUST_Q1,
+    TSWHIST_ROBUST_Q3,
+    TSWHIST_ROBUST_IQR,
+    TSWHIST_ROBUST_TRIMMEAN,
+    TSWHIST_ROBUST_WINSORMEAN,
+    TSWHIST_ROBUST_NSTATS
+};
+
+// Rank pointer: tracks the bin holding a given (continuous) rank of the window
+typedef struct {
+    size_t bin;     // bin holding the tracked rank
+    double below;   // number of samples in bins [0, bin)
+    double below_w; // sum of bin positions (b + 0.5) of the samples in [0, bin)
+} tswHistRank;
+
+// To be called for every sample pushed (delta = +1) or popped (delta = -1)
+void tswHistRankUpdate(tswHistRank *p, size_t bin, double delta) {
+    if (bin < p->bin) {
+        p->below   += delta;
+        p->below_w += delta * ((double)bin + 0.5);
+    }
+}
+
+// Move the pointer to the bin holding rank (0 <= rank <= total)
+void tswHistRankSeek(tswHistRank *p, const double *hist, size_t n_bins, double rank, double total) {
+    while (p->bin > 0 && p->below > rank) {
+        p->bin--;
+        p->below   -= hist[p->bin];
+        p->below_w -= hist[p->bin] * ((double)p->bin + 0.5);
+    }
+    while (p->bin + 1 < n_bins && p->below + hist[p->bin] <= rank && p->below + hist[p->bin] < total) {
+        p->below   += hist[p->bin];
+        p->below_w += hist[p->bin] * ((double)p->bin + 0.5);
+        p->bin++;
+    }
+}
+
+// Position of rank in bin units (bin b spans [b, b+1))
+double tswHistRankPos(const tswHistRank *p, const double *hist, double rank) {
+    double h = hist[p->bin];
+    return (h > 0) ? (double)p->bin + (rank - p->below) / h : (double)p->bin;
+}
+
+// Integral of the sample positions over the ranks [0, rank]
+double tswHistRankIntegral(const tswHistRank *p, const double *hist, double rank) {
+    double h = hist[p->bin];
+    double r = rank - p->below;
+    return p->below_w + ((h > 0) ? r * (double)p->bin + r * r / (2 * h) : 0.0);
+}
+
+// Median absolute deviation (bin units) around position med_pos of bin med_bin
+double tswHistMad(const double *hist, size_t n_bins, size_t med_bin, double med_pos, double total) {
+    double target = 0.5 * total;
+    double mass   = 0.0, d = 0.0;
+    size_t l = med_bin, r = med_bin;
+    // Distances from the median to the outer edges of bins l and r
+    double dl = med_pos - (double)l;
+    double dr = (double)(r + 1) - med_pos;
+    double hl = hist[l], hr = hist[r];
+    while (1) {
+        double next = (dl < dr) ? dl : dr;
+        double gain = (next - d) * (hl + hr);
+        if (mass + gain >= target && hl + hr > 0)
+            return d + (target - mass) / (hl + hr);
+        mass += gain;
+        d     = next;
+        if (dl <= dr) {
+            if (l == 0) { hl = 0; dl = INFINITY; }
+            else        { l--; hl = hist[l]; dl = med_pos - (double)l; }
+        } else {
+            if (r + 1 == n_bins) { hr = 0; dr = INFINITY; }
+            else                 { r++; hr = hist[r]; dr = (double)(r + 1) - med_pos; }
+        }
+        if (dl == INFINITY && dr == INFINITY)
+            return d;
+    }
+}
+
+void tswHistRobustStore(
+    double *stats,
+    const double *bufferHist,
+    tswHistRank *ranks, // median, Q1, Q3, lower trim, upper trim
+    size_t n_bins,
+    double total,
+    double trim,
+    const double *edges
+) {
+    const double qs[5] = {0.5, 0.25, 0.75, trim, 1.0 - trim};
+    double pos[5];
+    double width = (edges[n_bins] - edges[0]) / n_bins;
+
+    if (total <= 0) {
+        for (size_t s = 0; s < TSWHIST_ROBUST_NSTATS; ++s)
+            stats[s] = NAN;
+        return;
+    }
+    for (size_t k = 0; k < 5; ++k) {
+        tswHistRankSeek(&ranks[k], bufferHist, n_bins, qs[k] * total, total);
+        pos[k] = tswHistRankPos(&ranks[k], bufferHist, qs[k] * total);
+    }
+
+    double r_lo = qs[3] * total, r_hi = qs[4] * total;
+    double inner = tswHistRankIntegral(&ranks[4], bufferHist, r_hi)
+                 - tswHistRankIntegral(&ranks[3], bufferHist, r_lo);
+    double trimmean   = (r_hi > r_lo) ? inner / (r_hi - r_lo) : pos[0];
+    double winsormean = (inner + r_lo * pos[3] + (total - r_hi) * pos[4]) / total;
+
+    stats[TSWHIST_ROBUST_MEDIAN]     = edges[0] + width * pos[0];
+    stats[TSWHIST_ROBUST_MAD]        = width * tswHistMad(bufferHist, n_bins, ranks[0].bin, pos[0], total);
+    stats[TSWHIST_ROBUST_Q1]         = edges[0] + width * pos[1];
+    stats[TSWHIST_ROBUST_Q3]         = edges[0] + width * pos[2];
+    stats[TSWHIST_ROBUST_IQR]        = width * (pos[2] - pos[1]);
+    stats[TSWHIST_ROBUST_TRIMMEAN]   = edges[0] + width * trimmean;
+    stats[TSWHIST_ROBUST_WINSORMEAN] = edges[0] + width * winsormean;
+}
+
+void tswHistRobustSlidingWindow(
+    double *robustMat,
+    double *bufferHist,
+    const double *input_int,
+    size_t num_windows,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride,
+    double trim,
+    const double *edges,
+    size_t input_len
+) {
+    tswHistRank ranks[5] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    double total = 0;
+
+    // First window
+    for (size_t i = 0; i < win_len; ++i) {
+        int bin = (int)input_int[i];
+        if (bin >= 0 && bin < (int)n_bins) {
+            bufferHist[bin] += 1;
+            total += 1;
+        }
+    }
+    tswHistRobustStore(robustMat, bufferHist, ranks, n_bins, total, trim, edges);
+
+    for (size_t w = 1; w < num_windows; ++w) {
+        // pop indices, then push indices (same schedule as tswHistSlidingWindow)
+        size_t base_pop  = (w - 1) * stride;
+        size_t base_push = base_pop + win_len;
+        for (size_t j = 0; j < stride; ++j) {
+            int bin = (int)input_int[base_pop + j];
+            if (bin >= 0 && bin < (int)n_bins) {
+                bufferHist[bin] -= 1;
+                total -= 1;
+                for (size_t k = 0; k < 5; ++k)
+                    tswHistRankUpdate(&ranks[k], bin, -1);
+            }
+        }
+        for (size_t j = 0; j < stride; ++j) {
+            if (base_push + j >= input_len)
+                break;
+            int bin = (int)input_int[base_push + j];
+            if (bin >= 0 && bin < (int)n_bins) {
+                bufferHist[bin] += 1;
+                total += 1;
+                for (size_t k = 0; k < 5; ++k)
+                    tswHistRankUpdate(&ranks[k], bin, +1);
+            }
+        }
+        // Store
+        tswHistRobustStore(&robustMat[w * TSWHIST_ROBUST_NSTATS], bufferHist, ranks, n_bins, total, trim, edges);
+    }
+}
+
+void tswHistRobust(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    double trim,                  // fraction trimmed on each side, in [0, 0.5)
+    double *robustMat,            // [TSWHIST_ROBUST_NSTATS x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    double *input_int = (double *)calloc(input_len, sizeof(double));
+    tswHistBinning(input_norm, input_len, n_bins, input_int);
+
+    double *bufferHist = (double *)calloc(n_bins, sizeof(double));
+    tswHistRobustSlidingWindow(
+        robustMat,
+        bufferHist,
+        input_int,
+        num_windows,
+        win_len,
+        n_bins,
+        stride,
+        trim,
+        edges,
+        input_len
+    );
+
+    free(input_int);
+    free(bufferHist);
+}
+
+#endif // TSWHIST_ROBUST_H
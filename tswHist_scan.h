@@ -0,0 +1,144 @@
+/*
+ * tswHist_scan.h - Parallel sliding histograms by a scan over chunk deltas
+ *
+ *   Alternative to tswHistParallel for long windows: instead of seeding each
+ *   chunk of windows with a full count of its first window (O(win_len) per
+ *   thread), every thread turns its slice of the pop/push stream into the
+ *   per-bin delta between the first window of its chunk and the first window
+ *   of the next chunk. An exclusive scan of these deltas over the chunks
+ *   (one scan per bin, bins split over the threads) gives the starting
+ *   histogram of every chunk, then each thread replays its windows with
+ *   tswHistSlidingWindow. The first window itself is counted in slices by
+ *   all the threads.
+ *
+ *   Every sample is thus binned, pushed and popped a bounded number of times
+ *   overall: the work is O(input_len + n_bins * n_threads) whatever win_len,
+ *   and the counts (integers in doubles) are identical to tswHist.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_SCAN_H
+#define TSWHIST_SCAN_H
+
+#include "tswHist.h"
+
+// Whether the scan beats re-seeding each of n_chunks chunks of windows with a
+// full count (the seeding of a chunk outweighs its own pop/push stream)
+int tswHistScanSelected(size_t num_windows, size_t win_len, size_t stride, size_t n_chunks) {
+    return n_chunks > 1 && win_len * n_chunks > stride * num_windows;
+}
+
+// Histograms of all the windows of the binned input_int, by n_chunks threads
+void tswHistScanWindows(
+    double *histMat,              // [n_bins x num_windows] output
+    const double *input_int,
+    const double *strided_windows_loci,
+    size_t num_windows,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride,
+    const double *offsets,
+    size_t input_len,
+    size_t n_chunks
+) {
+    if (n_chunks > num_windows)
+        n_chunks = num_windows;
+    double *seeds  = (double *)calloc(n_chunks * n_bins, sizeof(double)); // slices of the first window
+    double *deltas = (double *)calloc(n_chunks * n_bins, sizeof(double)); // chunk c to chunk c+1
+    double *starts = (double *)malloc(n_chunks * n_bins * sizeof(double)); // first window of each chunk
+
+    #pragma omp parallel num_threads((int)n_chunks)
+    {
+        // Per-chunk summaries: a slice of the first window and the delta of
+        // the pop/push stream of the windows (w_begin, w_end]
+        #pragma omp for schedule(static)
+        for (long long c = 0; c < (long long)n_chunks; ++c) {
+            size_t s_begin = (size_t)c * win_len / n_chunks;
+            size_t s_end   = ((size_t)c + 1) * win_len / n_chunks;
+            pushHist(&seeds[(size_t)c * n_bins], &input_int[s_begin], s_end - s_begin, n_bins);
+            if ((size_t)c + 1 < n_chunks) {
+                size_t w_begin = (size_t)c * num_windows / n_chunks;
+                size_t w_end   = ((size_t)c + 1) * num_windows / n_chunks;
+                double *delta  = &deltas[(size_t)c * n_bins];
+                popHist(delta, &input_int[w_begin * stride], (w_end - w_begin) * stride, n_bins);
+                pushHist(delta, &input_int[w_begin * stride + win_len], (w_end - w_begin) * stride, n_bins);
+            }
+        }
+
+        // Exclusive scan of the deltas over the chunks, one bin per iteration
+        #pragma omp for schedule(static)
+        for (long long b = 0; b < (long long)n_bins; ++b) {
+            double running = 0;
+            for (size_t c = 0; c < n_chunks; ++c)
+                running += seeds[c * n_bins + (size_t)b];
+            for (size_t c = 0; c < n_chunks; ++c) {
+                starts[c * n_bins + (size_t)b] = running;
+                running += deltas[c * n_bins + (size_t)b];
+            }
+        }
+
+        // Replay of the windows of each chunk from its starting histogram
+        #pragma omp for schedule(static)
+        for (long long c = 0; c < (long long)n_chunks; ++c) {
+            size_t w_begin = (size_t)c * num_windows / n_chunks;
+            size_t w_end   = ((size_t)c + 1) * num_windows / n_chunks;
+            double *bufferHist = &starts[(size_t)c * n_bins];
+            for (size_t b = 0; b < n_bins; ++b)
+                histMat[w_begin * n_bins + b] = bufferHist[b];
+            tswHistSlidingWindow(
+                &histMat[w_begin * n_bins],
+                bufferHist,
+                input_int,
+                &strided_windows_loci[w_begin],
+                w_end - w_begin,
+                win_len,
+                n_bins,
+                stride,
+                offsets,
+                input_len
+            );
+        }
+    }
+
+    free(seeds);
+    free(deltas);
+    free(starts);
+}
+
+void tswHistScan(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    size_t n_threads,             // 0: OpenMP default
+    double *histMat,              // [n_bins x num_windows] output
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    size_t n_chunks = tswHistNumThreads(n_threads);
+    double *input_int = (double *)malloc(input_len * sizeof(double));
+    double *offsets   = (double *)malloc(stride * sizeof(double));
+    tswHistOffsets(offsets, stride);
+
+    #pragma omp parallel for schedule(static) num_threads((int)n_chunks)
+    for (long long i = 0; i < (long long)input_len; i += 65536) {
+        size_t n = ((size_t)i + 65536 < input_len) ? 65536 : input_len - (size_t)i;
+        tswHistBinning(&input_norm[i], n, n_bins, &input_int[i]);
+    }
+
+    tswHistScanWindows(histMat, input_int, strided_windows_loci, num_windows,
+                       win_len, n_bins, stride, offsets, input_len, n_chunks);
+
+    free(input_int);
+    free(offsets);
+}
+
+#endif // TSWHIST_SCAN_H
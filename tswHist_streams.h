@@ -0,0 +1,202 @@
+/*
+ * tswHist_streams.h - Sliding histograms of many low-rate streams in packed slabs
+ *
+ *   Keeps the sliding histogram of the last win_len samples of each of a
+ *   large number of streams (e.g. tens of thousands of sensors at a few Hz),
+ *   updated by batches of (stream id, sample) pairs. Instead of one ring
+ *   buffer and one bufferHist allocated per stream, the streams sharing the
+ *   same (n_bins, win_len) form a group whose state is held in a few
+ *   contiguous slabs (structure of arrays): the rings of bin indices (uint16,
+ *   out of range samples stored as 65535 and never counted), the counts
+ *   (uint32), the ring heads and the sample counts.
+ *
+ *   Each batch is partitioned by a stable counting sort on the position of
+ *   the streams in the slabs, so that every stream applies its own samples
+ *   in arrival order, the streams are visited in memory order and no two
+ *   threads update the same stream: the push/pop updates of the streams then
+ *   run in parallel without atomics.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_STREAMS_H
+#define TSWHIST_STREAMS_H
+
+#include <stdint.h>
+#include "tswHist.h"
+
+#define TSWHIST_STREAMS_MAX_BINS 65535  // uint16 bin indices, 65535 is out of range
+#define TSWHIST_STREAMS_CHUNK    64     // streams per OpenMP work item
+
+typedef struct {
+    size_t    n_bins, win_len;
+    size_t    n_streams;  // streams of the group
+    size_t    first;      // position of the first stream of the group in the slabs
+    uint16_t *ring;       // [win_len x n_streams] bin indices of the last samples
+    uint32_t *hist;       // [n_bins x n_streams] counts of the windows
+    uint32_t *head;       // [n_streams] next slot of each ring
+    uint64_t *seen;       // [n_streams] samples received by each stream
+} tswHistStreamGroup;
+
+typedef struct {
+    size_t              n_streams, n_groups;
+    tswHistStreamGroup *groups;
+    uint32_t           *group;    // [n_streams] group of each stream
+    uint32_t           *slot;     // [n_streams] index of each stream in its group
+    uint32_t           *pos;      // [n_streams] position of each stream in the slabs
+    size_t             *starts;   // [n_streams+1] batch partition, by position in the slabs
+    double             *sorted;   // [capacity] batch samples sorted by position
+    size_t              capacity;
+} tswHistStreams;
+
+void tswHistStreamsFree(tswHistStreams *sm) {
+    for (size_t g = 0; g < sm->n_groups; ++g) {
+        free(sm->groups[g].ring);
+        free(sm->groups[g].hist);
+        free(sm->groups[g].head);
+        free(sm->groups[g].seen);
+    }
+    free(sm->groups);
+    free(sm->group);
+    free(sm->slot);
+    free(sm->pos);
+    free(sm->starts);
+    free(sm->sorted);
+    memset(sm, 0, sizeof(*sm));
+}
+
+// Streams 0..n_streams-1 with their n_bins (<= TSWHIST_STREAMS_MAX_BINS) and
+// win_len (> 0), grouped by parameter set. Returns 0 on allocation failure.
+int tswHistStreamsInit(tswHistStreams *sm, size_t n_streams,
+                       const size_t *n_bins, const size_t *win_len) {
+    memset(sm, 0, sizeof(*sm));
+    sm->n_streams = n_streams;
+    sm->group  = (uint32_t *)malloc(n_streams * sizeof(uint32_t));
+    sm->slot   = (uint32_t *)malloc(n_streams * sizeof(uint32_t));
+    sm->pos    = (uint32_t *)malloc(n_streams * sizeof(uint32_t));
+    sm->starts = (size_t *)malloc((n_streams + 1) * sizeof(size_t));
+    if (!sm->group || !sm->slot || !sm->pos || !sm->starts) {
+        tswHistStreamsFree(sm);
+        return 0;
+    }
+
+    // Groups of the parameter sets (few distinct sets: linear search)
+    for (size_t s = 0; s < n_streams; ++s) {
+        size_t g = 0;
+        while (g < sm->n_groups && (sm->groups[g].n_bins != n_bins[s] || sm->groups[g].win_len != win_len[s]))
+            ++g;
+        if (g == sm->n_groups) {
+            tswHistStreamGroup *groups = (tswHistStreamGroup *)realloc(sm->groups, (g + 1) * sizeof(tswHistStreamGroup));
+            if (!groups) {
+                tswHistStreamsFree(sm);
+                return 0;
+            }
+            sm->groups = groups;
+            memset(&groups[g], 0, sizeof(groups[g]));
+            groups[g].n_bins  = n_bins[s];
+            groups[g].win_len = win_len[s];
+            sm->n_groups++;
+        }
+        sm->group[s] = (uint32_t)g;
+        sm->slot[s]  = (uint32_t)sm->groups[g].n_streams++;
+    }
+
+    // Slabs of each group
+    size_t first = 0;
+    for (size_t g = 0; g < sm->n_groups; ++g) {
+        tswHistStreamGroup *gr = &sm->groups[g];
+        gr->first = first;
+        first += gr->n_streams;
+        gr->ring = (uint16_t *)malloc(gr->win_len * gr->n_streams * sizeof(uint16_t));
+        gr->hist = (uint32_t *)calloc(gr->n_bins * gr->n_streams, sizeof(uint32_t));
+        gr->head = (uint32_t *)calloc(gr->n_streams, sizeof(uint32_t));
+        gr->seen = (uint64_t *)calloc(gr->n_streams, sizeof(uint64_t));
+        if (!gr->ring || !gr->hist || !gr->head || !gr->seen) {
+            tswHistStreamsFree(sm);
+            return 0;
+        }
+    }
+    for (size_t s = 0; s < n_streams; ++s)
+        sm->pos[s] = (uint32_t)(sm->groups[sm->group[s]].first + sm->slot[s]);
+    return 1;
+}
+
+// Pushes the bin of value into the window of stream k of the group, popping
+// the oldest sample once the window is full
+void tswHistStreamPush(tswHistStreamGroup *gr, size_t k, double value) {
+    double bin_d;
+    tswHistBinning(&value, 1, gr->n_bins, &bin_d);
+    uint16_t bin = (bin_d >= 0 && bin_d < (double)gr->n_bins) ? (uint16_t)bin_d : (uint16_t)TSWHIST_STREAMS_MAX_BINS;
+    uint16_t *ring = &gr->ring[k * gr->win_len];
+    uint32_t *hist = &gr->hist[k * gr->n_bins];
+    size_t head = gr->head[k];
+    if (gr->seen[k] >= gr->win_len && ring[head] < gr->n_bins)
+        hist[ring[head]] -= 1;
+    if (bin < gr->n_bins)
+        hist[bin] += 1;
+    ring[head] = bin;
+    gr->head[k] = (uint32_t)((head + 1 == gr->win_len) ? 0 : head + 1);
+    gr->seen[k]++;
+}
+
+// Applies a batch of n updates: sample values[i] (normalized in [0,1]) of
+// stream ids[i] (0-based). The samples of each stream are applied in batch
+// order. Returns 0 (nothing applied) if an id is out of range or on
+// allocation failure.
+int tswHistStreamsUpdate(tswHistStreams *sm, const uint32_t *ids, const double *values, size_t n,
+                         size_t n_threads) {  // 0: OpenMP default
+    for (size_t i = 0; i < n; ++i)
+        if (ids[i] >= sm->n_streams)
+            return 0;
+    if (n > sm->capacity) {
+        double *sorted = (double *)realloc(sm->sorted, n * sizeof(double));
+        if (!sorted)
+            return 0;
+        sm->sorted = sorted;
+        sm->capacity = n;
+    }
+
+    // Stable counting sort of the batch by position of the streams in the slabs
+    size_t *starts = sm->starts;
+    memset(starts, 0, (sm->n_streams + 1) * sizeof(size_t));
+    for (size_t i = 0; i < n; ++i)
+        starts[sm->pos[ids[i]] + 1]++;
+    for (size_t p = 0; p < sm->n_streams; ++p)
+        starts[p + 1] += starts[p];
+    for (size_t i = 0; i < n; ++i)
+        sm->sorted[starts[sm->pos[ids[i]]]++] = values[i];
+    // starts[p] now ends the run of position p: shift back to the run starts
+    memmove(&starts[1], &starts[0], sm->n_streams * sizeof(size_t));
+    starts[0] = 0;
+
+    // Streams in slab order, each by one thread
+    #pragma omp parallel num_threads((int)tswHistNumThreads(n_threads))
+    for (size_t g = 0; g < sm->n_groups; ++g) {
+        tswHistStreamGroup *gr = &sm->groups[g];
+        #pragma omp for schedule(dynamic, TSWHIST_STREAMS_CHUNK)
+        for (long long k = 0; k < (long long)gr->n_streams; ++k) {
+            size_t p = gr->first + (size_t)k;
+            for (size_t j = starts[p]; j < starts[p + 1]; ++j)
+                tswHistStreamPush(gr, (size_t)k, sm->sorted[j]);
+        }
+    }
+    return 1;
+}
+
+// Histogram of the window of stream id into hist ([n_bins] of its group),
+// returns the number of samples of the window (< win_len until it is full)
+size_t tswHistStreamsHist(const tswHistStreams *sm, size_t id, double *hist) {
+    const tswHistStreamGroup *gr = &sm->groups[sm->group[id]];
+    const uint32_t *counts = &gr->hist[(size_t)sm->slot[id] * gr->n_bins];
+    for (size_t b = 0; b < gr->n_bins; ++b)
+        hist[b] = (double)counts[b];
+    uint64_t seen = gr->seen[sm->slot[id]];
+    return (seen < gr->win_len) ? (size_t)seen : gr->win_len;
+}
+
+#endif // TSWHIST_STREAMS_H
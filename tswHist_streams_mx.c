@@ -0,0 +1,161 @@
+/*
+ * tswHist_streams_mx.c - Sliding histograms of many low-rate streams (MEX gateway)
+ *
+ *   Holds a stream manager (see tswHist_streams.h) between calls: the
+ *   sliding histograms of the last win_len samples of each stream, updated
+ *   by batches of (stream id, sample) pairs, e.g. the readings of thousands
+ *   of sensors received since the previous call. The state lives until
+ *   'clear', the next 'init' or the unloading of the MEX file.
+ *
+ *   Usage:
+ *     tswHist_streams_mx('init', n_streams, n_bins, win_len)
+ *     tswHist_streams_mx('update', ids, values)
+ *     tswHist_streams_mx('update', ids, values, n_threads)
+ *     [histMat, n_samples] = tswHist_streams_mx('hist', ids)
+ *     tswHist_streams_mx('clear')
+ *
+ *   Inputs:
+ *     n_streams - Number of streams
+ *     n_bins    - Number of histogram bins (integer > 2 and < 65536), scalar
+ *                 or one per stream
+ *     win_len   - Length of the sliding windows (integer > 0), scalar or one
+ *                 per stream
+ *     ids       - Stream indices (1-based) of the samples, or of the
+ *                 histograms to return (sharing the same n_bins)
+ *     values    - Normalized samples (in [0,1]), applied in order for each
+ *                 stream, samples out of [0,1] or NaN are not counted
+ *     n_threads - (optional) number of OpenMP threads, 0 for the default
+ *                 (default: 0)
+ *
+ *   Outputs:
+ *     histMat   - n_bins x numel(ids) matrix of the current histograms
+ *     n_samples - Number of samples of each window (win_len once full)
+ *
+ *   See also: tswHist_streams.h, tswHist_mx.c
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#include <string.h>
+#include "mex.h"
+#include "tswHist.h"
+#include "tswHist_streams.h"
+
+static tswHistStreams streams;   // persistent stream manager
+static int streams_init = 0;
+
+/* Data pointer of a real double array */
+double *mexDoubles(const mxArray *a) {
+    #if MX_HAS_INTERLEAVED_COMPLEX
+        return mxGetDoubles(a);
+    #else
+        return mxGetPr(a);
+    #endif
+}
+
+static void mexStreamsClear(void) {
+    if (streams_init)
+        tswHistStreamsFree(&streams);
+    streams_init = 0;
+}
+
+/* Per-stream parameter: scalar or one value per stream, integers in [lo, hi] */
+size_t *mexStreamParam(const mxArray *a, size_t n_streams, double lo, double hi, const char *msg) {
+    size_t n = mxGetNumberOfElements(a);
+    if (!mxIsDouble(a) || mxIsComplex(a) || (n != 1 && n != n_streams))
+        mexErrMsgIdAndTxt("tswHist_mx:badParams", msg);
+    const double *v = mexDoubles(a);
+    size_t *param = (size_t *)mxMalloc(n_streams * sizeof(size_t));
+    for (size_t s = 0; s < n_streams; ++s) {
+        double p = v[(n == 1) ? 0 : s];
+        if (!(p >= lo && p <= hi) || p != floor(p))
+            mexErrMsgIdAndTxt("tswHist_mx:badParams", msg);
+        param[s] = (size_t)p;
+    }
+    return param;
+}
+
+/* 0-based stream indices of a vector of 1-based ids */
+uint32_t *mexStreamIds(const mxArray *a) {
+    size_t n = mxGetNumberOfElements(a);
+    if (!mxIsDouble(a) || mxIsComplex(a))
+        mexErrMsgIdAndTxt("tswHist_mx:badIds", "Stream ids must be a real double vector.");
+    const double *v = mexDoubles(a);
+    uint32_t *ids = (uint32_t *)mxMalloc((n > 0 ? n : 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < n; ++i) {
+        if (!(v[i] >= 1 && v[i] <= (double)streams.n_streams) || v[i] != floor(v[i]))
+            mexErrMsgIdAndTxt("tswHist_mx:badIds", "Stream ids must be integers in [1, n_streams].");
+        ids[i] = (uint32_t)(v[i] - 1);
+    }
+    return ids;
+}
+
+/* Gateway function */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+    char cmd[8] = "";
+    if (nrhs < 1 || !mxIsChar(prhs[0]) || mxGetString(prhs[0], cmd, sizeof(cmd)) != 0)
+        mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: tswHist_streams_mx(command, ...) with command 'init', 'update', 'hist' or 'clear'.");
+    mexAtExit(mexStreamsClear);
+
+    if (strcmp(cmd, "clear") == 0) {
+        mexStreamsClear();
+    } else if (strcmp(cmd, "init") == 0) {
+        if (nrhs != 4)
+            mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: tswHist_streams_mx('init', n_streams, n_bins, win_len)");
+        double n_streams = mxGetScalar(prhs[1]);
+        if (!(n_streams >= 1 && n_streams < 4294967296.0) || n_streams != floor(n_streams))
+            mexErrMsgIdAndTxt("tswHist_mx:badParams", "Number of streams must be a positive integer.");
+        size_t *n_bins  = mexStreamParam(prhs[2], (size_t)n_streams, 3, TSWHIST_STREAMS_MAX_BINS,
+                                         "Number of bins must be > 2 and < 65536, scalar or one per stream.");
+        size_t *win_len = mexStreamParam(prhs[3], (size_t)n_streams, 1, 4294967295.0,
+                                         "Window length must be a positive integer, scalar or one per stream.");
+        mexStreamsClear();
+        streams_init = tswHistStreamsInit(&streams, (size_t)n_streams, n_bins, win_len);
+        mxFree(n_bins);
+        mxFree(win_len);
+        if (!streams_init)
+            mexErrMsgIdAndTxt("tswHist_mx:outOfMemory", "Not enough memory for the streams.");
+    } else if (strcmp(cmd, "update") == 0 || strcmp(cmd, "hist") == 0) {
+        if (!streams_init)
+            mexErrMsgIdAndTxt("tswHist_mx:notInitialized", "Streams must be initialized with 'init' first.");
+        int update = (strcmp(cmd, "update") == 0);
+        if (update && (nrhs < 3 || nrhs > 4))
+            mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: tswHist_streams_mx('update', ids, values, n_threads)");
+        if (!update && nrhs != 2)
+            mexErrMsgIdAndTxt("tswHist_mx:invalidNumInputs", "Usage: [histMat, n_samples] = tswHist_streams_mx('hist', ids)");
+        size_t n = mxGetNumberOfElements(prhs[1]);
+        uint32_t *ids = mexStreamIds(prhs[1]);
+        if (update) {
+            if (!mxIsDouble(prhs[2]) || mxIsComplex(prhs[2]) || mxGetNumberOfElements(prhs[2]) != n)
+                mexErrMsgIdAndTxt("tswHist_mx:inputNotReal", "Values must be a real double vector of one value per id.");
+            double n_threads = (nrhs >= 4) ? mxGetScalar(prhs[3]) : 0;
+            if (!(n_threads >= 0) || n_threads != floor(n_threads))
+                mexErrMsgIdAndTxt("tswHist_mx:badThreads", "Number of threads must be a non-negative integer.");
+            if (!tswHistStreamsUpdate(&streams, ids, mexDoubles(prhs[2]), n, (size_t)n_threads))
+                mexErrMsgIdAndTxt("tswHist_mx:outOfMemory", "Not enough memory for the batch.");
+        } else {
+            size_t n_bins = (n > 0) ? streams.groups[streams.group[ids[0]]].n_bins : 0;
+            for (size_t i = 1; i < n; ++i)
+                if (streams.groups[streams.group[ids[i]]].n_bins != n_bins)
+                    mexErrMsgIdAndTxt("tswHist_mx:badIds", "Streams of a 'hist' call must share the same n_bins.");
+            plhs[0] = mxCreateUninitNumericMatrix(n_bins, n, mxDOUBLE_CLASS, mxREAL);
+            double *histMat = mexDoubles(plhs[0]);
+            double *n_samples = (double *)mxMalloc((n > 0 ? n : 1) * sizeof(double));
+            for (size_t i = 0; i < n; ++i)
+                n_samples[i] = (double)tswHistStreamsHist(&streams, ids[i], &histMat[i * n_bins]);
+            if (nlhs >= 2) {
+                plhs[1] = mxCreateUninitNumericMatrix(1, n, mxDOUBLE_CLASS, mxREAL);
+                memcpy(mexDoubles(plhs[1]), n_samples, n * sizeof(double));
+            }
+            mxFree(n_samples);
+        }
+        mxFree(ids);
+    } else {
+        mexErrMsgIdAndTxt("tswHist_mx:badCommand", "Unknown command. Use 'init', 'update', 'hist' or 'clear'.");
+    }
+}
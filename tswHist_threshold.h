@@ -0,0 +1,215 @@
+/*
+ * tswHist_threshold.h - Sliding Otsu / minimum-error thresholds per window
+ *
+ *   Computes, for every window, the threshold splitting the window histogram
+ *   into two classes, either by maximizing the between-class variance (Otsu)
+ *   or by minimizing the Kittler-Illingworth minimum-error criterion. The
+ *   zeroth, first and second moments of the window are kept up to date on
+ *   each push/pop, so each window only needs one pass of cumulative sums over
+ *   the bins of bufferHist, a vectorized pass of split scores and an argmax;
+ *   histMat is never stored.
+ *
+ *   Rows of threshMat: threshold (in the units of edges), weight of the lower
+ *   class, weight of the upper class. The lower class holds the bins
+ *   [0, t] and the threshold is edges[t+1].
+ *
+ *   Optionally every sample is labelled (0: lower class, 1: upper class)
+ *   against the threshold of the window it enters in: the samples of the
+ *   first window use the first threshold, the samples pushed when sliding to
+ *   window w use the threshold of window w, and the trailing samples not
+ *   reached by any push use the last threshold.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_THRESHOLD_H
+#define TSWHIST_THRESHOLD_H
+
+#include "tswHist.h"
+
+typedef enum {
+    TSWHIST_THRESHOLD_OTSU = 0,
+    TSWHIST_THRESHOLD_MINERROR
+} tswHistThresholdMethod;
+
+#define TSWHIST_THRESHOLD_NROWS 3
+
+// Best split bin t (lower class is [0, t]) of a histogram of total count N
+// with first and second moments M1 and M2 (in bin index units). scratch holds
+// 4 * n_bins doubles. The prefix sums are one serial pass, then the scores of
+// all the splits are computed branch-free by one SIMD loop per method, and
+// the (first) best split is found by a last pass.
+size_t tswHistThresholdSweep(
+    const double *hist, size_t n_bins,
+    double N, double M1, double M2,
+    tswHistThresholdMethod method,
+    double *scratch,
+    double *w0_out
+) {
+    size_t n_splits = n_bins - 1;
+    double *W0 = scratch, *Mu0 = scratch + n_bins, *S0 = scratch + 2 * n_bins, *score = scratch + 3 * n_bins;
+    double w0 = 0, m0 = 0, s0 = 0;
+    for (size_t t = 0; t < n_splits; ++t) {
+        double h = hist[t], b = (double)t;
+        W0[t]  = (w0 += h);
+        Mu0[t] = (m0 += b * h);
+        S0[t]  = (s0 += b * b * h);
+    }
+
+    // Scores of all the splits, valid or not: no operation is conditional, so
+    // that the loops are vectorized. The splits with an empty class (whose
+    // scores are Inf or NaN) are skipped by the argmax.
+    if (method == TSWHIST_THRESHOLD_OTSU) {
+        // Between-class variance (up to the constant factor 1/N^2)
+        #pragma omp simd
+        for (size_t t = 0; t < n_splits; ++t) {
+            double d = M1 * W0[t] - N * Mu0[t];
+            score[t] = d * d / (W0[t] * (N - W0[t]));
+        }
+    } else {
+        // Minus the Kittler-Illingworth criterion. Samples are spread
+        // uniformly inside their bin, hence the 1/12 variance floor. The log
+        // calls are only vectorized with a vector math library (e.g. glibc
+        // libmvec, used under -ffast-math).
+        #pragma omp simd
+        for (size_t t = 0; t < n_splits; ++t) {
+            double w0t = W0[t], w1 = N - w0t;
+            double mu0 = Mu0[t] / w0t, mu1 = (M1 - Mu0[t]) / w1;
+            double v0  = S0[t] / w0t - mu0 * mu0 + 1.0 / 12;
+            double v1  = (M2 - S0[t]) / w1 - mu1 * mu1 + 1.0 / 12;
+            double p0  = w0t / N, p1 = w1 / N;
+            score[t]   = -(p0 * log(v0) + p1 * log(v1) - 2 * (p0 * log(p0) + p1 * log(p1)));
+        }
+    }
+
+    size_t best_t = n_bins - 1;
+    double best   = -INFINITY;
+    for (size_t t = 0; t < n_splits; ++t) {
+        if (W0[t] > 0 && W0[t] < N && score[t] > best) {
+            best   = score[t];
+            best_t = t;
+        }
+    }
+    *w0_out = (best == -INFINITY) ? N : W0[best_t]; // no split: the window holds a single class
+    return best_t;
+}
+
+void tswHistThresholdSlidingWindow(
+    double *threshMat,
+    unsigned char *labels,       // [input_len] output, may be NULL
+    double *bufferHist,
+    const double *input_int,
+    size_t num_windows,
+    size_t win_len,
+    size_t n_bins,
+    size_t stride,
+    tswHistThresholdMethod method,
+    const double *edges,
+    size_t input_len
+) {
+    double N = 0, M1 = 0, M2 = 0, w0 = 0;
+    size_t t = 0;
+    double *scratch = (double *)malloc(4 * n_bins * sizeof(double));
+
+    // First window
+    for (size_t i = 0; i < win_len; ++i) {
+        int bin = (int)input_int[i];
+        if (bin >= 0 && bin < (int)n_bins) {
+            bufferHist[bin] += 1;
+            N  += 1;
+            M1 += bin;
+            M2 += (double)bin * bin;
+        }
+    }
+
+    for (size_t w = 0; w < num_windows; ++w) {
+        // Samples entering this window
+        size_t enter_first = 0, enter_last = win_len;
+        if (w > 0) {
+            size_t base_pop  = (w - 1) * stride;
+            size_t base_push = base_pop + win_len;
+            enter_first = base_push;
+            enter_last  = base_push + stride;
+            // pop indices, then push indices (same schedule as tswHistSlidingWindow)
+            for (size_t j = 0; j < stride; ++j) {
+                int bin = (int)input_int[base_pop + j];
+                if (bin >= 0 && bin < (int)n_bins) {
+                    bufferHist[bin] -= 1;
+                    N  -= 1;
+                    M1 -= bin;
+                    M2 -= (double)bin * bin;
+                }
+            }
+            for (size_t j = 0; j < stride; ++j) {
+                int bin = (int)input_int[base_push + j];
+                if (bin >= 0 && bin < (int)n_bins) {
+                    bufferHist[bin] += 1;
+                    N  += 1;
+                    M1 += bin;
+                    M2 += (double)bin * bin;
+                }
+            }
+        }
+
+        // Sweep and store
+        t = tswHistThresholdSweep(bufferHist, n_bins, N, M1, M2, method, scratch, &w0);
+        double *col = &threshMat[w * TSWHIST_THRESHOLD_NROWS];
+        col[0] = edges[t + 1];
+        col[1] = (N > 0) ? w0 / N : NAN;
+        col[2] = (N > 0) ? (N - w0) / N : NAN;
+
+        // Label the samples entering this window
+        if (labels) {
+            for (size_t i = enter_first; i < enter_last; ++i)
+                labels[i] = (input_int[i] > (double)t);
+        }
+    }
+    // Trailing samples not reached by any window
+    if (labels) {
+        for (size_t i = (num_windows - 1) * stride + win_len; i < input_len; ++i)
+            labels[i] = (input_int[i] > (double)t);
+    }
+    free(scratch);
+}
+
+void tswHistThreshold(
+    const double *input_norm, size_t input_len,
+    size_t n_bins, size_t win_len, size_t stride,
+    tswHistThresholdMethod method,
+    double *threshMat,            // [3 x num_windows] output
+    unsigned char *labels,        // [input_len] output, may be NULL
+    double *strided_windows_loci, // [num_windows] output
+    double *edges                 // [n_bins+1] output
+) {
+    size_t num_windows = tswHistNumWindows(input_len, win_len, stride);
+    tswHistLoci(strided_windows_loci, num_windows, stride);
+    tswHistEdges(edges, n_bins);
+
+    double *input_int = (double *)calloc(input_len, sizeof(double));
+    tswHistBinning(input_norm, input_len, n_bins, input_int);
+
+    double *bufferHist = (double *)calloc(n_bins, sizeof(double));
+    tswHistThresholdSlidingWindow(
+        threshMat,
+        labels,
+        bufferHist,
+        input_int,
+        num_windows,
+        win_len,
+        n_bins,
+        stride,
+        method,
+        edges,
+        input_len
+    );
+
+    free(input_int);
+    free(bufferHist);
+}
+
+#endif // TSWHIST_THRESHOLD_H
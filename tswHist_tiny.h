@@ -0,0 +1,164 @@
+/*
+ * tswHist_tiny.h - Exact sliding quantiles of tiny windows from a sorted window
+ *
+ *   Specialization of tswHist_exact.h for short windows (win_len up to
+ *   TSWHIST_TINY_MAX_LEN, e.g. spike-removal median filters), where neither
+ *   the sort of the whole input into ranks nor a histogram over n_bins pays
+ *   off. The window is kept as a small sorted array of raw values, resident
+ *   in L1 (64 doubles at most):
+ *     - with small strides, every popped (resp. pushed) sample is deleted
+ *       (resp. inserted) by a branch-free SIMD count of the smaller values
+ *       giving its position, then a shift of the tail of the array;
+ *     - with strides long enough for the shifts to outweigh a full sort
+ *       (tswHistTinyResort), every window is sorted from scratch by a
+ *       bitonic sorting network padded to a power of two, a fixed sequence
+ *       of compare-exchanges with no data-dependent branch.
+ *
+ *   The quantiles, NaN handling and strided_windows_loci are the same as
+ *   tswHistExact, which dispatches here when tswHistTinySelected.
+ *
+ *   Project: tswHist (https://github.com/cyber-g/tswHist)
+ *   License: GNU General Public License v3.0
+ *
+ *   Author: Germain PHAM
+ *   C2S, Télécom ParisTech, IP Paris
+ *   August 2025; Last revision:
+ */
+
+#ifndef TSWHIST_TINY_H
+#define TSWHIST_TINY_H
+
+#include "tswHist.h"
+
+#define TSWHIST_TINY_MAX_LEN 64
+
+// Whether the sorted-window engine is used instead of the Fenwick tree
+int tswHistTinySelected(size_t win_len) {
+    return win_len <= TSWHIST_TINY_MAX_LEN;
+}
+
+// Size of the sorting network (power of two >= win_len)
+size_t tswHistTinyNetSize(size_t win_len) {
+    size_t net = 1;
+    while (net < win_len)
+        net *= 2;
+    return net;
+}
+
+// Whether each window is sorted from scratch by the network rather than
+// updated by 2 * stride insertions and deletions (shifts of up to win_len
+// values each): the measured crossover is around stride = net / 3
+int tswHistTinyResort(size_t win_len, size_t stride) {
+    return 3 * stride >= tswHistTinyNetSize(win_len);
+}
+
+// Number of values of sorted[0..n) smaller than v
+size_t tswHistTinyRank(const double *sorted, size_t n, double v) {
+    size_t rank = 0;
+    #pragma omp simd reduction(+:rank)
+    for (size_t i = 0; i < n; ++i)
+        rank += (sorted[i] < v);
+    return rank;
+}
+
+void tswHistTinyInsert(double *sorted, size_t *n, double v) {
+    size_t p = tswHistTinyRank(sorted, *n, v);
+    memmove(&sorted[p + 1], &sorted[p], (*n - p) * sizeof(double));
+    sorted[p] = v;
+    (*n)++;
+}
+
+void tswHistTinyDelete(double *sorted, size_t *n, double v) {
+    size_t p = tswHistTinyRank(sorted, *n, v); // first value equal to v
+    memmove(&sorted[p], &sorted[p + 1], (*n - p - 1) * sizeof(double));
+    (*n)--;
+}
+
+// Bitonic sorting network over net (power of two) values without NaN: the
+// compare-exchanges of a stage run over contiguous runs of j values
+void tswHistTinyBitonic(double *a, size_t net) {
+    for (size_t k = 2; k <= net; k <<= 1) {
+        for (size_t j = k >> 1; j > 0; j >>= 1) {
+            for (size_t base = 0; base < net; base += 2 * j) {
+                double *x = &a[base], *y = &a[base + j];
+                if ((base & k) == 0) {
+                    #pragma omp simd
+                    for (size_t i = 0; i < j; ++i) {
+                        double lo = (x[i] < y[i]) ? x[i] : y[i], hi = (x[i] < y[i]) ? y[i] : x[i];
+                        x[i] = lo;
+                        y[i] = hi;
+                    }
+                } else {
+                    #pragma omp simd
+                    for (size_t i = 0; i < j; ++i) {
+                        double lo = (x[i] < y[i]) ? x[i] : y[i], hi = (x[i] < y[i]) ? y[i] : x[i];
+                        x[i] = hi;
+                        y[i] = lo;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Quantile of the n sorted values (same definition as tswHistExact)
+double tswHistTinyQuantile(const double *sorted, size_t n, double prob) {
+    double pos = (double)n * prob + 0.5; // 1-based position in the sorted window
+    if (pos <= 1)
+        return sorted[0];
+    if (pos >= (double)n)
+        return sorted[n - 1];
+    size_t lo = (size_t)floor(pos);
+    double frac = pos - (double)lo;
+    double v_lo = sorted[lo - 1];
+    double v_hi = (frac > 0) ? sorted[lo] : v_lo;
+    return v_lo + frac * (v_hi - v_lo);
+}
+
+void tswHistTinySlidingWindow(
+    double *quantMat,
+    const double *input,
+    size_t num_windows,
+    size_t win_len,
+    size_t stride,
+    const double *probs,
+    size_t n_probs
+) {
+    double sorted[TSWHIST_TINY_MAX_LEN];
+    size_t n = 0, nans = 0;
+    size_t net = tswHistTinyNetSize(win_len);
+    int resort = tswHistTinyResort(win_len, stride);
+
+    for (size_t w = 0; w < num_windows; ++w) {
+        size_t start = w * stride;
+        if (w == 0 || resort) {
+            // Non-NaN values of the window, padded with +Inf, then sorted
+            n = 0;
+            nans = 0;
+            for (size_t i = start; i < start + win_len; ++i) {
+                if (isnan(input[i])) nans++;
+                else sorted[n++] = input[i];
+            }
+            for (size_t i = n; i < net; ++i)
+                sorted[i] = INFINITY;
+            tswHistTinyBitonic(sorted, net);
+        } else {
+            // pop then push (same schedule as tswHistSlidingWindow)
+            size_t base_pop  = start - stride;
+            size_t base_push = base_pop + win_len;
+            for (size_t i = base_pop; i < base_pop + stride; ++i) {
+                if (isnan(input[i])) nans--;
+                else tswHistTinyDelete(sorted, &n, input[i]);
+            }
+            for (size_t i = base_push; i < base_push + stride; ++i) {
+                if (isnan(input[i])) nans++;
+                else tswHistTinyInsert(sorted, &n, input[i]);
+            }
+        }
+
+        for (size_t q = 0; q < n_probs; ++q)
+            quantMat[q + w * n_probs] = (nans > 0 || n == 0) ? NAN : tswHistTinyQuantile(sorted, n, probs[q]);
+    }
+}
+
+#endif // TSWHIST_TINY_H